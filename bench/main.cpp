@@ -0,0 +1,1220 @@
+#include <rlInput/AnalogButtons.hpp>
+#include <rlInput/Gamepad.DirectInput.hpp>
+#include <rlInput/Gamepad.XInput.hpp>
+#include <rlInput/Haptics.hpp>
+#include <rlInput/InputCodec.hpp>
+#include <rlInput/InputContext.hpp>
+#include <rlInput/InputHistory.hpp>
+#include <rlInput/Keyboard.hpp>
+#include <rlInput/Mouse.hpp>
+#include <rlInput/SharedInput.hpp>
+
+// STL
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Microbenchmark of the hot paths (update() per message, prepare() per frame).
+// Every device is fed synthetic input, so no real hardware is required.
+// Writes CSV to stdout: benchmark, parameter, iterations, ns/op, heap allocations/op,
+// allocations/op from the devices' memory resource.
+// Also checks that the steady state doesn't allocate at all and runs a few behavior checks
+// (see SELF-CHECKS): returns 2 if any measured operation allocated or any check failed.
+
+using Clock = std::chrono::steady_clock;
+
+
+
+
+
+//==================================================================================================
+// ALLOCATION COUNTER
+
+namespace
+{
+	std::atomic<size_t> g_iAllocations = 0;
+}
+
+void *operator new(size_t iSize)
+{
+	++g_iAllocations;
+	if (auto p = malloc(iSize ? iSize : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new(size_t iSize, std::align_val_t eAlign)
+{
+	++g_iAllocations;
+	if (auto p = _aligned_malloc(iSize ? iSize : 1, size_t(eAlign)))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+
+
+
+namespace
+{
+
+	// the memory resource all devices are created with
+	class CountingResource final : public std::pmr::memory_resource
+	{
+	public: // methods
+
+		size_t allocations() const noexcept { return m_iAllocations; }
+
+
+	private: // methods
+
+		void *do_allocate(size_t iBytes, size_t iAlignment) override
+		{
+			++m_iAllocations;
+			return std::pmr::new_delete_resource()->allocate(iBytes, iAlignment);
+		}
+
+		void do_deallocate(void *p, size_t iBytes, size_t iAlignment) override
+		{
+			std::pmr::new_delete_resource()->deallocate(p, iBytes, iAlignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource &o) const noexcept override
+		{
+			return this == &o;
+		}
+
+
+	private: // variables
+
+		std::atomic<size_t> m_iAllocations = 0;
+
+	};
+
+	CountingResource g_oResource;
+
+}
+
+
+
+
+
+//==================================================================================================
+// SYNTHETIC DEVICES
+
+namespace
+{
+
+	// a DirectInput device that reports a scripted state
+	class FakeDevice final : public IDirectInputDevice8
+	{
+	public: // methods
+
+		DIJOYSTATE &state() noexcept { return m_oState; }
+
+		// simulates a slow driver: Poll() takes at least this long
+		void setPollDelay(Clock::duration tdDelay) noexcept { m_tdPollDelay = tdDelay; }
+
+		// the count of physical buttons reported; must be set before creating a gamepad
+		void setButtonCount(DWORD iCount) noexcept { m_iButtons = iCount; }
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, LPVOID *ppv) override
+		{
+			*ppv = nullptr;
+			return E_NOINTERFACE;
+		}
+		ULONG STDMETHODCALLTYPE AddRef() override { return ++m_iRefs; }
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			const ULONG iRefs = --m_iRefs;
+			if (iRefs == 0)
+				delete this;
+			return iRefs;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetCapabilities(LPDIDEVCAPS p) override
+		{
+			p->dwFlags   = DIDC_ATTACHED;
+			p->dwDevType = DI8DEVTYPE_GAMEPAD;
+			p->dwAxes    = 6;
+			p->dwButtons = m_iButtons;
+			p->dwPOVs    = 0;
+			return DI_OK;
+		}
+		HRESULT STDMETHODCALLTYPE GetDeviceState(DWORD cbData, LPVOID p) override
+		{
+			if (cbData != sizeof(m_oState))
+				return E_NOTIMPL;
+			memcpy(p, &m_oState, sizeof(m_oState));
+			return DI_OK;
+		}
+		HRESULT STDMETHODCALLTYPE Poll() override
+		{
+			if (m_tdPollDelay.count())
+			{
+				const auto tpEnd = Clock::now() + m_tdPollDelay;
+				while (Clock::now() < tpEnd)
+				{
+				}
+			}
+			return DI_OK;
+		}
+		HRESULT STDMETHODCALLTYPE Acquire() override { return DI_OK; }
+		HRESULT STDMETHODCALLTYPE Unacquire() override { return DI_OK; }
+		HRESULT STDMETHODCALLTYPE SetDataFormat(LPCDIDATAFORMAT) override { return DI_OK; }
+		HRESULT STDMETHODCALLTYPE SetCooperativeLevel(HWND, DWORD) override { return DI_OK; }
+
+		// not used by rlInput
+		HRESULT STDMETHODCALLTYPE EnumObjects(LPDIENUMDEVICEOBJECTSCALLBACKW, LPVOID,
+			DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetProperty(REFGUID, LPDIPROPHEADER) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetProperty(REFGUID, LPCDIPROPHEADER) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetDeviceData(DWORD, LPDIDEVICEOBJECTDATA, LPDWORD,
+			DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetEventNotification(HANDLE) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetObjectInfo(LPDIDEVICEOBJECTINSTANCEW, DWORD,
+			DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetDeviceInfo(LPDIDEVICEINSTANCEW) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE RunControlPanel(HWND, DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE Initialize(HINSTANCE, DWORD, REFGUID) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateEffect(REFGUID, LPCDIEFFECT, LPDIRECTINPUTEFFECT *,
+			LPUNKNOWN) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE EnumEffects(LPDIENUMEFFECTSCALLBACKW, LPVOID, DWORD) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetEffectInfo(LPDIEFFECTINFOW, REFGUID) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetForceFeedbackState(LPDWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SendForceFeedbackCommand(DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE EnumCreatedEffectObjects(LPDIENUMCREATEDEFFECTOBJECTSCALLBACK,
+			LPVOID, DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE Escape(LPDIEFFESCAPE) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SendDeviceData(DWORD, LPCDIDEVICEOBJECTDATA, LPDWORD,
+			DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE EnumEffectsInFile(LPCWSTR, LPDIENUMEFFECTSINFILECALLBACK,
+			LPVOID, DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE WriteEffectToFile(LPCWSTR, DWORD, LPDIFILEEFFECT,
+			DWORD) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE BuildActionMap(LPDIACTIONFORMATW, LPCWSTR, DWORD) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetActionMap(LPDIACTIONFORMATW, LPCWSTR, DWORD) override
+		{ return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetImageInfo(LPDIDEVICEIMAGEINFOHEADERW) override
+		{ return E_NOTIMPL; }
+
+
+	private: // variables
+
+		ULONG m_iRefs = 1;
+		DIJOYSTATE m_oState{};
+		Clock::duration m_tdPollDelay{};
+		DWORD m_iButtons = 32;
+
+	};
+
+
+
+	// the scripted state of all XInput gamepads
+	XINPUT_STATE g_oXInputState{};
+	DWORD g_iXInputPads = 4;
+
+	DWORD WINAPI FakeXInputGetState(DWORD dwUserIndex, XINPUT_STATE *pState)
+	{
+		if (dwUserIndex >= g_iXInputPads)
+			return ERROR_DEVICE_NOT_CONNECTED;
+
+		*pState = g_oXInputState;
+		return ERROR_SUCCESS;
+	}
+
+	// the motor speeds last written to each XInput gamepad
+	XINPUT_VIBRATION g_oXInputVibration[4]{};
+	size_t g_iXInputWrites = 0;
+
+	DWORD WINAPI FakeXInputSetState(DWORD dwUserIndex, XINPUT_VIBRATION *pVibration)
+	{
+		if (dwUserIndex >= g_iXInputPads)
+			return ERROR_DEVICE_NOT_CONNECTED;
+
+		g_oXInputVibration[dwUserIndex] = *pVibration;
+		++g_iXInputWrites;
+		return ERROR_SUCCESS;
+	}
+
+}
+
+
+
+
+
+//==================================================================================================
+// BENCHMARK RUNNER
+
+namespace
+{
+
+	// count of benchmarks whose steady state allocated and of failed checks
+	unsigned g_iFailures = 0;
+
+	// runs fn(i) iIterations times (after a short warm-up) and writes one CSV line
+	template <typename TFn>
+	void run(const char *szName, unsigned iParameter, size_t iIterations, TFn &&fn)
+	{
+		for (size_t i = 0; i < iIterations / 10 + 1; ++i)
+		{
+			fn(i);
+		}
+
+		const size_t iAllocations         = g_iAllocations;
+		const size_t iResourceAllocations = g_oResource.allocations();
+		const auto   tpStart              = Clock::now();
+		for (size_t i = 0; i < iIterations; ++i)
+		{
+			fn(i);
+		}
+		const auto tpEnd = Clock::now();
+
+		const double dNs =
+			(double)std::chrono::duration_cast<std::chrono::nanoseconds>(tpEnd - tpStart).count();
+		const size_t iHeap     = g_iAllocations - iAllocations;
+		const size_t iResource = g_oResource.allocations() - iResourceAllocations;
+		printf("%s,%u,%zu,%.2f,%.4f,%.4f\n", szName, iParameter, iIterations,
+			dNs / iIterations, double(iHeap) / iIterations, double(iResource) / iIterations);
+
+		if (iHeap || iResource)
+		{
+			fprintf(stderr, "%s (%u): steady state allocated (%zu heap, %zu resource)\n",
+				szName, iParameter, iHeap, iResource);
+			++g_iFailures;
+		}
+	}
+
+	constexpr unsigned iACTIVITY[] = { 0, 1, 8, 64 };
+
+
+
+	void benchKeyboard(HWND hWnd)
+	{
+		auto upKeyboard = std::make_unique<rlInput::Keyboard>(&g_oResource);
+		auto &keyboard = *upKeyboard;
+		keyboard.startTextRecording();
+
+		run("keyboard.update", 0, 1'000'000, [&](size_t i)
+			{
+				const WPARAM iKey = 'A' + i % 26;
+				switch (i % 3)
+				{
+				case 0: keyboard.update(hWnd, WM_KEYDOWN, iKey, 0); break;
+				case 1: keyboard.update(hWnd, WM_CHAR, iKey + ('a' - 'A'), 0); break;
+				case 2: keyboard.update(hWnd, WM_KEYUP, iKey, 0); break;
+				}
+			});
+
+		// parameter = key messages per frame
+		unsigned char oPressed[256];
+		for (unsigned iActivity : iACTIVITY)
+		{
+			run("keyboard.frame", iActivity, 100'000, [&](size_t i)
+				{
+					const UINT uMsg = (i & 1) ? WM_KEYUP : WM_KEYDOWN;
+					for (unsigned iEvent = 0; iEvent < iActivity; ++iEvent)
+					{
+						keyboard.update(hWnd, uMsg, 'A' + iEvent % 26, 0);
+					}
+					keyboard.prepare();
+					keyboard.pressedKeys(oPressed, sizeof(oPressed));
+				});
+		}
+	}
+
+	void benchMouse(HWND hWnd)
+	{
+		auto upMouse = std::make_unique<rlInput::Mouse>(&g_oResource);
+		auto &mouse = *upMouse;
+
+		run("mouse.update", 0, 1'000'000, [&](size_t i)
+			{
+				if (i % 8 == 0)
+					mouse.update(hWnd, (i & 8) ? WM_LBUTTONUP : WM_LBUTTONDOWN, 0, 0);
+				else
+					mouse.update(hWnd, WM_MOUSEMOVE, 0, MAKELPARAM(i % 1920, i % 1080));
+			});
+
+		// parameter = mouse messages per frame
+		for (unsigned iActivity : iACTIVITY)
+		{
+			run("mouse.frame", iActivity, 100'000, [&](size_t i)
+				{
+					for (unsigned iEvent = 0; iEvent < iActivity; ++iEvent)
+					{
+						mouse.update(hWnd, WM_MOUSEMOVE, 0,
+							MAKELPARAM((i + iEvent) % 1920, (i + iEvent) % 1080));
+					}
+					if (iActivity)
+						mouse.update(hWnd, (i & 1) ? WM_RBUTTONUP : WM_RBUTTONDOWN, 0, 0);
+					mouse.prepare();
+				});
+		}
+	}
+
+	void benchXInput(HWND hWnd)
+	{
+		auto upXInput = std::make_unique<rlInput::XInput>(&g_oResource);
+		auto &xinput = *upXInput;
+		xinput.setBackend({ FakeXInputGetState, FakeXInputSetState });
+		xinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		// parameter: 0 = idle, 1 = moving thumb sticks, 2 = moving sticks + toggling buttons
+		for (unsigned iActivity = 0; iActivity < 3; ++iActivity)
+		{
+			g_oXInputState = {};
+			run("xinput.frame", iActivity, 100'000, [&](size_t i)
+				{
+					auto &oGamepad = g_oXInputState.Gamepad;
+					if (iActivity >= 1)
+					{
+						oGamepad.sThumbLX = SHORT(i * 97);
+						oGamepad.sThumbLY = SHORT(i * 31);
+						oGamepad.sThumbRX = SHORT(-oGamepad.sThumbLX);
+						oGamepad.bLeftTrigger = BYTE(i);
+						++g_oXInputState.dwPacketNumber;
+					}
+					if (iActivity >= 2)
+						oGamepad.wButtons = WORD(1 << (i % 16)) & ~WORD(0x0C00); // 0x0C00 unused
+
+					xinput.prepare();
+				});
+		}
+	}
+
+	void benchDirectInput(HWND hWnd)
+	{
+		auto upDirectInput = std::make_unique<rlInput::DirectInput>(&g_oResource);
+		auto &dinput = *upDirectInput;
+		dinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		const rlInput::DirectInput::GamepadMeta oMeta{ {}, {}, L"Synthetic", L"Synthetic" };
+
+		std::vector<std::unique_ptr<rlInput::DirectInput::Gamepad>> oGamepads;
+		std::vector<FakeDevice *> oDevices;
+
+		// parameter = gamepad count
+		for (unsigned iCount : { 1u, 2u, 4u, 8u, 16u })
+		{
+			while (oGamepads.size() < iCount)
+			{
+				auto pDevice = new FakeDevice();
+				oDevices.push_back(pDevice);
+				oGamepads.push_back(std::make_unique<rlInput::DirectInput::Gamepad>(
+					pDevice, oMeta, hWnd, dinput));
+			}
+
+			run("dinput.frame", iCount, 100'000, [&](size_t i)
+				{
+					for (auto p : oDevices)
+					{
+						auto &oState = p->state();
+						oState.lX = LONG(i * 97 % 65536);
+						oState.lY = LONG(i * 31 % 65536);
+						memset(oState.rgbButtons, 0, sizeof(oState.rgbButtons));
+						oState.rgbButtons[i % 32] = 0x80;
+					}
+					dinput.prepare();
+				});
+		}
+
+		oGamepads.clear(); // releases the devices
+	}
+
+	void benchDirectInputSlow(HWND hWnd)
+	{
+		auto upDirectInput = std::make_unique<rlInput::DirectInput>(&g_oResource);
+		auto &dinput = *upDirectInput;
+		dinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		const rlInput::DirectInput::GamepadMeta oMeta{ {}, {}, L"Synthetic", L"Synthetic" };
+
+		// 8 devices whose driver needs 50 microseconds per Poll()
+		std::vector<std::unique_ptr<rlInput::DirectInput::Gamepad>> oGamepads;
+		for (unsigned i = 0; i < 8; ++i)
+		{
+			auto pDevice = new FakeDevice();
+			pDevice->setPollDelay(std::chrono::microseconds(50));
+			oGamepads.push_back(std::make_unique<rlInput::DirectInput::Gamepad>(
+				pDevice, oMeta, hWnd, dinput));
+		}
+
+		// parameter = poll threads
+		for (unsigned iThreads : { 1u, 2u, 4u, 8u })
+		{
+			dinput.setPollThreads(iThreads);
+			run("dinput.slow8.frame", iThreads, 2'000, [&](size_t)
+				{
+					dinput.prepare();
+				});
+		}
+
+		dinput.setPollThreads(1);
+		oGamepads.clear(); // releases the devices
+	}
+
+	void benchInputContext(HWND hWnd)
+	{
+		auto upContext = std::make_unique<rlInput::InputContext>(false, &g_oResource);
+		auto &context = *upContext;
+
+		// parameter: 0 = mouse movement, 1 = a message no device processes
+		run("context.update", 0, 1'000'000, [&](size_t i)
+			{
+				context.update(hWnd, WM_MOUSEMOVE, 0, MAKELPARAM(i % 1920, i % 1080));
+			});
+		run("context.update", 1, 1'000'000, [&](size_t)
+			{
+				context.update(hWnd, WM_TIMER, 0, 0);
+			});
+	}
+
+	void benchInputCodec()
+	{
+		rlInput::InputLayout oLayout;
+		oLayout.addKey('W').addKey('A').addKey('S').addKey('D').addKey(VK_SPACE).addKey(VK_SHIFT);
+		oLayout.iMouseButtons   = 0x07;
+		oLayout.iMouseDeltaBits = 12;
+		oLayout.iPads           = 0x01;
+		oLayout.iStickBits      = 10;
+		oLayout.iTriggerBits    = 4;
+		const rlInput::InputCodec oCodec(oLayout);
+
+		rlInput::InputSnapshot oPrevious{};
+		oPrevious.oPads[0].bConnected = true;
+		rlInput::InputSnapshot oCurrent = oPrevious;
+
+		uint8_t oBuffer[64];
+		size_t iSize = 0;
+
+		// parameter: 0 = full snapshot, 1 = relative to the previous frame
+		for (unsigned iDelta = 0; iDelta < 2; ++iDelta)
+		{
+			run("codec.encode", iDelta, 1'000'000, [&](size_t i)
+				{
+					oCurrent.iMouseDeltaX      = int32_t(i % 64) - 32;
+					oCurrent.oPads[0].iLeftX   = int16_t(i * 97);
+					oCurrent.oPads[0].iButtons = uint16_t(i & 0x0100);
+					iSize = oCodec.encode(oCurrent, iDelta ? &oPrevious : nullptr,
+						oBuffer, sizeof(oBuffer));
+				});
+
+			rlInput::InputSnapshot oDecoded;
+			run("codec.decode", iDelta, 1'000'000, [&](size_t)
+				{
+					if (!oCodec.decode(oBuffer, iSize, iDelta ? &oPrevious : nullptr, oDecoded))
+						throw std::exception("InputCodec::decode() failed");
+				});
+		}
+	}
+
+}
+
+
+
+
+
+//==================================================================================================
+// SELF-CHECKS
+
+namespace
+{
+
+	void check(bool bCondition, const char *szDescription)
+	{
+		if (bCondition)
+			return;
+
+		fprintf(stderr, "Check failed: %s\n", szDescription);
+		++g_iFailures;
+	}
+
+
+
+	void checkMemoryResource(HWND hWnd)
+	{
+		CountingResource oResource;
+		auto upDirectInput = std::make_unique<rlInput::DirectInput>(&oResource);
+		auto &dinput = *upDirectInput;
+
+		// longer than the small string buffer
+		constexpr wchar_t szName[] = L"Synthetic gamepad with a name longer than the SSO buffer";
+
+		std::pmr::vector<rlInput::DirectInput::GamepadMeta> oList(&oResource);
+		oList.reserve(2);
+
+		// the resource allocates via operator new --> every heap allocation must be one of its own
+		size_t iHeap     = g_iAllocations;
+		size_t iResource = oResource.allocations();
+		oList.emplace_back(GUID{}, GUID{}, szName, szName);
+		oList.push_back(oList.front());
+		check(oResource.allocations() - iResource == 4 && g_iAllocations - iHeap == 4,
+			"GamepadMeta allocates its names from the resource of its container");
+
+		auto pDevice = new FakeDevice();
+		iHeap     = g_iAllocations;
+		iResource = oResource.allocations();
+		{
+			rlInput::DirectInput::Gamepad oGamepad(pDevice, oList.front(), hWnd, dinput);
+			const size_t iOwn = oResource.allocations() - iResource;
+			check(iOwn > 0 && g_iAllocations - iHeap == iOwn,
+				"DirectInput::Gamepad allocates from the resource of its owner only");
+			check(oGamepad.instanceName() == szName, "DirectInput::Gamepad keeps its name");
+		}
+	}
+
+	void checkMousePath(HWND hWnd)
+	{
+		auto upMouse = std::make_unique<rlInput::Mouse>();
+		auto &mouse = *upMouse;
+
+		// even and odd capacities
+		for (size_t iCapacity : { 4u, 5u, 2u })
+		{
+			mouse.setPathHistory(iCapacity, rlInput::Mouse::PathDecimation::Halve);
+			for (int i = 0; i < 37; ++i)
+			{
+				mouse.update(hWnd, WM_MOUSEMOVE, 0, MAKELPARAM(i, 0));
+			}
+			mouse.prepare();
+
+			const auto oPath = mouse.path();
+			bool bOrdered = true;
+			for (size_t i = 1; i < oPath.size(); ++i)
+			{
+				bOrdered &= oPath[i - 1].iX < oPath[i].iX;
+			}
+			check(!oPath.empty() && oPath.size() <= iCapacity && oPath.front().iX == 0 &&
+				oPath.back().iX == 36 && bOrdered,
+				"Mouse path halving keeps the first and the newest point");
+		}
+	}
+
+	void checkHaptics(HWND hWnd)
+	{
+		g_iXInputPads = 4;
+		rlInput::XInput xinput;
+		xinput.setBackend({ FakeXInputGetState, FakeXInputSetState });
+		xinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		const auto &oVib = g_oXInputVibration[0];
+		{
+			rlInput::HapticsScheduler oScheduler(xinput, false);
+
+			rlInput::HapticEffect oEffect;
+			oEffect.tdSustain = rlInput::HapticEffect::Infinite;
+			oScheduler.play(0, oEffect);
+			auto tp = Clock::now();
+
+			oScheduler.tick(tp);
+			check(oVib.wLeftMotorSpeed == 65535 && oVib.wRightMotorSpeed == 65535,
+				"HapticsScheduler starts the motors");
+
+			const size_t iWrites = g_iXInputWrites;
+			xinput.update(hWnd, WM_KILLFOCUS, 0, 0);
+			check(oVib.wLeftMotorSpeed == 0 && oVib.wRightMotorSpeed == 0,
+				"XInput silences the motors started by a HapticsScheduler when losing the focus");
+			check(g_iXInputWrites == iWrites + 1,
+				"XInput only silences the motors that may be running when losing the focus");
+
+			tp += std::chrono::milliseconds(20);
+			oScheduler.tick(tp);
+			check(oVib.wLeftMotorSpeed == 0 && oVib.wRightMotorSpeed == 0,
+				"HapticsScheduler doesn't drive the motors in the background");
+
+			xinput.update(hWnd, WM_SETFOCUS, 0, 0);
+			tp += std::chrono::milliseconds(20);
+			oScheduler.tick(tp);
+			check(oVib.wLeftMotorSpeed == 65535 && oVib.wRightMotorSpeed == 65535,
+				"HapticsScheduler resumes the effects in the foreground");
+		}
+		check(oVib.wLeftMotorSpeed == 0 && oVib.wRightMotorSpeed == 0,
+			"HapticsScheduler stops the motors when destroyed");
+
+		const size_t iWrites = g_iXInputWrites;
+		xinput.update(hWnd, WM_KILLFOCUS, 0, 0);
+		check(g_iXInputWrites == iWrites,
+			"XInput doesn't write to idle gamepads when losing the focus");
+	}
+
+	void checkInputCodec()
+	{
+		rlInput::InputLayout oLayout;
+		oLayout.addKey('W').addKey('A').addKey(VK_SPACE).addKey(0xFF);
+		oLayout.iMouseButtons   = 0x05;
+		oLayout.iMouseDeltaBits = 8;
+		oLayout.iWheelBits      = 6;
+		oLayout.iPads           = 0x05;
+		oLayout.iPadButtons     = 0x0F0F;
+		oLayout.iStickBits      = 7;
+		oLayout.iTriggerBits    = 3;
+		const rlInput::InputCodec oCodec(oLayout);
+
+		// deterministic pseudo-random snapshots, including out-of-range and unselected values
+		uint64_t iSeed = 0x9E3779B97F4A7C15;
+		const auto fnRandom = [&]
+		{
+			iSeed = iSeed * 6364136223846793005 + 1442695040888963407;
+			return uint32_t(iSeed >> 32);
+		};
+
+		uint8_t oBuffer[256];
+		if (oCodec.maxBytes() > sizeof(oBuffer))
+			throw std::exception("InputCodec::maxBytes() exceeds the buffer");
+
+		bool bRoundTrip = true;
+		bool bRelative  = true;
+		bool bHash      = true;
+		bool bSmall     = true;
+		rlInput::InputSnapshot oReference{};
+		for (unsigned i = 0; i < 1000; ++i)
+		{
+			rlInput::InputSnapshot oSnapshot = oReference;
+			if (i % 4 == 0) // change everything
+			{
+				for (auto &iKeys : oSnapshot.oKeys)
+					iKeys = uint64_t(fnRandom()) << 32 | fnRandom();
+				oSnapshot.iMouseButtons = uint8_t(fnRandom());
+				for (auto &oPad : oSnapshot.oPads)
+				{
+					oPad.bConnected = fnRandom() & 1;
+					oPad.iButtons   = uint16_t(fnRandom());
+				}
+			}
+			oSnapshot.iMouseDeltaX = int32_t(fnRandom()) >> (fnRandom() % 32);
+			oSnapshot.iMouseDeltaY = int32_t(fnRandom()) >> (fnRandom() % 32);
+			oSnapshot.iWheel       = int32_t(fnRandom()) >> (fnRandom() % 32);
+			auto &oPad = oSnapshot.oPads[fnRandom() % 4];
+			oPad.iLeftTrigger = uint8_t(fnRandom());
+			oPad.iLeftX       = int16_t(fnRandom());
+			oPad.iRightY      = int16_t(fnRandom());
+
+			rlInput::InputSnapshot oQuantized = oSnapshot;
+			oCodec.quantize(oQuantized);
+
+			rlInput::InputSnapshot oDecoded;
+			size_t iSize = oCodec.encode(oSnapshot, nullptr, oBuffer, sizeof(oBuffer));
+			bRoundTrip &= iSize > 0 && iSize <= oCodec.maxBytes() &&
+				oCodec.decode(oBuffer, iSize, nullptr, oDecoded) && oDecoded == oQuantized;
+			bSmall &= oCodec.encode(oSnapshot, nullptr, oBuffer, iSize - 1) == 0;
+
+			iSize = oCodec.encode(oSnapshot, &oReference, oBuffer, sizeof(oBuffer));
+			bRelative &= iSize > 0 && iSize <= oCodec.maxBytes() &&
+				oCodec.decode(oBuffer, iSize, &oReference, oDecoded) && oDecoded == oQuantized;
+
+			bHash &= oCodec.hash(oSnapshot) == oCodec.hash(oQuantized);
+
+			oReference = oQuantized;
+		}
+		check(bRoundTrip, "InputCodec: decode(encode(x)) == quantize(x)");
+		check(bRelative, "InputCodec: decode(encode(x, ref), ref) == quantize(x)");
+		check(bSmall, "InputCodec::encode() fails if the buffer is too small");
+		check(bHash, "InputCodec::hash(x) == hash(quantize(x))");
+
+		// the quantization itself
+		rlInput::InputSnapshot oSnapshot{};
+		oSnapshot.iMouseDeltaX = 1000;
+		oSnapshot.iMouseDeltaY = -1000;
+		oSnapshot.oKeys['B' / 64] |= uint64_t(1) << ('B' % 64);
+		oSnapshot.oPads[1].bConnected = true;
+		oCodec.quantize(oSnapshot);
+		check(oSnapshot.iMouseDeltaX == 127 && oSnapshot.iMouseDeltaY == -128,
+			"InputCodec::quantize() clamps the mouse movement");
+		check(oSnapshot == rlInput::InputSnapshot{ .iMouseDeltaX = 127, .iMouseDeltaY = -128 },
+			"InputCodec::quantize() zeroes what isn't transmitted");
+	}
+
+	void checkInputHistory()
+	{
+		using Correction = rlInput::InputHistory::Correction;
+
+		rlInput::InputSnapshot oUp{};
+		rlInput::InputSnapshot oDown{};
+		oDown.oKeys['A' / 64] |= uint64_t(1) << ('A' % 64);
+
+		rlInput::InputHistory oHistory(4);
+		for (auto &o : { oUp, oDown, oDown, oUp })
+		{
+			oHistory.push(o);
+		}
+		check(oHistory.stateAt(1)->key('A').bPressed && oHistory.stateAt(3)->key('A').bReleased,
+			"InputHistory::push() computes the edges");
+
+		// 0: up, 1: down, 2: up, 3: up
+		check(oHistory.correct(2, oUp) == Correction::Changed &&
+			oHistory.stateAt(2)->key('A').bReleased && !oHistory.stateAt(3)->key('A').bReleased,
+			"InputHistory::correct() updates the edges of the frame and the next one");
+		check(oHistory.correct(2, oUp) == Correction::Unchanged,
+			"InputHistory::correct() reports unchanged frames");
+		check(oHistory.correct(4, oUp) == Correction::OutOfRange,
+			"InputHistory::correct() rejects frames not recorded yet");
+
+		// 2: up, 3: up, 4: down, 5: down (frame 1 is the base now)
+		oHistory.push(oDown);
+		oHistory.push(oDown);
+		check(oHistory.correct(1, oUp) == Correction::OutOfRange,
+			"InputHistory::correct() rejects dropped frames");
+		check(oHistory.correct(2, oDown) == Correction::Changed &&
+			!oHistory.stateAt(2)->key('A').bPressed && oHistory.stateAt(3)->key('A').bReleased,
+			"InputHistory::correct() of the oldest frame uses the dropped state");
+		check(oHistory.correct(5, oUp) == Correction::Changed &&
+			oHistory.stateAt(5)->key('A').bReleased,
+			"InputHistory::correct() of the newest frame");
+
+		rlInput::InputHistory oEmpty(4);
+		auto oConsumer = oEmpty.consumer();
+		auto oFrame    = oEmpty.read(oConsumer);
+		check(oFrame.iFrame == rlInput::InputHistory::NoFrame && !oFrame.key('A').bPressed,
+			"InputHistory::read() of an empty history");
+
+		// clear() to a smaller index
+		oConsumer = oHistory.consumer();
+		oHistory.clear(1);
+		oFrame = oHistory.read(oConsumer);
+		check(oFrame.iFrame == rlInput::InputHistory::NoFrame,
+			"InputHistory::read() right after clear()");
+		oHistory.push(oDown);
+		oFrame = oHistory.read(oConsumer);
+		check(oFrame.iFrame == 1 && oFrame.key('A').bPressed && !oFrame.key('A').bReleased,
+			"InputHistory::read() after clear() to a smaller index");
+
+		// a key held across clear() has no edges
+		oHistory.clear(100);
+		oHistory.push(oDown);
+		oFrame = oHistory.read(oConsumer);
+		check(oFrame.iFrame == 100 && oFrame.key('A').bDown && !oFrame.key('A').bPressed &&
+			!oFrame.key('A').bReleased,
+			"InputHistory::read() of a key held across clear()");
+
+		// a key released across clear()
+		oHistory.clear(200);
+		oHistory.push(oUp);
+		oHistory.push(oUp);
+		oFrame = oHistory.read(oConsumer);
+		check(oFrame.iFrame == 201 && !oFrame.key('A').bDown && !oFrame.key('A').bPressed &&
+			oFrame.key('A').bReleased,
+			"InputHistory::read() of a key released across clear()");
+	}
+
+	void checkInputConsumers()
+	{
+		rlInput::InputSnapshot oUp{};
+		oUp.iMouseDeltaX = 2;
+		oUp.iWheel       = -1;
+		rlInput::InputSnapshot oDown = oUp;
+		oDown.oKeys['A' / 64] |= uint64_t(1) << ('A' % 64);
+
+		rlInput::InputHistory oHistory(2);
+		auto oFast = oHistory.consumer();
+		auto oSlow = oHistory.consumer();
+
+		// the fast consumer reads every frame, the slow one after all of them
+		bool bFast = true;
+		size_t iPressed  = 0;
+		size_t iReleased = 0;
+		for (auto &o : { oUp, oDown, oDown, oUp, oUp })
+		{
+			const auto iFrame = oHistory.push(o);
+			const auto oFrame = oHistory.read(oFast);
+			bFast &= oFrame.iFrame == iFrame && oFrame.oState.iMouseDeltaX == 2;
+			iPressed  += oFrame.key('A').bPressed;
+			iReleased += oFrame.key('A').bReleased;
+		}
+		check(bFast && iPressed == 1 && iReleased == 1,
+			"InputHistory consumer reading every frame sees every edge once");
+
+		// frames 0 to 2 were dropped before the slow consumer read them
+		auto oFrame = oHistory.read(oSlow);
+		check(oFrame.iFrame == 4 && oFrame.key('A').bPressed && oFrame.key('A').bReleased &&
+			!oFrame.key('A').bDown,
+			"InputHistory consumer sees the edges of dropped frames");
+		check(oFrame.oState.iMouseDeltaX == 4 && oFrame.oState.iWheel == -2,
+			"InputHistory consumer gets the movement of the frames kept added up");
+
+		oFrame = oHistory.read(oSlow);
+		check(oFrame.iFrame == 4 && !oFrame.key('A').bPressed && !oFrame.key('A').bReleased &&
+			oFrame.oState.iMouseDeltaX == 0,
+			"InputHistory consumer sees nothing new when reading again");
+
+		// without capacity, only the states are compared
+		rlInput::InputHistory oStates;
+		auto oConsumer = oStates.consumer();
+		oStates.push(oDown);
+		oStates.push(oDown);
+		oFrame = oStates.read(oConsumer);
+		check(oFrame.iFrame == 1 && oFrame.key('A').bPressed && oFrame.key('A').bDown,
+			"InputHistory consumer without capacity");
+	}
+
+	void checkAnalogButtons(HWND hWnd)
+	{
+		using namespace rlInput;
+
+		constexpr AnalogThreshold oThreshold = { 0.5f, 0.4f };
+		check(!oThreshold.apply(false, 0.45f) && oThreshold.apply(true, 0.45f) &&
+			!oThreshold.apply(true, 0.35f) && oThreshold.apply(false, 0.5f),
+			"AnalogThreshold: pressed at the press level, released below the release level");
+
+		// the stick at an angle (in degrees, clockwise from up) with full deflection
+		const auto fnStick = [](float fDegrees, uint8_t iDown, StickDirections eDirections)
+		{
+			const float fRadians = fDegrees * 3.14159265f / 180.0f;
+			return StickButtons(std::sin(fRadians), std::cos(fRadians), iDown,
+				{ .eDirections = eDirections });
+		};
+		constexpr auto Four  = StickDirections::Four;
+		constexpr auto Eight = StickDirections::Eight;
+
+		// 4 directions: the sector borders are at 45 degrees, plus 7.5 degrees of hysteresis
+		check(fnStick(40.0f, 0, Four) == STICK_BUTTON_UP &&
+			fnStick(50.0f, 0, Four) == STICK_BUTTON_RIGHT,
+			"StickButtons (4 directions) picks the nearest direction");
+		check(fnStick(50.0f, STICK_BUTTON_UP, Four) == STICK_BUTTON_UP &&
+			fnStick(55.0f, STICK_BUTTON_UP, Four) == STICK_BUTTON_RIGHT,
+			"StickButtons (4 directions) keeps the held direction within the hysteresis");
+
+		// 8 directions: a direction covers 67.5 degrees to each side
+		check(fnStick(45.0f, 0, Eight) == (STICK_BUTTON_UP | STICK_BUTTON_RIGHT),
+			"StickButtons (8 directions) reports diagonals as two directions");
+		check(fnStick(70.0f, 0, Eight) == STICK_BUTTON_RIGHT &&
+			fnStick(70.0f, STICK_BUTTON_UP | STICK_BUTTON_RIGHT, Eight) ==
+				(STICK_BUTTON_UP | STICK_BUTTON_RIGHT),
+			"StickButtons (8 directions) keeps the held direction within the hysteresis");
+
+		// deflection: pressed at 0.5, released below 0.4
+		const StickButtonSettings oSettings;
+		check(StickButtons(0.0f, 0.45f, 0, oSettings) == 0 &&
+			StickButtons(0.0f, 0.45f, STICK_BUTTON_UP, oSettings) == STICK_BUTTON_UP &&
+			StickButtons(0.0f, 0.35f, STICK_BUTTON_UP, oSettings) == 0,
+			"StickButtons applies the deflection threshold");
+
+		// the XInput trigger buttons (pressed at 25%, released below 15%)
+		g_iXInputPads = 4;
+		g_oXInputState = {};
+		XInput xinput;
+		xinput.setBackend({ FakeXInputGetState, FakeXInputSetState });
+		xinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		const auto &oPad = xinput.gamepad(0);
+		bool bTrigger = true;
+		for (auto [iTrigger, bDown] : { std::pair{ 50, false }, { 70, true }, { 50, true },
+			{ 30, false }, { 50, false } })
+		{
+			g_oXInputState.Gamepad.bLeftTrigger = BYTE(iTrigger);
+			++g_oXInputState.dwPacketNumber;
+			xinput.prepare();
+			bTrigger &= oPad.button(XINPUT_BUTTON_LEFT_TRIGGER).bDown == bDown;
+		}
+		check(bTrigger, "XInput trigger buttons have hysteresis");
+
+		g_oXInputState.Gamepad.sThumbLY = 32767;
+		++g_oXInputState.dwPacketNumber;
+		xinput.prepare();
+		check(oPad.button(XINPUT_BUTTON_LEFT_STICK_UP).bPressed &&
+			!oPad.button(XINPUT_BUTTON_LEFT_STICK_RIGHT).bDown,
+			"XInput thumb stick buttons");
+		g_oXInputState = {};
+
+		// the DirectInput axis buttons, indexed like axes()
+		auto upDirectInput = std::make_unique<DirectInput>();
+		auto &dinput = *upDirectInput;
+		dinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		auto pDevice = new FakeDevice();
+		pDevice->setButtonCount(4);
+		const DirectInput::GamepadMeta oMeta{ {}, {}, L"Synthetic", L"Synthetic" };
+		DirectInput::Gamepad oGamepad(pDevice, oMeta, hWnd, dinput);
+
+		const DirectInput::Gamepad::AxisButton oAxisButtons[] =
+		{
+			{ .iAxis = DINPUT_AXIS_Z,  .bPositive = true,  .oThreshold = { 0.5f, 0.4f } },
+			{ .iAxis = DINPUT_AXIS_RZ, .bPositive = false, .oThreshold = { 0.5f, 0.4f } }
+		};
+		oGamepad.setAxisButtons(oAxisButtons);
+
+		auto &oState = pDevice->state();
+		bool bAxes = true;
+		for (auto [fZ, fRz, bZ, bRz] : { std::tuple{ 0.0f, 0.0f, false, false },
+			{ 0.6f, -0.45f, true, false }, { 0.45f, -0.6f, true, true },
+			{ 0.35f, -0.45f, false, true }, { 0.0f, 0.0f, false, false } })
+		{
+			oState.lZ  = LONG(DINPUT_AXISPOS_CENTER + fZ  * DINPUT_AXISPOS_CENTER);
+			oState.lRz = LONG(DINPUT_AXISPOS_CENTER + fRz * DINPUT_AXISPOS_CENTER);
+			dinput.prepare();
+
+			bAxes &= oGamepad.axes()[DINPUT_AXIS_Z] == oState.lZ &&
+				oGamepad.axes()[DINPUT_AXIS_RZ] == oState.lRz &&
+				oGamepad.buttons().size() == 6 &&
+				oGamepad.buttons()[4].bDown == bZ && oGamepad.buttons()[5].bDown == bRz;
+		}
+		check(bAxes, "DirectInput axis buttons have hysteresis and use the axes() indexes");
+	}
+
+	void checkXInputThumbButtons(HWND hWnd)
+	{
+		g_iXInputPads = 4;
+		g_oXInputState = {};
+		rlInput::XInput xinput;
+		xinput.setBackend({ FakeXInputGetState, FakeXInputSetState });
+		xinput.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		auto &oPad = xinput.gamepad(0);
+		unsigned iPressed = 0;
+		oPad.pressedCallbacks().subscribe(rlInput::XINPUT_BUTTON_RIGHT_THUMB,
+			[](void *pContext, unsigned) { ++*static_cast<unsigned *>(pContext); }, &iPressed);
+
+		xinput.prepare();
+		g_oXInputState.Gamepad.wButtons = XINPUT_GAMEPAD_RIGHT_THUMB;
+		++g_oXInputState.dwPacketNumber;
+		xinput.prepare();
+		const auto tpPressed = oPad.prepareTime();
+
+		check(oPad.button(rlInput::XINPUT_BUTTON_RIGHT_THUMB).bPressed &&
+			oPad.rightThumbStick().oButton.bPressed &&
+			!oPad.button(rlInput::XINPUT_BUTTON_LEFT_THUMB).bDown,
+			"XInput thumb stick clicks are buttons");
+		check(iPressed == 1, "XInput thumb stick clicks have callbacks");
+
+		xinput.prepare();
+		check(oPad.pressTime(rlInput::XINPUT_BUTTON_RIGHT_THUMB) == tpPressed &&
+			oPad.heldFor(rlInput::XINPUT_BUTTON_RIGHT_THUMB) == oPad.prepareTime() - tpPressed,
+			"XInput thumb stick clicks have press times");
+
+		g_oXInputState = {};
+	}
+
+	// the values checkSharedInput() publishes for the child process
+	constexpr int32_t iSharedMouseX  = 123;
+	constexpr int32_t iSharedMouseY  = 45;
+	constexpr LONG    iSharedAxisZ   = 1234;
+	constexpr DWORD   iSharedButtons = 0x05; // buttons 0 and 2
+
+	// unique per process, so a running instance of the bench doesn't interfere
+	void sharedInputName(wchar_t(&szName)[64], DWORD dwProcessID)
+	{
+		swprintf_s(szName, L"Local\\rlInput.Bench.%lu", dwProcessID);
+	}
+
+	bool isSharedDirectInputState(const rlInput::SharedInputState &oState)
+	{
+		const auto &oPad = oState.oDirectInputPads[0];
+		return oState.iMouseX == iSharedMouseX && oState.iMouseY == iSharedMouseY &&
+			oState.iDirectInputPads == 1 && oPad.bConnected && oPad.iButtons == iSharedButtons &&
+			oPad.oAxes[rlInput::DINPUT_AXIS_Z] == iSharedAxisZ;
+	}
+
+	// the child process started by runSharedInputReader(): reads what the parent published
+	int readSharedInput(DWORD dwParentID)
+	{
+		wchar_t szName[64];
+		sharedInputName(szName, dwParentID);
+
+		try
+		{
+			const rlInput::InputReader oReader(szName);
+			rlInput::SharedInputState oState{};
+			return oReader.read(oState) && isSharedDirectInputState(oState) ? 0 : 3;
+		}
+		catch (const std::exception &)
+		{
+			return 4;
+		}
+	}
+
+	// starts the bench again with "--read-shared-input <this process' ID>" and returns the exit
+	// code of that process
+	DWORD runSharedInputReader()
+	{
+		wchar_t szPath[MAX_PATH];
+		if (!GetModuleFileNameW(NULL, szPath, MAX_PATH))
+			return DWORD(-1);
+
+		wchar_t szCommandLine[MAX_PATH + 64];
+		swprintf_s(szCommandLine, L"\"%ls\" --read-shared-input %lu", szPath,
+			GetCurrentProcessId());
+
+		STARTUPINFOW si{ .cb = sizeof(si) };
+		PROCESS_INFORMATION pi{};
+		if (!CreateProcessW(szPath, szCommandLine, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
+			return DWORD(-1);
+
+		WaitForSingleObject(pi.hProcess, INFINITE);
+		DWORD dwExitCode = DWORD(-1);
+		GetExitCodeProcess(pi.hProcess, &dwExitCode);
+		CloseHandle(pi.hThread);
+		CloseHandle(pi.hProcess);
+		return dwExitCode;
+	}
+
+	void checkSharedInput(HWND hWnd)
+	{
+		wchar_t szName[64];
+		sharedInputName(szName, GetCurrentProcessId());
+
+		bool bThrown = false;
+		try
+		{
+			rlInput::InputReader oReader(szName);
+		}
+		catch (const std::exception &)
+		{
+			bThrown = true;
+		}
+		check(bThrown, "InputReader throws if there's no publisher");
+
+		rlInput::InputPublisher oPublisher(szName);
+		const rlInput::InputReader oReader(szName);
+
+		rlInput::SharedInputState oState{};
+		check(!oReader.read(oState), "InputReader::read() fails before anything was published");
+
+		oState.iMouseX = 12;
+		oState.iMouseY = -34;
+		oState.oInput.oKeys['A' / 64] |= uint64_t(1) << ('A' % 64);
+		const auto tpBefore = Clock::now();
+		oPublisher.publish(oState);
+
+		rlInput::SharedInputState oRead{};
+		check(oReader.read(oRead) && oRead.iFrame == 1 && oReader.frame() == 1 &&
+			oRead.iMouseX == 12 && oRead.iMouseY == -34 && oRead.oInput == oState.oInput &&
+			oRead.tpPublished >= tpBefore,
+			"InputReader::read() returns the published state");
+
+		// a concurrent publisher: every state has the same value in several fields, so torn
+		// reads would be noticed
+		constexpr int32_t iStates = 200'000;
+		std::thread oThread([&]
+			{
+				for (int32_t i = 1; i <= iStates; ++i)
+				{
+					rlInput::SharedInputState o{};
+					o.iMouseX = o.iMouseY = o.oInput.iMouseDeltaX = o.oInput.iWheel = i;
+					oPublisher.publish(o);
+				}
+			});
+
+		size_t iReads = 0;
+		bool bConsistent = true;
+		bool bOrdered    = true;
+		uint64_t iLastFrame = 0;
+		while (iLastFrame < iStates + 1)
+		{
+			if (!oReader.read(oRead))
+				continue;
+
+			++iReads;
+			if (oRead.iFrame == 1)
+				continue; // still the first state
+
+			const int32_t i = oRead.iMouseX;
+			bConsistent &= oRead.iMouseY == i && oRead.oInput.iMouseDeltaX == i &&
+				oRead.oInput.iWheel == i && oRead.iFrame == uint64_t(i) + 1;
+			bOrdered &= oRead.iFrame >= iLastFrame;
+			iLastFrame = oRead.iFrame;
+		}
+		oThread.join();
+
+		check(iReads > 0 && bConsistent, "InputReader::read() never returns a torn state");
+		check(bOrdered, "InputReader::read() never goes back in time");
+
+		// an InputContext publishes its DirectInput gamepads too
+		auto upContext = std::make_unique<rlInput::InputContext>();
+		auto &context = *upContext;
+		context.update(hWnd, WM_SETFOCUS, 0, 0);
+
+		auto pDevice = new FakeDevice();
+		pDevice->setButtonCount(4);
+		const rlInput::DirectInput::GamepadMeta oMeta{ {}, {}, L"Synthetic", L"Synthetic" };
+		rlInput::DirectInput::Gamepad oGamepad(pDevice, oMeta, hWnd, context.directInput());
+
+		auto &oDeviceState = pDevice->state();
+		oDeviceState.lZ = iSharedAxisZ;
+		for (DWORD i = 0; i < 4; ++i)
+		{
+			oDeviceState.rgbButtons[i] = (iSharedButtons >> i) & 1 ? 0x80 : 0;
+		}
+
+		context.setPublisher(&oPublisher);
+		context.update(hWnd, WM_MOUSEMOVE, 0, MAKELPARAM(iSharedMouseX, iSharedMouseY));
+		context.prepare();
+		context.setPublisher(nullptr);
+
+		check(oReader.read(oRead) && isSharedDirectInputState(oRead),
+			"InputContext publishes the DirectInput gamepads");
+		check(runSharedInputReader() == 0, "InputReader reads the state from another process");
+	}
+
+}
+
+
+
+
+
+int main(int argc, char *argv[])
+{
+	// child process of checkSharedInput()
+	if (argc == 3 && strcmp(argv[1], "--read-shared-input") == 0)
+		return readSharedInput(strtoul(argv[2], nullptr, 10));
+
+	// message-only window; gives the devices a valid (Unicode) window handle
+	HWND hWnd = CreateWindowExW(0, L"STATIC", L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL,
+		GetModuleHandle(NULL), NULL);
+	if (!hWnd)
+	{
+		fprintf(stderr, "CreateWindowExW failed.\n");
+		return 1;
+	}
+
+	printf("benchmark,parameter,iterations,ns_per_op,allocs_per_op,resource_allocs_per_op\n");
+
+	try
+	{
+		checkMemoryResource(hWnd);
+		checkMousePath(hWnd);
+		checkHaptics(hWnd);
+		checkInputCodec();
+		checkInputHistory();
+		checkInputConsumers();
+		checkSharedInput(hWnd);
+		checkAnalogButtons(hWnd);
+		checkXInputThumbButtons(hWnd);
+
+		benchKeyboard(hWnd);
+		benchMouse(hWnd);
+		benchXInput(hWnd);
+		benchDirectInput(hWnd);
+		benchDirectInputSlow(hWnd);
+		benchInputContext(hWnd);
+		benchInputCodec();
+	}
+	catch (const std::exception &e)
+	{
+		fprintf(stderr, "Benchmark failed: %s\n", e.what());
+		DestroyWindow(hWnd);
+		return 1;
+	}
+
+	DestroyWindow(hWnd);
+	return g_iFailures ? 2 : 0;
+}
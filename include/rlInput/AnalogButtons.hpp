@@ -0,0 +1,91 @@
+#pragma once
+#ifndef RLINPUT_ANALOGBUTTONS
+#define RLINPUT_ANALOGBUTTONS
+
+
+
+
+
+// STL
+#include <cstdint>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The levels at which a virtual button derived from an analog value is pressed and released.
+	/// <para/>
+	/// The release level should be below the press level, so the button doesn't chatter while
+	/// the value is noisy around the threshold.
+	/// </summary>
+	struct AnalogThreshold
+	{
+		float fPress   = 0.5f; // the button is pressed once the value reaches this level
+		float fRelease = 0.4f; // the button is released once the value drops below this level
+
+		/// <summary>
+		/// The new state of the button.
+		/// </summary>
+		/// <param name="bDown">Was the button down before?</param>
+		/// <param name="fValue">The analog value, usually between 0 and 1.</param>
+		constexpr bool apply(bool bDown, float fValue) const noexcept
+		{
+			return fValue >= (bDown ? fRelease : fPress);
+		}
+	};
+
+
+
+	/// <summary>
+	/// The directions a thumb stick reports as virtual buttons.
+	/// </summary>
+	enum class StickDirections : uint8_t
+	{
+		Four, // only one direction at a time (e.g. menus)
+		Eight // diagonals report both neighbouring directions (e.g. D-pad emulation)
+	};
+
+	/// <summary>
+	/// The configuration of the virtual direction buttons of a thumb stick.
+	/// </summary>
+	struct StickButtonSettings
+	{
+		StickDirections eDirections = StickDirections::Eight;
+
+		/// <summary>
+		/// The deflection (between 0 and 1) at which a direction is pressed/released.
+		/// </summary>
+		AnalogThreshold oThreshold = { 0.5f, 0.4f };
+
+		/// <summary>
+		/// How far (in degrees) the stick may move past the border of the sector of a held
+		/// direction before the direction changes.
+		/// </summary>
+		float fAngleHysteresis = 7.5f;
+	};
+
+	// the bits returned by StickButtons(), same order as the XInput stick buttons
+	constexpr uint8_t STICK_BUTTON_UP    = 0x01;
+	constexpr uint8_t STICK_BUTTON_DOWN  = 0x02;
+	constexpr uint8_t STICK_BUTTON_LEFT  = 0x04;
+	constexpr uint8_t STICK_BUTTON_RIGHT = 0x08;
+
+	/// <summary>
+	/// Compute the virtual direction buttons of a thumb stick.
+	/// </summary>
+	/// <param name="fX">The horizontal deflection, between -1 (left) and 1 (right).</param>
+	/// <param name="fY">The vertical deflection, between -1 (down) and 1 (up).</param>
+	/// <param name="iDown">The <c>STICK_BUTTON_[...]</c> bits that were down before.</param>
+	/// <returns>The <c>STICK_BUTTON_[...]</c> bits that are down now.</returns>
+	uint8_t StickButtons(float fX, float fY, uint8_t iDown,
+		const StickButtonSettings &oSettings) noexcept;
+
+}
+
+
+
+
+
+#endif // RLINPUT_ANALOGBUTTONS
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+#ifndef RLINPUT_AWAITABLE
+#define RLINPUT_AWAITABLE
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+#include <rlInput/Gamepad.DirectInput.hpp>
+#include <rlInput/Gamepad.XInput.hpp>
+#include <rlInput/Keyboard.hpp>
+#include <rlInput/Mouse.hpp>
+#include <rlInput/WaitList.hpp>
+
+// STL
+#include <coroutine>
+#include <cstddef>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The awaiter for one or more input conditions.<para/>
+	/// Resumes the awaiting coroutine at the end of the first <c>prepare()</c> call that meets
+	/// one of the conditions. <c>co_await</c> yields the index of that condition.
+	/// </summary>
+	template <size_t N>
+	class Awaiter final
+	{
+	public: // methods
+
+		template <typename... T>
+		explicit Awaiter(const T &...oConditions) noexcept :
+			m_oConditions{ oConditions... } {}
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> hCoroutine) noexcept
+		{
+			m_oGroup.hCoroutine   = hCoroutine;
+			m_oGroup.pWaiters     = m_oWaiters;
+			m_oGroup.iWaiterCount = N;
+			m_oGroup.suspend(m_oConditions);
+		}
+
+		size_t await_resume() const noexcept { return m_oGroup.iFired; }
+
+
+	private: // variables
+
+		Condition m_oConditions[N];
+		Waiter    m_oWaiters[N];
+		WaitGroup m_oGroup{};
+
+	};
+
+
+
+	/// <summary>
+	/// Wait for the first of multiple conditions.<para/>
+	/// <c>co_await</c> yields the index of the condition that was met.
+	/// </summary>
+	/// <example>
+	/// <c>if (co_await any_of(pressed(VK_RETURN), timeout(5s)) == 1) { ... }</c>
+	/// </example>
+	template <typename... T>
+	Awaiter<sizeof...(T)> any_of(const T &...oConditions) noexcept
+	{
+		static_assert(sizeof...(T) > 0, "any_of requires at least one condition");
+		return Awaiter<sizeof...(T)>(oConditions...);
+	}
+
+	/// <summary>
+	/// Make a single condition awaitable.
+	/// </summary>
+	inline Awaiter<1> operator co_await(const Condition &oCondition) noexcept
+	{
+		return Awaiter<1>(oCondition);
+	}
+
+
+
+	/// <summary>
+	/// A key of a keyboard was pressed.
+	/// </summary>
+	inline Condition pressed(Keyboard &oKeyboard, unsigned char iVirtualKey) noexcept
+	{
+		return { &oKeyboard.pressedWaitList(iVirtualKey) };
+	}
+
+	/// <summary>
+	/// A key of a keyboard was released.
+	/// </summary>
+	inline Condition released(Keyboard &oKeyboard, unsigned char iVirtualKey) noexcept
+	{
+		return { &oKeyboard.releasedWaitList(iVirtualKey) };
+	}
+
+	/// <summary>
+	/// A key of the default keyboard was pressed.
+	/// </summary>
+	inline Condition pressed(unsigned char iVirtualKey) noexcept
+	{
+		return pressed(Keyboard::Instance(), iVirtualKey);
+	}
+
+	/// <summary>
+	/// A key of the default keyboard was released.
+	/// </summary>
+	inline Condition released(unsigned char iVirtualKey) noexcept
+	{
+		return released(Keyboard::Instance(), iVirtualKey);
+	}
+
+	/// <summary>
+	/// A mouse button was clicked.
+	/// </summary>
+	/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+	inline Condition pressed(Mouse &oMouse, unsigned char iButtonID) noexcept
+	{
+		return { &oMouse.pressedWaitList(iButtonID) };
+	}
+
+	/// <summary>
+	/// A mouse button was released.
+	/// </summary>
+	/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+	inline Condition released(Mouse &oMouse, unsigned char iButtonID) noexcept
+	{
+		return { &oMouse.releasedWaitList(iButtonID) };
+	}
+
+	/// <summary>
+	/// A button of an XInput gamepad was pressed.
+	/// </summary>
+	/// <param name="iButtonID">One of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+	inline Condition pressed(XInput::Gamepad &oGamepad, unsigned char iButtonID) noexcept
+	{
+		return { &oGamepad.pressedWaitList(iButtonID) };
+	}
+
+	/// <summary>
+	/// A button of an XInput gamepad was released.
+	/// </summary>
+	/// <param name="iButtonID">One of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+	inline Condition released(XInput::Gamepad &oGamepad, unsigned char iButtonID) noexcept
+	{
+		return { &oGamepad.releasedWaitList(iButtonID) };
+	}
+
+	/// <summary>
+	/// A button of a DirectInput gamepad was pressed.
+	/// </summary>
+	inline Condition pressed(DirectInput::Gamepad &oGamepad, size_t iButton) noexcept
+	{
+		return { &oGamepad.pressedWaitList(iButton) };
+	}
+
+	/// <summary>
+	/// A button of a DirectInput gamepad was released.
+	/// </summary>
+	inline Condition released(DirectInput::Gamepad &oGamepad, size_t iButton) noexcept
+	{
+		return { &oGamepad.releasedWaitList(iButton) };
+	}
+
+	/// <summary>
+	/// A certain amount of time has passed.<para/>
+	/// Timers are checked by every <c>prepare()</c> call of the thread that awaited them.
+	/// </summary>
+	inline Condition timeout(Clock::duration tDuration) noexcept
+	{
+		return { nullptr, Clock::now() + tDuration };
+	}
+
+}
+
+
+
+
+
+#endif // RLINPUT_AWAITABLE
\ No newline at end of file
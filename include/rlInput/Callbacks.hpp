@@ -0,0 +1,121 @@
+#pragma once
+#ifndef RLINPUT_CALLBACKS
+#define RLINPUT_CALLBACKS
+
+
+
+
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// A flat table of callbacks for a single kind of event (for example "key pressed"), indexed
+	/// by input.<para/>
+	/// Callbacks are plain function pointers with a user-defined context, so dispatching never
+	/// allocates. The callbacks are called from within the <c>prepare()</c> method of the device,
+	/// after the new state was computed, and only for inputs whose state actually changed.
+	/// <para/>
+	/// Callbacks must not (un)subscribe callbacks of the table they were called from.<para/>
+	/// Memory is only allocated by the constructor and <c>subscribe()</c>, from the
+	/// <c>std::pmr::memory_resource</c> passed to the constructor.
+	/// </summary>
+	class CallbackTable final
+	{
+	public: // types
+
+		/// <summary>
+		/// A callback function.
+		/// </summary>
+		/// <param name="pContext">The context pointer passed to <c>subscribe()</c>.</param>
+		/// <param name="iInput">The index of the input whose state changed.</param>
+		using Callback = void(*)(void *pContext, unsigned iInput);
+
+
+	public: // methods
+
+		explicit CallbackTable(unsigned iInputCount,
+			std::pmr::memory_resource *pMemory = std::pmr::get_default_resource());
+
+		/// <summary>
+		/// The count of inputs this table was created for.
+		/// </summary>
+		auto inputCount() const noexcept { return unsigned(m_oOffsets.size() - 1); }
+
+		/// <summary>
+		/// Register a callback for an input.<para/>
+		/// Callbacks of the same input are called in the order they were registered in.
+		/// </summary>
+		void subscribe(unsigned iInput, Callback fnCallback, void *pContext);
+
+		/// <summary>
+		/// Remove a callback that was previously registered via <c>subscribe()</c>.
+		/// </summary>
+		/// <returns>Was the callback registered?</returns>
+		bool unsubscribe(unsigned iInput, Callback fnCallback, void *pContext) noexcept;
+
+		/// <summary>
+		/// Remove all callbacks.
+		/// </summary>
+		void clear() noexcept;
+
+		/// <summary>
+		/// Is there at least one callback registered for an input?
+		/// </summary>
+		bool subscribed(unsigned iInput) const noexcept
+		{
+			return m_oSubscribedMask[iInput / 64] & (uint64_t(1) << (iInput % 64));
+		}
+
+		/// <summary>
+		/// Is there at least one callback registered for any input?
+		/// </summary>
+		bool empty() const noexcept { return m_oEntries.empty(); }
+
+		/// <summary>
+		/// Call all callbacks of a single input.
+		/// </summary>
+		void dispatch(unsigned iInput) const noexcept;
+
+		/// <summary>
+		/// Call the callbacks of all inputs whose bit is set in a mask.
+		/// </summary>
+		/// <param name="pMask">
+		/// A bit mask of the changed inputs, consisting of <c>(inputCount() + 63) / 64</c> words.
+		/// Input <c>i</c> is represented by bit <c>i % 64</c> of word <c>i / 64</c>.
+		/// </param>
+		void dispatchMask(const uint64_t *pMask) const noexcept;
+
+
+	private: // types
+
+		struct Entry
+		{
+			Callback fnCallback;
+			void *pContext;
+		};
+
+
+	private: // variables
+
+		std::pmr::vector<Entry>    m_oEntries;        // sorted by input
+		std::pmr::vector<unsigned> m_oOffsets;        // first entry of each input, plus end
+		std::pmr::vector<uint64_t> m_oSubscribedMask; // one bit per input
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_CALLBACKS
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef RLINPUT_CLOCK
+#define RLINPUT_CLOCK
+
+
+
+
+
+// STL
+#include <chrono>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The monotonic clock used for all timestamps and durations of this library.<para/>
+	/// On MSVC, this is based on <c>QueryPerformanceCounter</c>.
+	/// </summary>
+	using Clock = std::chrono::steady_clock;
+
+}
+
+
+
+
+
+#endif // RLINPUT_CLOCK
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#ifndef RLINPUT_DEVICEMAP
+#define RLINPUT_DEVICEMAP
+
+
+
+
+
+// STL
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Win32
+#define WIN32_MEAN_AND_LEAN
+#define NOMINMAX
+#include <Windows.h>
+#undef WIN32_MEAN_AND_LEAN
+#undef NOMINMAX
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// Is a Raw Input device of a certain type?
+	/// </summary>
+	/// <param name="dwType">One of the <c>RIM_TYPE[...]</c> constants.</param>
+	inline bool IsRawInputDeviceType(HANDLE hDevice, DWORD dwType) noexcept
+	{
+		RID_DEVICE_INFO oInfo{ sizeof(oInfo) };
+		UINT iSize = sizeof(oInfo);
+		return GetRawInputDeviceInfoW(hDevice, RIDI_DEVICEINFO, &oInfo, &iSize) != UINT(-1) &&
+			oInfo.dwType == dwType;
+	}
+
+
+
+	/// <summary>
+	/// Maps device handles (e.g. the <c>hDevice</c> of Raw Input) to consecutive indices.<para/>
+	/// Fixed-size open addressing table: lookups and insertions are O(1) and never allocate.
+	/// Entries are never removed, so an index stays valid for the lifetime of the map.
+	/// </summary>
+	/// <typeparam name="N">The maximum count of devices. At most 255.</typeparam>
+	template <size_t N>
+	class DeviceMap final
+	{
+		static_assert(N > 0 && N < 256, "DeviceMap supports between 1 and 255 devices");
+
+	public: // static variables
+
+		static constexpr size_t Capacity = N;
+		static constexpr size_t NoIndex  = size_t(-1);
+
+
+	public: // methods
+
+		/// <summary>
+		/// The count of devices in the map.
+		/// </summary>
+		size_t size() const noexcept { return m_iCount; }
+
+		/// <summary>
+		/// The handle of the device with a certain index.
+		/// </summary>
+		HANDLE handle(size_t iIndex) const noexcept { return m_oHandles[iIndex]; }
+
+		/// <summary>
+		/// Get the index of a device.
+		/// </summary>
+		/// <returns>The index of the device, or <c>NoIndex</c> if it isn't in the map.</returns>
+		size_t find(HANDLE hDevice) const noexcept
+		{
+			for (size_t iSlot = Hash(hDevice); ; iSlot = (iSlot + 1) % TableSize)
+			{
+				const auto iEntry = m_oSlots[iSlot];
+				if (iEntry == 0)
+					return NoIndex;
+				if (m_oHandles[iEntry - 1] == hDevice)
+					return iEntry - 1;
+			}
+		}
+
+		/// <summary>
+		/// Get the index of a device, adding it to the map if required.
+		/// </summary>
+		/// <returns>The index of the device, or <c>NoIndex</c> if the map is full.</returns>
+		size_t insert(HANDLE hDevice) noexcept
+		{
+			size_t iSlot = Hash(hDevice);
+			for (; m_oSlots[iSlot] != 0; iSlot = (iSlot + 1) % TableSize)
+			{
+				if (m_oHandles[m_oSlots[iSlot] - 1] == hDevice)
+					return m_oSlots[iSlot] - 1;
+			}
+
+			if (m_iCount == N)
+				return NoIndex;
+
+			m_oHandles[m_iCount] = hDevice;
+			m_oSlots[iSlot]      = uint8_t(++m_iCount);
+			return m_iCount - 1;
+		}
+
+		/// <summary>
+		/// Remove all devices.
+		/// </summary>
+		void clear() noexcept
+		{
+			for (auto &i : m_oSlots)
+				i = 0;
+			m_iCount = 0;
+		}
+
+
+	private: // static variables
+
+		// at least half of the slots are always empty --> short probe sequences
+		static constexpr size_t TableSize = std::bit_ceil(2 * N);
+
+
+	private: // static methods
+
+		static size_t Hash(HANDLE hDevice) noexcept
+		{
+			// Fibonacci hashing; the low bits of handles are often zero
+			const auto iValue = uint64_t(reinterpret_cast<uintptr_t>(hDevice));
+			return size_t((iValue * 0x9E3779B97F4A7C15ull) >> 32) % TableSize;
+		}
+
+
+	private: // variables
+
+		uint8_t m_oSlots[TableSize]{}; // index + 1, 0 = empty
+		HANDLE  m_oHandles[N]{};
+		size_t  m_iCount = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_DEVICEMAP
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+#ifndef RLINPUT_FILTERS
+#define RLINPUT_FILTERS
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// A 1&#8364; filter (Casiez et al.) for a single channel.<para/>
+	/// Removes jitter from slowly moving input while keeping the latency of fast movements low.
+	/// </summary>
+	class OneEuroFilter final
+	{
+	public: // types
+
+		struct Settings
+		{
+			/// <summary>
+			/// The cutoff frequency (in Hz) at zero speed.<para/>
+			/// Lower values remove more jitter, but increase the lag of slow movements.
+			/// </summary>
+			float fMinCutoff = 1.0f;
+
+			/// <summary>
+			/// How fast the cutoff frequency increases with speed.<para/>
+			/// Higher values reduce the lag of fast movements.
+			/// </summary>
+			float fBeta = 0.007f;
+
+			/// <summary>
+			/// The cutoff frequency (in Hz) of the speed estimate.
+			/// </summary>
+			float fDerivativeCutoff = 1.0f;
+		};
+
+
+	public: // methods
+
+		const Settings &settings() const noexcept { return m_oSettings; }
+		void setSettings(const Settings &oSettings) noexcept { m_oSettings = oSettings; }
+
+		/// <summary>
+		/// Filter the next sample.
+		/// </summary>
+		/// <param name="fDeltaTime">The time since the previous sample, in seconds.</param>
+		/// <returns>The filtered value.</returns>
+		float filter(float fValue, float fDeltaTime) noexcept;
+
+		/// <summary>
+		/// The last filtered value.
+		/// </summary>
+		float value() const noexcept { return m_fValue; }
+
+		/// <summary>
+		/// Forget the previous samples.
+		/// </summary>
+		void reset() noexcept { m_bInitialized = false; }
+
+
+	private: // variables
+
+		Settings m_oSettings;
+
+		bool  m_bInitialized = false;
+		float m_fValue       = 0.0f;
+		float m_fRawValue    = 0.0f;
+		float m_fDerivative  = 0.0f;
+
+	};
+
+
+
+	/// <summary>
+	/// The method used for predicting future values of a channel.
+	/// </summary>
+	enum class PredictionMode
+	{
+		None,   // The prediction is the last value.
+		Linear, // Extrapolates the velocity of the last two samples.
+		Kalman  // Extrapolates the velocity estimated by a constant-velocity Kalman filter.
+	};
+
+
+
+	/// <summary>
+	/// Predicts the value of a single channel at a (short) time in the future.
+	/// </summary>
+	class MotionPredictor final
+	{
+	public: // types
+
+		struct Settings
+		{
+			PredictionMode eMode = PredictionMode::None;
+
+			/// <summary>
+			/// Kalman only: the variance of the acceleration, in units per second squared.<para/>
+			/// Higher values follow changes of the velocity faster.
+			/// </summary>
+			float fProcessNoise = 10000.0f;
+
+			/// <summary>
+			/// Kalman only: the variance of the measurement, in units squared.
+			/// </summary>
+			float fMeasurementNoise = 1.0f;
+
+			/// <summary>
+			/// The maximum time predictions are extrapolated for.<para/>
+			/// Predictions further into the future are clamped to this horizon.
+			/// </summary>
+			Clock::duration tMaxHorizon = std::chrono::milliseconds(50);
+		};
+
+
+	public: // methods
+
+		const Settings &settings() const noexcept { return m_oSettings; }
+		void setSettings(const Settings &oSettings) noexcept;
+
+		/// <summary>
+		/// Add the next sample.
+		/// </summary>
+		void update(float fValue, Clock::time_point tpTime) noexcept;
+
+		/// <summary>
+		/// Predict the value at a point in time.<para/>
+		/// Points in time before the last sample return the last sample.
+		/// </summary>
+		float predict(Clock::time_point tpTime) const noexcept;
+
+		/// <summary>
+		/// The current velocity estimate, in units per second.
+		/// </summary>
+		float velocity() const noexcept { return m_fVelocity; }
+
+		/// <summary>
+		/// Forget the previous samples.
+		/// </summary>
+		void reset() noexcept;
+
+
+	private: // variables
+
+		Settings m_oSettings;
+
+		bool  m_bInitialized = false;
+		float m_fValue       = 0.0f;
+		float m_fVelocity    = 0.0f;
+		Clock::time_point m_tpLast{};
+
+		// Kalman error covariance
+		float m_fP00 = 0.0f;
+		float m_fP01 = 0.0f;
+		float m_fP11 = 0.0f;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_FILTERS
\ No newline at end of file
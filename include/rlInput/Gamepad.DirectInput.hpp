@@ -6,10 +6,20 @@
 
 
 
+#include <rlInput/AnalogButtons.hpp>
+#include <rlInput/Callbacks.hpp>
+#include <rlInput/Clock.hpp>
+#include <rlInput/InputTimes.hpp>
+#include <rlInput/KeyRepeat.hpp>
+#include <rlInput/SlotMap.hpp>
+#include <rlInput/Stats.hpp>
+#include <rlInput/WaitList.hpp>
+
 // STL
-#include <memory>
-#include <set>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Win32
@@ -25,12 +35,14 @@
 namespace rlInput
 {
 
+	// the indexes of the axes, in the order of DIJOYSTATE
+	// (for DirectInput::Gamepad::axes() and DirectInput::Gamepad::AxisButton::iAxis)
 	constexpr unsigned char DINPUT_AXIS_X  = 0;
 	constexpr unsigned char DINPUT_AXIS_Y  = 1;
-	constexpr unsigned char DINPUT_AXIS_Z  = 1;
-	constexpr unsigned char DINPUT_AXIS_RX = 2;
-	constexpr unsigned char DINPUT_AXIS_RY = 3;
-	constexpr unsigned char DINPUT_AXIS_RZ = 1;
+	constexpr unsigned char DINPUT_AXIS_Z  = 2;
+	constexpr unsigned char DINPUT_AXIS_RX = 3;
+	constexpr unsigned char DINPUT_AXIS_RY = 4;
+	constexpr unsigned char DINPUT_AXIS_RZ = 5;
 
 	constexpr LONG DINPUT_AXISPOS_MIN    = 0;
 	constexpr LONG DINPUT_AXISPOS_CENTER = 32767;
@@ -44,17 +56,56 @@ namespace rlInput
 	{
 	public: // types
 
+		/// <summary>
+		/// The description of an available gamepad (see <c>availableControllers()</c>).<para/>
+		/// Allocator-aware: in a <c>std::pmr</c> container, the names are allocated from the
+		/// container's memory resource.
+		/// </summary>
 		struct GamepadMeta
 		{
-			GUID guidInstance;
-			GUID guidProduct;
+			using allocator_type = std::pmr::polymorphic_allocator<>;
+
+			GUID guidInstance{};
+			GUID guidProduct{};
+
+			std::pmr::wstring sInstanceName;
+			std::pmr::wstring sProductName;
+
+
+			GamepadMeta() = default;
+
+			explicit GamepadMeta(const allocator_type &oAllocator) :
+				sInstanceName(oAllocator), sProductName(oAllocator) {}
+
+			GamepadMeta(const GUID &guidInstance, const GUID &guidProduct,
+				std::wstring_view sInstanceName, std::wstring_view sProductName,
+				const allocator_type &oAllocator = {}) :
+				guidInstance(guidInstance), guidProduct(guidProduct),
+				sInstanceName(sInstanceName, oAllocator), sProductName(sProductName, oAllocator)
+			{}
+
+			GamepadMeta(const GamepadMeta &) = default;
+			GamepadMeta(GamepadMeta &&) = default;
 
-			std::wstring sInstanceName;
-			std::wstring sProductName;
+			GamepadMeta(const GamepadMeta &o, const allocator_type &oAllocator) :
+				guidInstance(o.guidInstance), guidProduct(o.guidProduct),
+				sInstanceName(o.sInstanceName, oAllocator), sProductName(o.sProductName, oAllocator)
+			{}
+
+			GamepadMeta(GamepadMeta &&o, const allocator_type &oAllocator) :
+				guidInstance(o.guidInstance), guidProduct(o.guidProduct),
+				sInstanceName(std::move(o.sInstanceName), oAllocator),
+				sProductName(std::move(o.sProductName), oAllocator)
+			{}
+
+			GamepadMeta &operator=(const GamepadMeta &) = default;
+			GamepadMeta &operator=(GamepadMeta &&) = default;
 		};
 
 		class Gamepad final
 		{
+			friend class DirectInput;
+
 		public: // types
 
 			struct Button
@@ -62,14 +113,60 @@ namespace rlInput
 				bool bPressed;  // Was the key pressed down?
 				bool bDown;     // Is the key currently down?
 				bool bReleased; // Was the key released?
+				bool bRepeated; // Was the key repeated? (see <c>setRepeatSettings()</c>)
 			};
 
 			using Axis = LONG;
 
+			/// <summary>
+			/// A virtual button derived from the deflection of an axis in one direction
+			/// (see <c>setAxisButtons()</c>).
+			/// </summary>
+			struct AxisButton
+			{
+				/// <summary>
+				/// One of the <c>DINPUT_AXIS_[...]</c> constants.
+				/// </summary>
+				unsigned char iAxis;
+
+				/// <summary>
+				/// Does the button react to values above <c>DINPUT_AXISPOS_CENTER</c> (<c>true</c>)
+				/// or below it (<c>false</c>)?
+				/// </summary>
+				bool bPositive;
+
+				/// <summary>
+				/// The deflection from the center (between 0 and 1) at which the button is
+				/// pressed/released.
+				/// </summary>
+				AnalogThreshold oThreshold;
+			};
+
 
 		public: // methods
 
-			Gamepad(const GamepadMeta &oMeta, HWND hWnd);
+			/// <summary>
+			/// Open a gamepad.
+			/// </summary>
+			/// <param name="oOwner">
+			/// The <c>DirectInput</c> instance whose <c>prepare()</c>, <c>update()</c> and
+			/// <c>reset()</c> also affect this gamepad.
+			/// </param>
+			Gamepad(const GamepadMeta &oMeta, HWND hWnd, DirectInput &oOwner = Instance());
+
+			/// <summary>
+			/// Wrap an existing DirectInput device (e.g. a device created by the application or a
+			/// synthetic device for benchmarks).
+			/// </summary>
+			/// <param name="pDevice">
+			/// The device. The gamepad takes over one reference.
+			/// </param>
+			/// <param name="oOwner">
+			/// The <c>DirectInput</c> instance whose <c>prepare()</c>, <c>update()</c> and
+			/// <c>reset()</c> also affect this gamepad.
+			/// </param>
+			Gamepad(IDirectInputDevice8 *pDevice, const GamepadMeta &oMeta, HWND hWnd,
+				DirectInput &oOwner = Instance());
 			~Gamepad();
 
 			/// <summary>
@@ -93,6 +190,13 @@ namespace rlInput
 
 
 
+			/// <summary>
+			/// The handle of the gamepad in its owner (see <c>DirectInput::find()</c>).<para/>
+			/// Stays the same while the gamepad exists, even if the device is disconnected and
+			/// reconnected.
+			/// </summary>
+			DeviceHandle handle() const noexcept { return m_hHandle; }
+
 			/// <summary>
 			/// The instance GUID of the gamepad.
 			/// </summary>
@@ -104,14 +208,18 @@ namespace rlInput
 			const GUID &guidProduct() const noexcept { return m_oGuidProduct; }
 
 			/// <summary>
-			/// The display name of the gamepad.
+			/// The display name of the gamepad.<para/>
+			/// A <c>std::pmr::wstring</c> (allocated from the owner's memory resource), not a
+			/// <c>std::wstring</c>. Copy it via <c>std::wstring_view</c> where a
+			/// <c>std::wstring</c> is required.
 			/// </summary>
-			const std::wstring &instanceName() const noexcept { return m_sInstanceName; }
+			const std::pmr::wstring &instanceName() const noexcept { return m_sInstanceName; }
 
 			/// <summary>
-			/// The display name of the type of gamepad.
+			/// The display name of the type of gamepad.<para/>
+			/// A <c>std::pmr::wstring</c>, like <c>instanceName()</c>.
 			/// </summary>
-			const std::wstring &productName()  const noexcept { return m_sProductName; }
+			const std::pmr::wstring &productName()  const noexcept { return m_sProductName; }
 
 
 			/// <summary>
@@ -120,10 +228,33 @@ namespace rlInput
 			bool connected() const noexcept { return m_bConnected; }
 
 			/// <summary>
-			/// The states of the buttons at the time of the last call to <c>prepare()</c>.
+			/// The states of the buttons at the time of the last call to <c>prepare()</c>.<para/>
+			/// The physical buttons come first, followed by the virtual buttons of the axes (see
+			/// <c>setAxisButtons()</c>).
 			/// </summary>
 			auto &buttons() const noexcept { return m_oButtons; }
 
+			/// <summary>
+			/// The count of physical buttons at the start of <c>buttons()</c>.
+			/// </summary>
+			size_t physicalButtonCount() const noexcept { return m_iPhysicalButtons; }
+
+			/// <summary>
+			/// Replace the virtual buttons derived from the axes.<para/>
+			/// They're evaluated in the same pass as the physical buttons and behave just like them
+			/// (times, repeats, waiters and callbacks), with the index
+			/// <c>physicalButtonCount() + </c> the index in <c>oButtons</c>. Buttons that don't
+			/// fit into the 32 buttons of a gamepad are ignored.<para/>
+			/// Resets the state of the virtual buttons. Allocates; <c>prepare()</c> doesn't.<para/>
+			/// Throws an <c>std::exception</c> if an axis index is out of range.
+			/// </summary>
+			void setAxisButtons(std::span<const AxisButton> oButtons);
+
+			/// <summary>
+			/// The virtual buttons derived from the axes.
+			/// </summary>
+			auto &axisButtons() const noexcept { return m_oAxisButtons; }
+
 			/// <summary>
 			/// The axes count given by the device.<para />
 			/// There's no standard implementation of which axes are active at what count, so the
@@ -139,23 +270,203 @@ namespace rlInput
 			auto &axes() const noexcept { return m_oAxes; }
 
 
+
+			/// <summary>
+			/// The time of the last call to <c>prepare()</c>.<para/>
+			/// All durations are measured relative to this point in time.
+			/// </summary>
+			Clock::time_point prepareTime() const noexcept { return m_tpPrepared; }
+
+			/// <summary>
+			/// The time a button was last pressed, as of the last call to <c>prepare()</c>.
+			/// </summary>
+			Clock::time_point pressTime(size_t iButton) const noexcept
+			{
+				return m_oTimes.pressTime(iButton);
+			}
+
+			/// <summary>
+			/// The time a button was last released, as of the last call to <c>prepare()</c>.
+			/// </summary>
+			Clock::time_point releaseTime(size_t iButton) const noexcept
+			{
+				return m_oTimes.releaseTime(iButton);
+			}
+
+			/// <summary>
+			/// How long a button has been held down at the time of the last call to
+			/// <c>prepare()</c>.<para/>
+			/// Zero if it isn't currently down.
+			/// </summary>
+			Clock::duration heldFor(size_t iButton) const noexcept
+			{
+				return m_oTimes.heldFor(iButton, m_oButtons[iButton].bDown, m_tpPrepared);
+			}
+
+			/// <summary>
+			/// The time between the last press of a button and the last call to <c>prepare()</c>.
+			/// </summary>
+			Clock::duration timeSincePressed(size_t iButton) const noexcept
+			{
+				return m_tpPrepared - m_oTimes.pressTime(iButton);
+			}
+
+			/// <summary>
+			/// The time between the last release of a button and the last call to <c>prepare()</c>.
+			/// </summary>
+			Clock::duration timeSinceReleased(size_t iButton) const noexcept
+			{
+				return m_tpPrepared - m_oTimes.releaseTime(iButton);
+			}
+
+			/// <summary>
+			/// Has a button been held down for at least <c>tThreshold</c> at the time of the last
+			/// call to <c>prepare()</c>?
+			/// </summary>
+			bool longPressed(size_t iButton, Clock::duration tThreshold) const noexcept
+			{
+				return m_oButtons[iButton].bDown && heldFor(iButton) >= tThreshold;
+			}
+
+
+
+			/// <summary>
+			/// The timing of the <c>bRepeated</c> flag of held buttons.
+			/// </summary>
+			const RepeatSettings &repeatSettings() const noexcept { return m_oRepeat.settings(); }
+
+			/// <summary>
+			/// Set the timing of the <c>bRepeated</c> flag of held buttons.
+			/// </summary>
+			void setRepeatSettings(const RepeatSettings &oSettings) noexcept
+			{
+				m_oRepeat.setSettings(oSettings);
+			}
+
+
+
+			/// <summary>
+			/// The list of coroutines waiting for a button to be pressed.<para/>
+			/// Usually accessed via <c>rlInput::pressed()</c> (see <c>Awaitable.hpp</c>).
+			/// </summary>
+			WaitList &pressedWaitList(size_t iButton) noexcept
+			{
+				return m_oPressedWaiters[iButton];
+			}
+
+			/// <summary>
+			/// The list of coroutines waiting for a button to be released.<para/>
+			/// Usually accessed via <c>rlInput::released()</c> (see <c>Awaitable.hpp</c>).
+			/// </summary>
+			WaitList &releasedWaitList(size_t iButton) noexcept
+			{
+				return m_oReleasedWaiters[iButton];
+			}
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when a button was pressed.<para/>
+			/// The input index is the index of the button.
+			/// </summary>
+			CallbackTable &pressedCallbacks() noexcept { return m_oPressedCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when a button was released.<para/>
+			/// The input index is the index of the button.
+			/// </summary>
+			CallbackTable &releasedCallbacks() noexcept { return m_oReleasedCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when the gamepad was (re)connected.<para/>
+			/// There's only a single input (index 0).
+			/// </summary>
+			CallbackTable &connectedCallbacks() noexcept { return m_oConnectedCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when the gamepad was disconnected.<para/>
+			/// There's only a single input (index 0).
+			/// </summary>
+			CallbackTable &disconnectedCallbacks() noexcept { return m_oDisconnectedCallbacks; }
+
+
+
+			/// <summary>
+			/// The instrumentation counters (see <c>RLINPUT_ENABLE_STATS</c>).
+			/// </summary>
+			const DeviceStats &stats() const noexcept { return m_oStats.stats(); }
+
+			void resetStats() noexcept { m_oStats.reset(); }
+
+
+		private: // types
+
+			enum class SampleResult : uint8_t
+			{
+				Inactive, // the owner isn't in the foreground
+				Lost,     // Poll()/Acquire() failed, see m_hrSample
+				NoState,  // GetDeviceState() failed
+				Valid     // m_oSample is valid
+			};
+
+
+		private: // static methods
+
+			static IDirectInputDevice8 *CreateDevice(DirectInput &oOwner, const GamepadMeta &oMeta);
+
+
+		private: // methods
+
+			/// <summary>
+			/// Read the device state (the driver calls of <c>prepare()</c>).<para/>
+			/// Only touches the device and the sample, so the gamepads of an owner can be sampled
+			/// in parallel.
+			/// </summary>
+			void sample() noexcept;
+
+			/// <summary>
+			/// Compute the new state from the last sample, wake waiters and call callbacks.
+			/// </summary>
+			/// <returns>Was the gamepad present?</returns>
+			bool publish() noexcept;
+
+
 		private: // variables
 
 			const GUID m_oGuidInstance;
 			const GUID m_oGuidProduct;
-			const std::wstring m_sInstanceName;
-			const std::wstring m_sProductName;
+			const std::pmr::wstring m_sInstanceName; // allocated from the owner's resource
+			const std::pmr::wstring m_sProductName;
 			const HWND m_hWnd;
 
+			DirectInput *m_pOwner; // nullptr after the owner was destroyed
 			IDirectInputDevice8 *m_pDevice = nullptr;
+			DeviceHandle m_hHandle;
+
+			DIJOYSTATE m_oSample{};
+			SampleResult m_eSample = SampleResult::Inactive;
+			HRESULT m_hrSample = DI_OK;
+			Clock::time_point m_tpSample{};
 
 
 			bool m_bConnected = false;
-			std::unique_ptr<bool[]> m_oRawStates_Old;
-			std::vector<Button> m_oButtons;
+			bool m_oRawStates_Old[32]{};
+			std::pmr::vector<Button> m_oButtons; // at most 32; physical, then axis buttons
+			size_t m_iPhysicalButtons = 0;
+			std::pmr::vector<AxisButton> m_oAxisButtons; // only the ones that fit into m_oButtons
+			InputTimes<32> m_oTimes;
+			Clock::time_point m_tpPrepared{};
+			KeyRepeat m_oRepeat;
+			WaitList m_oPressedWaiters[32];
+			WaitList m_oReleasedWaiters[32];
+
+			CallbackTable m_oPressedCallbacks{ 32, m_pOwner->memoryResource() };
+			CallbackTable m_oReleasedCallbacks{ 32, m_pOwner->memoryResource() };
+			CallbackTable m_oConnectedCallbacks{ 1, m_pOwner->memoryResource() };
+			CallbackTable m_oDisconnectedCallbacks{ 1, m_pOwner->memoryResource() };
 
 			unsigned m_iAxesCount = 0;
-			std::vector<Axis> m_oAxes;
+			std::pmr::vector<Axis> m_oAxes;
+
+			StatsRecorder m_oStats;
 		};
 
 
@@ -170,8 +481,6 @@ namespace rlInput
 	private: // static variables
 
 		static DirectInput s_oInstance;
-		static bool s_bForeground;
-		static bool s_bInstanceValid;
 
 
 
@@ -179,6 +488,22 @@ namespace rlInput
 
 	public: // methods
 
+		/// <summary>
+		/// Create an independent DirectInput instance, e.g. for an <c>InputContext</c>.<para/>
+		/// Most applications only need the default instance (see <c>Instance()</c>).
+		/// </summary>
+		/// <param name="pMemory">
+		/// The memory resource the controller list and the gamepads (names, states, callback
+		/// tables) are allocated from.<para/>
+		/// Only the constructors, <c>updateControllerList()</c> and subscribing callbacks
+		/// allocate; <c>update()</c> and <c>prepare()</c> never do.
+		/// </param>
+		explicit DirectInput(
+			std::pmr::memory_resource *pMemory = std::pmr::get_default_resource());
+		~DirectInput();
+		DirectInput(const DirectInput &) = delete;
+		DirectInput &operator=(const DirectInput &) = delete;
+
 		/// <summary>
 		/// Prepare the internal button infos of all controllers for queries.<para />
 		/// Can be called when an updated state of all the gamepads is required.<para/>
@@ -199,6 +524,23 @@ namespace rlInput
 		/// </summary>
 		void reset() noexcept;
 
+		/// <summary>
+		/// Set the count of threads that poll the devices in <c>prepare()</c>.<para/>
+		/// With more than one thread, <c>prepare()</c> spreads the driver calls (<c>Poll()</c>,
+		/// <c>Acquire()</c>, <c>GetDeviceState()</c>) of all gamepads over <c>iCount - 1</c>
+		/// worker threads and the calling thread, waits for all of them and then updates the
+		/// states, wakes waiters and calls callbacks on the calling thread, in the same order as
+		/// without workers.<para/>
+		/// Worth it for many devices with slow drivers. The default is 1 (no workers).
+		/// </summary>
+		void setPollThreads(unsigned iCount);
+
+		/// <summary>
+		/// The count of threads that poll the devices in <c>prepare()</c> (see
+		/// <c>setPollThreads()</c>).
+		/// </summary>
+		unsigned pollThreads() const noexcept;
+
 
 
 
@@ -209,19 +551,80 @@ namespace rlInput
 
 		bool isXInput(const GUID &guidProduct) const noexcept;
 
+		/// <summary>
+		/// The memory resource passed to the constructor.
+		/// </summary>
+		std::pmr::memory_resource *memoryResource() const noexcept { return m_pMemory; }
 
-	private: // methods
 
-		DirectInput(); // --> singleton
-		~DirectInput();
+
+		/// <summary>
+		/// All existing gamepads of this instance, contiguously.<para/>
+		/// The order changes when gamepads are destroyed.
+		/// </summary>
+		std::span<Gamepad *const> gamepads() const noexcept { return m_oGamepads.values(); }
+
+		/// <summary>
+		/// Get a gamepad via its handle (see <c>Gamepad::handle()</c>). O(1).
+		/// </summary>
+		/// <returns>
+		/// The gamepad, or <c>nullptr</c> if it was destroyed in the meantime.
+		/// </returns>
+		Gamepad *find(DeviceHandle hGamepad) noexcept
+		{
+			auto pp = m_oGamepads.find(hGamepad);
+			return pp ? *pp : nullptr;
+		}
+
+		const Gamepad *find(DeviceHandle hGamepad) const noexcept
+		{
+			auto pp = m_oGamepads.find(hGamepad);
+			return pp ? *pp : nullptr;
+		}
+
+		/// <summary>
+		/// Get the handle of the gamepad of a certain device.
+		/// </summary>
+		/// <returns>
+		/// The handle, or an invalid handle if there's no <c>Gamepad</c> for the device.
+		/// </returns>
+		DeviceHandle find(const GUID &guidInstance) const noexcept;
+
+
+
+		/// <summary>
+		/// The instrumentation counters of <c>update()</c> (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// <para/>
+		/// The gamepads have their own counters.
+		/// </summary>
+		const DeviceStats &stats() const noexcept { return m_oStats.stats(); }
+
+		/// <summary>
+		/// The time between sampling gamepad input and the end of the <c>prepare()</c> call that
+		/// surfaced it, for all gamepads (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// </summary>
+		const LatencyHistogram &latency() const noexcept { return m_oStats.latency(); }
+
+		void resetStats() noexcept { m_oStats.reset(); }
+
+
+	private: // types
+
+		class PollWorkers; // see setPollThreads()
 
 
 	private: // variables
 
-		std::vector<GamepadMeta> m_oAvailableControllers;
+		std::pmr::memory_resource *const m_pMemory; // must be declared first
+
+		std::pmr::vector<GamepadMeta> m_oAvailableControllers{ m_pMemory };
 		IDirectInput8 *m_pDirectInput = nullptr;
 
-		std::set<Gamepad *> m_oGamepadInstances;
+		bool m_bForeground = false;
+		SlotMap<Gamepad *> m_oGamepads{ m_pMemory };
+		PollWorkers *m_pWorkers = nullptr; // allocated from m_pMemory
+
+		StatsRecorder m_oStats;
 
 	};
 
@@ -6,6 +6,21 @@
 
 
 
+#include <rlInput/AnalogButtons.hpp>
+#include <rlInput/Callbacks.hpp>
+#include <rlInput/Clock.hpp>
+#include <rlInput/Filters.hpp>
+#include <rlInput/InputTimes.hpp>
+#include <rlInput/KeyRepeat.hpp>
+#include <rlInput/SlotMap.hpp>
+#include <rlInput/Stats.hpp>
+#include <rlInput/WaitList.hpp>
+
+// STL
+#include <atomic>
+#include <memory_resource>
+#include <mutex>
+
 // Win32
 #define WIN32_MEAN_AND_LEAN
 #define NOMINMAX
@@ -32,12 +47,41 @@ namespace rlInput
 	constexpr unsigned char XINPUT_BUTTON_X              = 10;
 	constexpr unsigned char XINPUT_BUTTON_Y              = 11;
 
+	// virtual buttons derived from the analog inputs (see Gamepad::setVirtualButtonSettings())
+	constexpr unsigned char XINPUT_BUTTON_LEFT_STICK_UP     = 12;
+	constexpr unsigned char XINPUT_BUTTON_LEFT_STICK_DOWN   = 13;
+	constexpr unsigned char XINPUT_BUTTON_LEFT_STICK_LEFT   = 14;
+	constexpr unsigned char XINPUT_BUTTON_LEFT_STICK_RIGHT  = 15;
+	constexpr unsigned char XINPUT_BUTTON_RIGHT_STICK_UP    = 16;
+	constexpr unsigned char XINPUT_BUTTON_RIGHT_STICK_DOWN  = 17;
+	constexpr unsigned char XINPUT_BUTTON_RIGHT_STICK_LEFT  = 18;
+	constexpr unsigned char XINPUT_BUTTON_RIGHT_STICK_RIGHT = 19;
+	constexpr unsigned char XINPUT_BUTTON_LEFT_TRIGGER      = 20;
+	constexpr unsigned char XINPUT_BUTTON_RIGHT_TRIGGER     = 21;
+
+	// the clicks of the thumb sticks (also see Gamepad::ThumbStick::oButton)
+	constexpr unsigned char XINPUT_BUTTON_LEFT_THUMB  = 22;
+	constexpr unsigned char XINPUT_BUTTON_RIGHT_THUMB = 23;
+
 
 
 	class XInput
 	{
+		friend class HapticsScheduler; // writes the motors, see m_oMotorMutex
+
 	public: // types
 
+		/// <summary>
+		/// The functions used for accessing the controllers.<para/>
+		/// Can be replaced (see <c>setBackend()</c>), e.g. to feed synthetic input for benchmarks
+		/// or tests.
+		/// </summary>
+		struct Backend
+		{
+			DWORD (WINAPI *pfnGetState)(DWORD dwUserIndex, XINPUT_STATE *pState);
+			DWORD (WINAPI *pfnSetState)(DWORD dwUserIndex, XINPUT_VIBRATION *pVibration);
+		};
+
 		class Gamepad
 		{
 			friend class XInput;
@@ -52,6 +96,7 @@ namespace rlInput
 				bool bPressed;  // Was the key pressed down?
 				bool bDown;     // Is the key currently down?
 				bool bReleased; // Was the key released?
+				bool bRepeated; // Was the key repeated? (see <c>setRepeatSettings()</c>)
 			};
 
 			/// <summary>
@@ -68,13 +113,31 @@ namespace rlInput
 			/// </summary>
 			struct ThumbStick
 			{
-				SimpleButton oButton;
+				SimpleButton oButton; // also XINPUT_BUTTON_LEFT_THUMB/XINPUT_BUTTON_RIGHT_THUMB
 
 				SHORT iX;
 				SHORT iY;
 
 				bool bXOutsideDeadzone;
 				bool bYOutsideDeadzone;
+
+				float fFilteredX; // iX after the smoothing filter (see setThumbStickFilter())
+				float fFilteredY; // iY after the smoothing filter (see setThumbStickFilter())
+			};
+
+			/// <summary>
+			/// The configuration of the virtual buttons (<c>XINPUT_BUTTON_LEFT_STICK_UP</c> to
+			/// <c>XINPUT_BUTTON_RIGHT_TRIGGER</c>).
+			/// </summary>
+			struct VirtualButtonSettings
+			{
+				StickButtonSettings oSticks; // both thumb sticks
+
+				/// <summary>
+				/// The trigger positions (between 0 and 1) at which the trigger buttons are
+				/// pressed/released.
+				/// </summary>
+				AnalogThreshold oTriggers = { 0.25f, 0.15f };
 			};
 
 
@@ -99,6 +162,12 @@ namespace rlInput
 			/// </summary>
 			bool connected() const noexcept { return m_bConnected; }
 
+			/// <summary>
+			/// The handle of the gamepad in its owner (see <c>XInput::find()</c>).<para/>
+			/// XInput gamepads are never destroyed, so the handle of a slot never changes.
+			/// </summary>
+			DeviceHandle handle() const noexcept { return { m_iID, 1 }; }
+
 
 
 			/// <summary>
@@ -108,9 +177,83 @@ namespace rlInput
 			
 			/// <summary>
 			/// Get the state of a specific button at the time of the last call to <c>prepare()</c>.
+			/// <para/>
+			/// Includes the virtual buttons of the thumb sticks and triggers, which are evaluated
+			/// in the same pass as the physical buttons (see <c>setVirtualButtonSettings()</c>),
+			/// and the thumb stick clicks.
 			/// </summary>
 			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
-			auto &button(unsigned char iButtonID) const noexcept { return m_oButtons[iButtonID]; }
+			auto &button(unsigned char iButtonID) const noexcept
+			{
+				return iButtonID < XINPUT_BUTTON_LEFT_THUMB ? m_oButtons[iButtonID] :
+					m_oThumbSticks[iButtonID - XINPUT_BUTTON_LEFT_THUMB].oButton;
+			}
+
+
+
+			/// <summary>
+			/// The time of the last call to <c>prepare()</c>.<para/>
+			/// All durations are measured relative to this point in time.
+			/// </summary>
+			Clock::time_point prepareTime() const noexcept { return m_tpPrepared; }
+
+			/// <summary>
+			/// The time a button was last pressed, as of the last call to <c>prepare()</c>.
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			Clock::time_point pressTime(unsigned char iButtonID) const noexcept
+			{
+				return m_oTimes.pressTime(iButtonID);
+			}
+
+			/// <summary>
+			/// The time a button was last released, as of the last call to <c>prepare()</c>.
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			Clock::time_point releaseTime(unsigned char iButtonID) const noexcept
+			{
+				return m_oTimes.releaseTime(iButtonID);
+			}
+
+			/// <summary>
+			/// How long a button has been held down at the time of the last call to
+			/// <c>prepare()</c>.<para/>
+			/// Zero if it isn't currently down.
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			Clock::duration heldFor(unsigned char iButtonID) const noexcept
+			{
+				return m_oTimes.heldFor(iButtonID, button(iButtonID).bDown, m_tpPrepared);
+			}
+
+			/// <summary>
+			/// The time between the last press of a button and the last call to <c>prepare()</c>.
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			Clock::duration timeSincePressed(unsigned char iButtonID) const noexcept
+			{
+				return m_tpPrepared - m_oTimes.pressTime(iButtonID);
+			}
+
+			/// <summary>
+			/// The time between the last release of a button and the last call to <c>prepare()</c>.
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			Clock::duration timeSinceReleased(unsigned char iButtonID) const noexcept
+			{
+				return m_tpPrepared - m_oTimes.releaseTime(iButtonID);
+			}
+
+			/// <summary>
+			/// Has a button been held down for at least <c>tThreshold</c> at the time of the last
+			/// call to <c>prepare()</c>?
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			bool longPressed(unsigned char iButtonID, Clock::duration tThreshold) const noexcept
+			{
+				return button(iButtonID).bDown && heldFor(iButtonID) >= tThreshold;
+			}
+
 
 
 			/// <summary>
@@ -141,7 +284,64 @@ namespace rlInput
 
 
 			/// <summary>
-			/// Set the vibration effect.
+			/// The timing of the <c>bRepeated</c> flag of held buttons.
+			/// </summary>
+			const RepeatSettings &repeatSettings() const noexcept { return m_oRepeat.settings(); }
+
+			/// <summary>
+			/// Set the timing of the <c>bRepeated</c> flag of held buttons.
+			/// </summary>
+			void setRepeatSettings(const RepeatSettings &oSettings) noexcept
+			{
+				m_oRepeat.setSettings(oSettings);
+			}
+
+
+
+			/// <summary>
+			/// The configuration of the virtual buttons.
+			/// </summary>
+			const VirtualButtonSettings &virtualButtonSettings() const noexcept
+			{
+				return m_oVirtualSettings;
+			}
+
+			/// <summary>
+			/// Change the configuration of the virtual buttons.<para/>
+			/// Takes effect with the next input of the gamepad; the buttons keep their state until
+			/// then.
+			/// </summary>
+			void setVirtualButtonSettings(const VirtualButtonSettings &oSettings) noexcept
+			{
+				m_oVirtualSettings = oSettings;
+			}
+
+
+
+			/// <summary>
+			/// Enable or disable the smoothing of a thumb stick's <c>fFilteredX</c> and
+			/// <c>fFilteredY</c> values.<para/>
+			/// If disabled, they're equal to <c>iX</c> and <c>iY</c>.
+			/// </summary>
+			/// <param name="iStick">0 for the left and 1 for the right thumb stick.</param>
+			void setThumbStickFilter(unsigned iStick, bool bEnabled,
+				const OneEuroFilter::Settings &oSettings = {}) noexcept;
+
+			/// <summary>
+			/// Is the smoothing of a thumb stick enabled?
+			/// </summary>
+			/// <param name="iStick">0 for the left and 1 for the right thumb stick.</param>
+			bool thumbStickFilterEnabled(unsigned iStick) const noexcept
+			{
+				return m_bStickFilterEnabled[iStick];
+			}
+
+
+
+			/// <summary>
+			/// Set the vibration effect.<para/>
+			/// Nothing is sent to the gamepad if the speeds are the ones last applied, so this can
+			/// be called every frame. For timed effects, see <c>HapticsScheduler</c>.
 			/// </summary>
 			/// <param name="iLeftVibration">
 			/// The speed of the left (low frequency) vibration motor.<para />
@@ -166,28 +366,131 @@ namespace rlInput
 			auto rightVibration() const noexcept { return m_iRightVibration; }
 
 
+
+			/// <summary>
+			/// The list of coroutines waiting for a button to be pressed.<para/>
+			/// Usually accessed via <c>rlInput::pressed()</c> (see <c>Awaitable.hpp</c>).
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			WaitList &pressedWaitList(unsigned char iButtonID) noexcept
+			{
+				return m_oPressedWaiters[iButtonID];
+			}
+
+			/// <summary>
+			/// The list of coroutines waiting for a button to be released.<para/>
+			/// Usually accessed via <c>rlInput::released()</c> (see <c>Awaitable.hpp</c>).
+			/// </summary>
+			/// <param name="iButtonID">one of the <c>XINPUT_BUTTON_[...]</c> constants.</param>
+			WaitList &releasedWaitList(unsigned char iButtonID) noexcept
+			{
+				return m_oReleasedWaiters[iButtonID];
+			}
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when a button was pressed.<para/>
+			/// The input index is one of the <c>XINPUT_BUTTON_[...]</c> constants.
+			/// </summary>
+			CallbackTable &pressedCallbacks() noexcept { return m_oPressedCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when a button was released.<para/>
+			/// The input index is one of the <c>XINPUT_BUTTON_[...]</c> constants.
+			/// </summary>
+			CallbackTable &releasedCallbacks() noexcept { return m_oReleasedCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when a thumb stick left its deadzone.
+			/// <para/>
+			/// The input index is 0 for the left and 1 for the right thumb stick.
+			/// </summary>
+			CallbackTable &deadzoneCallbacks() noexcept { return m_oDeadzoneCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when the gamepad was connected.<para/>
+			/// There's only a single input (index 0).
+			/// </summary>
+			CallbackTable &connectedCallbacks() noexcept { return m_oConnectedCallbacks; }
+
+			/// <summary>
+			/// The callbacks called by <c>prepare()</c> when the gamepad was disconnected.<para/>
+			/// There's only a single input (index 0).
+			/// </summary>
+			CallbackTable &disconnectedCallbacks() noexcept { return m_oDisconnectedCallbacks; }
+
+
+
+			/// <summary>
+			/// The instrumentation counters (see <c>RLINPUT_ENABLE_STATS</c>).<para/>
+			/// <c>iPollFailures</c> doesn't include polls of an empty slot.
+			/// </summary>
+			const DeviceStats &stats() const noexcept { return m_oStats.stats(); }
+
+			void resetStats() noexcept { m_oStats.reset(); }
+
+
 		private: // methods
 
-			Gamepad(unsigned iID); // --> singleton
+			Gamepad(unsigned iID, XInput &oOwner); // --> owned by XInput
 			~Gamepad() = default;
 
+			/// <summary>
+			/// Set the <c>bRepeated</c> flags of all buttons according to <c>m_oRepeat</c>.
+			/// </summary>
+			void applyRepeats() noexcept;
+
+			/// <summary>
+			/// Set the <c>fFilteredX</c> and <c>fFilteredY</c> values of both thumb sticks.
+			/// </summary>
+			void applyFilters() noexcept;
+
+			/// <summary>
+			/// Stop the motors, even if they're known to be off (they might have been started by
+			/// a <c>HapticsScheduler</c>, which doesn't go through <c>setVibration()</c>).
+			/// </summary>
+			void silence() noexcept;
+
 
 		private: // variables
 
 			const unsigned m_iID;
+			XInput &m_oOwner;
 
 			bool m_bConnected = false;
+			bool m_bEverConnected = false; // for counting reconnects
 
 			XINPUT_STATE m_oRawState_Old{};
 			XINPUT_STATE m_oRawState_New{};
 
-			SimpleButton  m_oButtons[12];
-			ThumbStick    m_oThumbSticks[2];
-			TriggerButton m_oTriggerButtons[2];
+			SimpleButton  m_oButtons[22]{}; // physical, then virtual buttons
+			ThumbStick    m_oThumbSticks[2]{};
+			TriggerButton m_oTriggerButtons[2]{};
+
+			InputTimes<24> m_oTimes;
+			Clock::time_point m_tpPrepared{};
+			Clock::time_point m_tpFiltered{}; // time of the last sample passed to the filters
+
+			bool m_bStickFilterEnabled[2]{};
+			OneEuroFilter m_oStickFilters[2][2]; // [stick][axis]
+
+			VirtualButtonSettings m_oVirtualSettings;
+
+			KeyRepeat m_oRepeat; // indexed by the XINPUT_BUTTON_[...] constants
+
+			WaitList m_oPressedWaiters[24];
+			WaitList m_oReleasedWaiters[24];
+
+			CallbackTable m_oPressedCallbacks{ 24, m_oOwner.memoryResource() };
+			CallbackTable m_oReleasedCallbacks{ 24, m_oOwner.memoryResource() };
+			CallbackTable m_oDeadzoneCallbacks{ 2, m_oOwner.memoryResource() };
+			CallbackTable m_oConnectedCallbacks{ 1, m_oOwner.memoryResource() };
+			CallbackTable m_oDisconnectedCallbacks{ 1, m_oOwner.memoryResource() };
 
 			WORD m_iLeftVibration  = 0;
 			WORD m_iRightVibration = 0;
 
+			StatsRecorder m_oStats;
+
 		};
 
 		using iterator               = Gamepad *;
@@ -208,7 +511,6 @@ namespace rlInput
 	private: // static variables
 
 		static XInput s_oInstance;
-		static bool s_bForeground;
 
 
 
@@ -216,6 +518,22 @@ namespace rlInput
 
 	public: // methods
 
+		/// <summary>
+		/// Create an independent set of gamepad states, e.g. for an <c>InputContext</c>.<para/>
+		/// Most applications only need the default instance (see <c>Instance()</c>).
+		/// </summary>
+		/// <param name="pMemory">
+		/// The memory resource the callback tables of the gamepads are allocated from.<para/>
+		/// Only the constructor and subscribing callbacks allocate; <c>update()</c> and
+		/// <c>prepare()</c> never do.
+		/// </param>
+		explicit XInput(std::pmr::memory_resource *pMemory = std::pmr::get_default_resource()) :
+			m_pMemory(pMemory)
+		{}
+		~XInput() = default;
+		XInput(const XInput &) = delete;
+		XInput &operator=(const XInput &) = delete;
+
 		iterator begin() noexcept { return m_oGamepads; }
 		iterator end()   noexcept { return m_oGamepads + 4; }
 
@@ -237,6 +555,21 @@ namespace rlInput
 		const Gamepad &gamepad(unsigned ID) const { return m_oGamepads[ID]; }
 		Gamepad       &gamepad(unsigned ID)       { return m_oGamepads[ID]; }
 
+		/// <summary>
+		/// Get a gamepad via its handle (see <c>Gamepad::handle()</c>).
+		/// </summary>
+		/// <returns>The gamepad, or <c>nullptr</c> if the handle is invalid.</returns>
+		Gamepad *find(DeviceHandle hGamepad) noexcept
+		{
+			return hGamepad.iIndex < 4 && hGamepad.iGeneration == 1 ?
+				&m_oGamepads[hGamepad.iIndex] : nullptr;
+		}
+
+		const Gamepad *find(DeviceHandle hGamepad) const noexcept
+		{
+			return const_cast<XInput *>(this)->find(hGamepad);
+		}
+
 
 
 
@@ -260,11 +593,70 @@ namespace rlInput
 		/// </summary>
 		void reset() noexcept;
 
+		/// <summary>
+		/// Does the window passed to <c>update()</c> have the focus?<para/>
+		/// Gamepad input is only read and vibration (see <c>HapticsScheduler</c>) is only played
+		/// while it has. Can be called from any thread.
+		/// </summary>
+		bool foreground() const noexcept { return m_bForeground; }
+
+
+
+		/// <summary>
+		/// The functions used for accessing the controllers.
+		/// </summary>
+		const Backend &backend() const noexcept { return m_oBackend; }
+
+		/// <summary>
+		/// Replace the functions used for accessing the controllers.<para/>
+		/// The default are <c>XInputGetState</c> and <c>XInputSetState</c>.
+		/// </summary>
+		void setBackend(const Backend &oBackend) noexcept { m_oBackend = oBackend; }
+
+		/// <summary>
+		/// The memory resource passed to the constructor.
+		/// </summary>
+		std::pmr::memory_resource *memoryResource() const noexcept { return m_pMemory; }
+
+
+
+		/// <summary>
+		/// The instrumentation counters of <c>update()</c> (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// <para/>
+		/// The gamepads have their own counters.
+		/// </summary>
+		const DeviceStats &stats() const noexcept { return m_oStats.stats(); }
+
+		/// <summary>
+		/// The time between sampling gamepad input and the end of the <c>prepare()</c> call that
+		/// surfaced it, for all gamepads (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// </summary>
+		const LatencyHistogram &latency() const noexcept { return m_oStats.latency(); }
+
+		void resetStats() noexcept { m_oStats.reset(); }
+
 
 
 	private: // variables
 
-		Gamepad m_oGamepads[4]{ 0, 1, 2, 3 };
+		std::pmr::memory_resource *const m_pMemory; // must be declared before m_oGamepads
+
+		std::atomic<bool> m_bForeground = false; // also read by HapticsScheduler threads
+
+		// held while HapticsScheduler writes the motors and while the focus is lost, so the
+		// scheduler can't start the motors again after they were silenced
+		std::mutex m_oMotorMutex;
+		uint8_t m_iScheduledMotors = 0; // bit = ID of a gamepad a scheduler set to nonzero speeds
+		Backend m_oBackend = { XInputGetState, XInputSetState };
+		Gamepad m_oGamepads[4]
+		{
+			{ 0, *this },
+			{ 1, *this },
+			{ 2, *this },
+			{ 3, *this }
+		};
+
+		StatsRecorder m_oStats;
 
 	};
 
@@ -0,0 +1,129 @@
+#pragma once
+#ifndef RLINPUT_GESTURES
+#define RLINPUT_GESTURES
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The thresholds used for recognizing mouse gestures.
+	/// </summary>
+	struct GestureSettings
+	{
+		/// <summary>
+		/// The distance (in pixels) the cursor must move while a button is held before a drag
+		/// starts.
+		/// </summary>
+		int iDragThreshold = 4;
+
+		/// <summary>
+		/// The time a button must be held without dragging to be recognized as press-and-hold.
+		/// </summary>
+		Clock::duration tHoldDelay = std::chrono::milliseconds(500);
+
+		/// <summary>
+		/// The minimum speed (in pixels per second) at the time of release for a flick.
+		/// </summary>
+		double dFlickSpeed = 1000.0;
+
+		/// <summary>
+		/// The time constant of the velocity smoothing.<para/>
+		/// Higher values make the velocity estimate steadier, but slower to react.
+		/// </summary>
+		Clock::duration tVelocitySmoothing = std::chrono::milliseconds(30);
+	};
+
+
+
+	/// <summary>
+	/// The gestures of a single mouse button, as recognized by the last call to
+	/// <c>Mouse::prepare()</c>.
+	/// </summary>
+	struct Gesture
+	{
+		bool bDragStarted; // Did the cursor just exceed the drag threshold?
+		bool bDragging;    // Is the button being dragged?
+		bool bDragEnded;   // Was the button released after dragging?
+		bool bHeld;        // Was the button just held long enough without dragging?
+		bool bFlicked;     // Was the button released while moving fast?
+
+		int iStartX; // Horizontal client position at the time the button was pressed
+		int iStartY; // Vertical client position at the time the button was pressed
+		int iDeltaX; // Horizontal offset from the start position
+		int iDeltaY; // Vertical offset from the start position
+
+		double dVelocityX; // Smoothed horizontal cursor velocity, in pixels per second
+		double dVelocityY; // Smoothed vertical cursor velocity, in pixels per second
+	};
+
+
+
+	/// <summary>
+	/// Recognizes drags, flicks and press-and-hold of a single mouse button.<para/>
+	/// Updated once per frame in O(1).
+	/// </summary>
+	class GestureRecognizer final
+	{
+	public: // methods
+
+		const GestureSettings &settings() const noexcept { return m_oSettings; }
+		void setSettings(const GestureSettings &oSettings) noexcept { m_oSettings = oSettings; }
+
+		/// <summary>
+		/// The gestures recognized by the last call to <c>advance()</c>.
+		/// </summary>
+		const Gesture &state() const noexcept { return m_oState; }
+
+		/// <summary>
+		/// Advance the recognizer by one frame.
+		/// </summary>
+		void advance(bool bPressed, bool bDown, bool bReleased, int iX, int iY,
+			Clock::time_point tpNow) noexcept;
+
+		/// <summary>
+		/// Cancel the current gesture.
+		/// </summary>
+		void reset() noexcept;
+
+
+	private: // types
+
+		enum class Phase
+		{
+			Idle,
+			Pressed,
+			Dragging
+		};
+
+
+	private: // variables
+
+		GestureSettings m_oSettings;
+		Gesture m_oState{};
+
+		Phase m_ePhase = Phase::Idle;
+		bool  m_bHoldRecognized = false;
+		Clock::time_point m_tpPressed{};
+
+		bool m_bHasLast = false;
+		int  m_iLastX   = 0;
+		int  m_iLastY   = 0;
+		Clock::time_point m_tpLast{};
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_GESTURES
\ No newline at end of file
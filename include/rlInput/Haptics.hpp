@@ -0,0 +1,235 @@
+#pragma once
+#ifndef RLINPUT_HAPTICS
+#define RLINPUT_HAPTICS
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+#include <rlInput/Gamepad.XInput.hpp>
+
+// STL
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Win32
+#define WIN32_MEAN_AND_LEAN
+#define NOMINMAX
+#include <Windows.h>
+#undef WIN32_MEAN_AND_LEAN
+#undef NOMINMAX
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// A vibration effect (see <c>HapticsScheduler::play()</c>).<para/>
+	/// The strength of both motors follows an envelope: it rises linearly during
+	/// <c>tdAttack</c>, is held during <c>tdSustain</c> and falls linearly during
+	/// <c>tdRelease</c>. Optionally, the motors are switched on and off periodically (pulses).
+	/// </summary>
+	struct HapticEffect
+	{
+		/// <summary>
+		/// A <c>tdSustain</c> that never ends. The effect runs until it's stopped.
+		/// </summary>
+		static constexpr Clock::duration Infinite = Clock::duration::max();
+
+		float fLowFrequency  = 1.0f; // strength of the left (low frequency) motor, 0 to 1
+		float fHighFrequency = 1.0f; // strength of the right (high frequency) motor, 0 to 1
+
+		Clock::duration tdAttack{};
+		Clock::duration tdSustain{};
+		Clock::duration tdRelease{};
+
+		Clock::duration tdPulsePeriod{}; // zero = no pulses
+		float fPulseDuty = 0.5f;         // the fraction of a pulse period the motors are on
+	};
+
+
+
+	/// <summary>
+	/// Plays <c>HapticEffect</c>s on XInput gamepads.<para/>
+	/// The effects of a gamepad are layered: the strengths of all of its effects are added up per
+	/// motor (at most 1). A background thread computes the motor speeds and writes them to the
+	/// gamepads, but only if they changed, and not more often than set via
+	/// <c>Settings::tdMinWriteInterval</c>. The thread sleeps while no effect is playing.<para/>
+	/// The motors are only driven while the <c>XInput</c> instance is in the foreground (see
+	/// <c>XInput::foreground()</c>); effects keep running in the background, but silently.<para/>
+	/// Writes go through <c>XInput::backend()</c>, so a mock backend can be used for testing
+	/// (optionally without the thread, by calling <c>tick()</c> manually).<para/>
+	/// Don't call <c>XInput::Gamepad::setVibration()</c> for gamepads the scheduler plays effects
+	/// on.
+	/// </summary>
+	class HapticsScheduler final
+	{
+	public: // types
+
+		/// <summary>
+		/// Identifies a playing effect. Never 0.
+		/// </summary>
+		using EffectID = uint64_t;
+
+		struct Settings
+		{
+			Clock::duration tdTick = std::chrono::milliseconds(4); // time between two updates
+			Clock::duration tdMinWriteInterval = std::chrono::milliseconds(10); // per gamepad
+		};
+
+
+	public: // static variables
+
+		/// <summary>
+		/// The maximum count of effects playing on one gamepad at the same time.
+		/// </summary>
+		static constexpr size_t MaxEffects = 16;
+
+
+	public: // methods
+
+		/// <param name="bThread">
+		/// Should a background thread update the motors? If not, <c>tick()</c> must be called
+		/// regularly.
+		/// </param>
+		explicit HapticsScheduler(XInput &oXInput = XInput::Instance(), bool bThread = true);
+
+		/// <summary>
+		/// Stops all effects and the motors.
+		/// </summary>
+		~HapticsScheduler();
+
+		HapticsScheduler(const HapticsScheduler &) = delete;
+		HapticsScheduler &operator=(const HapticsScheduler &) = delete;
+
+		/// <summary>
+		/// Start playing an effect. Never allocates.
+		/// </summary>
+		/// <param name="iGamepad">The index of the XInput gamepad, between 0 and 3.</param>
+		/// <returns>
+		/// The ID of the effect, or 0 if <c>MaxEffects</c> effects are already playing on the
+		/// gamepad.
+		/// </returns>
+		EffectID play(unsigned iGamepad, const HapticEffect &oEffect) noexcept;
+
+		/// <summary>
+		/// Stop an effect immediately.
+		/// </summary>
+		/// <returns>Was the effect still playing?</returns>
+		bool stop(EffectID iEffect) noexcept;
+
+		/// <summary>
+		/// Stop all effects of a gamepad.
+		/// </summary>
+		void stopAll(unsigned iGamepad) noexcept;
+
+		/// <summary>
+		/// Stop all effects of all gamepads.
+		/// </summary>
+		void stopAll() noexcept;
+
+		/// <summary>
+		/// Is an effect still playing?
+		/// </summary>
+		bool playing(EffectID iEffect) const noexcept;
+
+		const Settings &settings() const noexcept { return m_oSettings; }
+		void setSettings(const Settings &oSettings) noexcept;
+
+		/// <summary>
+		/// Update the motors: remove finished effects, mix the others and write the motor speeds
+		/// that changed (and may be written again).<para/>
+		/// Called by the background thread. Only call it manually if the scheduler was created
+		/// without a thread.
+		/// </summary>
+		void tick(Clock::time_point tpNow = Clock::now()) noexcept;
+
+		/// <summary>
+		/// The speed of the left (low frequency) motor that was last written to a gamepad.
+		/// </summary>
+		WORD leftMotor(unsigned iGamepad) const noexcept;
+
+		/// <summary>
+		/// The speed of the right (high frequency) motor that was last written to a gamepad.
+		/// </summary>
+		WORD rightMotor(unsigned iGamepad) const noexcept;
+
+		/// <summary>
+		/// The count of calls to <c>XInput::Backend::pfnSetState</c> so far.
+		/// </summary>
+		uint64_t writeCount() const noexcept;
+
+
+	private: // types
+
+		struct Effect
+		{
+			HapticEffect oEffect;
+			EffectID iID;
+			Clock::time_point tpStart;
+		};
+
+		struct Pad
+		{
+			Effect oEffects[MaxEffects];
+			size_t iEffectCount = 0;
+
+			WORD iLeft  = 0; // last written (a gamepad is assumed to be silent initially)
+			WORD iRight = 0;
+			Clock::time_point tpLastWrite{};
+		};
+
+
+	private: // static methods
+
+		/// <summary>
+		/// The strength of an effect at a point in time.
+		/// </summary>
+		/// <returns>Between 0 and 1, or a negative value if the effect has ended.</returns>
+		static float Envelope(const Effect &oEffect, Clock::time_point tpNow) noexcept;
+
+
+	private: // methods
+
+		/// <returns>
+		/// Is anything left to do (effects playing or motor speeds not written yet)?
+		/// </returns>
+		bool update(Clock::time_point tpNow) noexcept;
+
+		/// <summary>
+		/// Write motor speeds to a gamepad, unless they're nonzero and the <c>XInput</c> instance
+		/// isn't in the foreground (anymore).
+		/// </summary>
+		void write(unsigned iGamepad, XINPUT_VIBRATION &oVibration) noexcept;
+
+		void threadProc() noexcept;
+
+
+	private: // variables
+
+		XInput &m_oXInput;
+
+		mutable std::mutex m_oMutex; // everything below
+		std::condition_variable m_oCondition;
+		Settings m_oSettings;
+		Pad m_oPads[4];
+		EffectID m_iNextID = 1;
+		uint64_t m_iWrites = 0;
+		bool m_bWake = false; // set by all changes, wakes the thread
+		bool m_bStop = false;
+
+		std::thread m_oThread;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_HAPTICS
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+#ifndef RLINPUT_INPUTCODEC
+#define RLINPUT_INPUTCODEC
+
+
+
+
+
+#include <rlInput/Gamepad.XInput.hpp>
+#include <rlInput/Keyboard.hpp>
+#include <rlInput/Mouse.hpp>
+
+// STL
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The input of one frame, in a fixed-size form that can be compared, hashed and sent over
+	/// the network (see <c>InputCodec</c>).
+	/// </summary>
+	struct InputSnapshot
+	{
+		struct Pad
+		{
+			bool     bConnected;
+			uint16_t iButtons;      // bit = one of the XINPUT_BUTTON_[...] constants (0 to 11)
+			uint8_t  iLeftTrigger;
+			uint8_t  iRightTrigger;
+			int16_t  iLeftX;
+			int16_t  iLeftY;
+			int16_t  iRightX;
+			int16_t  iRightY;
+
+			friend bool operator==(const Pad &, const Pad &) noexcept = default;
+		};
+
+		uint64_t oKeys[4];      // the keys that are down; bit = virtual key code
+		uint8_t  iMouseButtons; // bit = one of the MOUSE_BUTTON_[...] constants
+		int32_t  iMouseDeltaX;  // raw movement (see Mouse::deltaX()), rounded
+		int32_t  iMouseDeltaY;  // raw movement (see Mouse::deltaY()), rounded
+		int32_t  iWheel;        // see Mouse::weelRotation()
+		Pad      oPads[4];      // index = XInput gamepad ID
+
+		/// <summary>
+		/// Read the state of the devices at the time of their last call to <c>prepare()</c>.
+		/// <para/>
+		/// Devices that are <c>nullptr</c> are left zeroed.
+		/// </summary>
+		static InputSnapshot Capture(const Keyboard *pKeyboard, const Mouse *pMouse,
+			const XInput *pXInput) noexcept;
+
+		friend bool operator==(const InputSnapshot &, const InputSnapshot &) noexcept = default;
+	};
+
+
+
+	/// <summary>
+	/// Selects the parts of an <c>InputSnapshot</c> an <c>InputCodec</c> transmits, and their
+	/// precision.
+	/// </summary>
+	struct InputLayout
+	{
+		uint64_t oKeys[4]{};          // the keys to transmit; bit = virtual key code
+		uint8_t  iMouseButtons   = 0; // the mouse buttons to transmit
+		uint8_t  iMouseDeltaBits = 0; // bits per mouse axis, 0 (none) to 32; signed, clamped
+		uint8_t  iWheelBits      = 0; // bits of the wheel rotation, 0 (none) to 32; signed, clamped
+
+		uint8_t  iPads        = 0;      // the XInput gamepads to transmit; bit = gamepad ID
+		uint16_t iPadButtons  = 0x0FFF; // the gamepad buttons to transmit
+		uint8_t  iStickBits   = 0;      // bits per thumb stick axis, 0 (none) to 16
+		uint8_t  iTriggerBits = 0;      // bits per trigger, 0 (none) to 8
+
+		/// <summary>
+		/// Select a key.
+		/// </summary>
+		constexpr InputLayout &addKey(unsigned char iKey) noexcept
+		{
+			oKeys[iKey / 64] |= uint64_t(1) << (iKey % 64);
+			return *this;
+		}
+	};
+
+
+
+	/// <summary>
+	/// Packs <c>InputSnapshot</c>s into a compact bitstream, e.g. for rollback or lockstep
+	/// netcode.<para/>
+	/// Only the parts selected by the <c>InputLayout</c> are transmitted, at the precision it
+	/// specifies. A snapshot can be encoded on its own or relative to a reference (usually the
+	/// previous frame), which only transmits the groups of values that changed.<para/>
+	/// Never allocates.<para/>
+	/// Decoded snapshots are quantized. To keep simulations deterministic, the local input
+	/// must be passed through <c>quantize()</c> as well.
+	/// </summary>
+	class InputCodec final
+	{
+	public: // methods
+
+		/// <summary>
+		/// Out-of-range bit counts in the layout are clamped.
+		/// </summary>
+		explicit InputCodec(const InputLayout &oLayout) noexcept;
+
+		const InputLayout &layout() const noexcept { return m_oLayout; }
+
+		/// <summary>
+		/// The maximum size of an encoded snapshot, in bytes.
+		/// </summary>
+		size_t maxBytes() const noexcept { return m_iMaxBytes; }
+
+		/// <summary>
+		/// Reduce a snapshot to what the layout transmits: unselected parts are zeroed, values
+		/// are clamped and rounded to the transmitted precision.<para/>
+		/// <c>decode(encode(x)) == quantize(x)</c>.
+		/// </summary>
+		void quantize(InputSnapshot &oSnapshot) const noexcept;
+
+		/// <summary>
+		/// Encode a snapshot.
+		/// </summary>
+		/// <param name="pReference">
+		/// The snapshot to encode relative to, or <c>nullptr</c>. The decoder must use the same
+		/// reference.
+		/// </param>
+		/// <returns>
+		/// The count of bytes written, or 0 if <c>iDestSize</c> was too small (never the case
+		/// with <c>maxBytes()</c>).
+		/// </returns>
+		size_t encode(const InputSnapshot &oSnapshot, const InputSnapshot *pReference,
+			uint8_t *pDest, size_t iDestSize) const noexcept;
+
+		/// <summary>
+		/// Decode a snapshot.
+		/// </summary>
+		/// <param name="pReference">
+		/// The reference the snapshot was encoded relative to. Only required if it was encoded
+		/// relative to one.
+		/// </param>
+		/// <returns>
+		/// Was the data valid? If not, <c>oDest</c> is undefined.
+		/// </returns>
+		bool decode(const uint8_t *pSrc, size_t iSize, const InputSnapshot *pReference,
+			InputSnapshot &oDest) const noexcept;
+
+		/// <summary>
+		/// A 64-bit hash of what the layout transmits of a snapshot, for desync detection.
+		/// <para/>
+		/// Equal for snapshots that are equal after <c>quantize()</c>.
+		/// </summary>
+		uint64_t hash(const InputSnapshot &oSnapshot) const noexcept;
+
+
+	private: // variables
+
+		InputLayout m_oLayout;
+		unsigned char m_oKeyList[256]; // the selected keys
+		unsigned m_iKeyCount = 0;
+		size_t m_iMaxBytes = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_INPUTCODEC
\ No newline at end of file
@@ -0,0 +1,223 @@
+#pragma once
+#ifndef RLINPUT_INPUTCONTEXT
+#define RLINPUT_INPUTCONTEXT
+
+
+
+
+
+#include <rlInput/Gamepad.DirectInput.hpp>
+#include <rlInput/Gamepad.XInput.hpp>
+#include <rlInput/InputHistory.hpp>
+#include <rlInput/Keyboard.hpp>
+#include <rlInput/Mouse.hpp>
+#include <rlInput/SharedInput.hpp>
+
+// STL
+#include <memory>
+#include <memory_resource>
+
+// Win32
+#define WIN32_MEAN_AND_LEAN
+#define NOMINMAX
+#include <Windows.h>
+#undef WIN32_MEAN_AND_LEAN
+#undef NOMINMAX
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The complete input state of a single window.<para/>
+	/// Every context owns its own devices, so multiple windows (each with its own game loop,
+	/// possibly on its own thread) don't influence each other. The singletons
+	/// (<c>Keyboard::Instance()</c> etc.) make up the default context.<para/>
+	/// A single context must only be used by one thread at a time.
+	/// </summary>
+	class InputContext final
+	{
+	public: // static methods
+
+		/// <summary>
+		/// The context made up of the device singletons.
+		/// </summary>
+		static InputContext &Default() noexcept;
+
+
+	public: // methods
+
+		/// <summary>
+		/// Create a context with its own devices.
+		/// </summary>
+		/// <param name="bDirectInput">
+		/// Should the context have its own DirectInput instance?<para/>
+		/// If not, <c>directInput()</c> returns the default instance, but <c>prepare()</c>,
+		/// <c>update()</c> and <c>reset()</c> ignore it. Creating a DirectInput instance
+		/// enumerates the connected controllers.
+		/// </param>
+		/// <param name="pMemory">
+		/// The memory resource the devices (and everything they allocate) are allocated from.
+		/// </param>
+		explicit InputContext(bool bDirectInput = true,
+			std::pmr::memory_resource *pMemory = std::pmr::get_default_resource());
+		~InputContext() = default;
+		InputContext(const InputContext &) = delete;
+		InputContext &operator=(const InputContext &) = delete;
+
+		/// <summary>
+		/// Prepare all devices of the context for queries.<para/>
+		/// If the history has a capacity (or consumers were created), the new state of the
+		/// keyboard, the mouse and the XInput gamepads is appended to it. If a publisher is set,
+		/// the state is published, together with the DirectInput gamepads.
+		/// </summary>
+		void prepare() noexcept;
+
+		/// <summary>
+		/// Prepare all devices, then read everything that happened since the last call for the
+		/// same consumer (see <c>InputHistory::read()</c>).<para/>
+		/// Lets game loops that run at different rates (e.g. physics, UI and AI) each get their
+		/// own correct edges. The history should be able to keep the frames between two calls of
+		/// the slowest consumer (see <c>InputHistory::setCapacity()</c>); otherwise, short taps
+		/// in the dropped frames are missed.
+		/// </summary>
+		InputHistory::Frame prepare(InputHistory::Consumer &oConsumer) noexcept
+		{
+			prepare();
+			return m_oHistory.read(oConsumer);
+		}
+
+		/// <summary>
+		/// Create a consumer for <c>prepare(consumer)</c>, starting after the last frame.
+		/// </summary>
+		InputHistory::Consumer consumer() noexcept
+		{
+			m_bRecord = true;
+			return m_oHistory.consumer();
+		}
+
+		/// <summary>
+		/// Pass a Windows message of the context's window to the devices of the context.<para/>
+		/// Messages no device processes are rejected by a single table lookup; all others are
+		/// only passed to the devices that process them. Focus changes are passed to all devices.
+		/// </summary>
+		/// <returns>
+		/// Was the message handled?<para/>
+		/// If the return value is <c>TRUE</c>, <c>DefWindowProc</c> doesn't have to be called.
+		/// </returns>
+		bool update(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept;
+
+		/// <summary>
+		/// Reset the inner state of all devices of the context.
+		/// </summary>
+		void reset() noexcept;
+
+
+
+		Keyboard    &keyboard()    noexcept { return *m_pKeyboard; }
+		Mouse       &mouse()       noexcept { return *m_pMouse; }
+		XInput      &xInput()      noexcept { return *m_pXInput; }
+		DirectInput &directInput() noexcept { return *m_pDirectInput; }
+
+		const Keyboard    &keyboard()    const noexcept { return *m_pKeyboard; }
+		const Mouse       &mouse()       const noexcept { return *m_pMouse; }
+		const XInput      &xInput()      const noexcept { return *m_pXInput; }
+		const DirectInput &directInput() const noexcept { return *m_pDirectInput; }
+
+		/// <summary>
+		/// The states recorded by <c>prepare()</c>.<para/>
+		/// Empty by default, use <c>InputHistory::setCapacity()</c> to start recording.
+		/// </summary>
+		InputHistory       &history()       noexcept { return m_oHistory; }
+		const InputHistory &history() const noexcept { return m_oHistory; }
+
+		/// <summary>
+		/// Set the publisher <c>prepare()</c> shares the input state with other processes through.
+		/// <para/>
+		/// The publisher must outlive the context (or be reset to <c>nullptr</c>).
+		/// </summary>
+		void setPublisher(InputPublisher *pPublisher) noexcept { m_pPublisher = pPublisher; }
+		InputPublisher *publisher() const noexcept { return m_pPublisher; }
+
+
+	private: // types
+
+		/// <summary>
+		/// The devices owned by a context.<para/>
+		/// Every device starts on its own cache line, so contexts (and devices) used by different
+		/// threads never share one.
+		/// </summary>
+		struct Devices
+		{
+			explicit Devices(std::pmr::memory_resource *pMemory) :
+				oKeyboard(pMemory), oMouse(pMemory), oXInput(pMemory)
+			{}
+
+			alignas(64) Keyboard oKeyboard;
+			alignas(64) Mouse    oMouse;
+			alignas(64) XInput   oXInput;
+		};
+
+		/// <summary>
+		/// Destroys an object created via <c>std::pmr::polymorphic_allocator::new_object()</c>.
+		/// </summary>
+		struct ResourceDeleter
+		{
+			std::pmr::memory_resource *pMemory;
+
+			template <typename T>
+			void operator()(T *p) const noexcept
+			{
+				std::pmr::polymorphic_allocator<>(pMemory).delete_object(p);
+			}
+		};
+
+
+	private: // methods
+
+		InputContext(Keyboard &oKeyboard, Mouse &oMouse, XInput &oXInput,
+			DirectInput &oDirectInput) noexcept; // --> default context
+
+
+	private: // variables
+
+		std::unique_ptr<Devices, ResourceDeleter> m_upDevices;
+		std::unique_ptr<DirectInput, ResourceDeleter> m_upDirectInput;
+
+		Keyboard    *m_pKeyboard;
+		Mouse       *m_pMouse;
+		XInput      *m_pXInput;
+		DirectInput *m_pDirectInput;
+		bool m_bUseDirectInput;
+
+		InputHistory m_oHistory;
+		InputPublisher *m_pPublisher = nullptr;
+		bool m_bRecord = false; // record snapshots even if the history has no capacity
+
+	};
+
+
+
+	/// <summary>
+	/// Pass a Windows message to the device singletons (see <c>InputContext::Default()</c>).
+	/// <para/>
+	/// Replaces separate calls to <c>update()</c> of <c>Keyboard</c>, <c>Mouse</c>, <c>XInput</c>
+	/// and <c>DirectInput</c>.
+	/// </summary>
+	/// <returns>
+	/// Was the message handled?<para/>
+	/// If the return value is <c>TRUE</c>, <c>DefWindowProc</c> doesn't have to be called.
+	/// </returns>
+	inline bool dispatch(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
+	{
+		return InputContext::Default().update(hWnd, uMsg, wParam, lParam);
+	}
+
+}
+
+
+
+
+
+#endif // RLINPUT_INPUTCONTEXT
\ No newline at end of file
@@ -0,0 +1,280 @@
+#pragma once
+#ifndef RLINPUT_INPUTHISTORY
+#define RLINPUT_INPUTHISTORY
+
+
+
+
+
+#include <rlInput/InputCodec.hpp>
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The input of the last N frames, indexed by frame number, e.g. for the re-simulation of
+	/// rollback netcode.<para/>
+	/// Every frame stores an <c>InputSnapshot</c> plus the pressed/released edges relative to the
+	/// frame before. Past frames can be overwritten with corrected (e.g. remote) input; the edges
+	/// that depend on them are updated.<para/>
+	/// Only the constructor and <c>setCapacity()</c> allocate.
+	/// </summary>
+	class InputHistory final
+	{
+	public: // types
+
+		using FrameIndex = uint64_t;
+
+		/// <summary>
+		/// The <c>iFrame</c> of the result of <c>read()</c> if no frame was pushed since the last
+		/// call to <c>clear()</c>.
+		/// </summary>
+		static constexpr FrameIndex NoFrame = UINT64_MAX;
+
+		/// <summary>
+		/// The state of a key or button in a recorded frame.
+		/// </summary>
+		struct Button
+		{
+			bool bPressed;  // Was the button pressed down in this frame?
+			bool bDown;     // Was the button down in this frame?
+			bool bReleased; // Was the button released in this frame?
+		};
+
+		/// <summary>
+		/// The inputs that changed between a frame and the frame before.
+		/// </summary>
+		struct Edges
+		{
+			uint64_t oKeysPressed[4];
+			uint64_t oKeysReleased[4];
+			uint8_t  iMousePressed;
+			uint8_t  iMouseReleased;
+			uint16_t oPadPressed[4];
+			uint16_t oPadReleased[4];
+		};
+
+		/// <summary>
+		/// A recorded frame.
+		/// </summary>
+		struct Frame
+		{
+			FrameIndex    iFrame;
+			InputSnapshot oState;
+			Edges         oEdges;
+
+			/// <param name="iKey">A virtual key code.</param>
+			Button key(unsigned char iKey) const noexcept
+			{
+				const auto iWord = iKey / 64;
+				const auto iBit  = uint64_t(1) << (iKey % 64);
+
+				return
+				{
+					.bPressed  = (oEdges.oKeysPressed[iWord]  & iBit) != 0,
+					.bDown     = (oState.oKeys[iWord]         & iBit) != 0,
+					.bReleased = (oEdges.oKeysReleased[iWord] & iBit) != 0
+				};
+			}
+
+			/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+			Button mouseButton(unsigned char iButtonID) const noexcept
+			{
+				const auto iBit = unsigned(1) << iButtonID;
+
+				return
+				{
+					.bPressed  = (oEdges.iMousePressed  & iBit) != 0,
+					.bDown     = (oState.iMouseButtons  & iBit) != 0,
+					.bReleased = (oEdges.iMouseReleased & iBit) != 0
+				};
+			}
+
+			/// <param name="iGamepad">The index of the XInput gamepad, between 0 and 3.</param>
+			/// <param name="iButtonID">
+			/// One of the <c>XINPUT_BUTTON_[...]</c> constants of the physical buttons (0 to 11).
+			/// </param>
+			Button padButton(unsigned iGamepad, unsigned char iButtonID) const noexcept
+			{
+				const auto iBit = unsigned(1) << iButtonID;
+
+				return
+				{
+					.bPressed  = (oEdges.oPadPressed[iGamepad]   & iBit) != 0,
+					.bDown     = (oState.oPads[iGamepad].iButtons & iBit) != 0,
+					.bReleased = (oEdges.oPadReleased[iGamepad]  & iBit) != 0
+				};
+			}
+		};
+
+		/// <summary>
+		/// A reader of the history with its own position, e.g. a game loop running at its own
+		/// rate (see <c>read()</c>).<para/>
+		/// Get new consumers via <c>consumer()</c>.
+		/// </summary>
+		struct Consumer
+		{
+			FrameIndex    iNextFrame  = 0; // the first frame not read yet
+			InputSnapshot oLastState{};    // the newest state at the time of the last read
+			uint64_t      iGeneration = 0; // the count of clear() calls at the last read
+		};
+
+		/// <summary>
+		/// The result of <c>correct()</c>.
+		/// </summary>
+		enum class Correction
+		{
+			OutOfRange, // the frame isn't in the history (anymore)
+			Unchanged,  // the frame already had the corrected state
+			Changed     // the frame was changed --> re-simulate from this frame on
+		};
+
+
+	public: // methods
+
+		/// <param name="iCapacity">
+		/// The count of frames to keep. If 0, <c>push()</c> only counts the frames and keeps the
+		/// newest state (consumers then only see the edges derived from the states).
+		/// </param>
+		explicit InputHistory(size_t iCapacity = 0,
+			std::pmr::memory_resource *pMemory = std::pmr::get_default_resource());
+
+		/// <summary>
+		/// The count of frames kept.
+		/// </summary>
+		size_t capacity() const noexcept { return m_oFrames.size(); }
+
+		/// <summary>
+		/// Change the count of frames kept. Clears the history (see <c>clear()</c>).
+		/// </summary>
+		void setCapacity(size_t iCapacity);
+
+		/// <summary>
+		/// Forget all frames.<para/>
+		/// Existing consumers continue reading at the first frame pushed afterwards, whether
+		/// <c>iNextFrame</c> is smaller or bigger than before. The edges between their last state
+		/// and that frame are derived from the states.
+		/// </summary>
+		/// <param name="iNextFrame">The index of the next frame passed to <c>push()</c>.</param>
+		void clear(FrameIndex iNextFrame = 0) noexcept;
+
+		/// <summary>
+		/// Append a frame. Its edges are computed relative to the newest frame. If the history is
+		/// full, the oldest frame is dropped.
+		/// </summary>
+		/// <returns>The index of the frame.</returns>
+		FrameIndex push(const InputSnapshot &oState) noexcept;
+
+		/// <summary>
+		/// Overwrite the state of a recorded frame, e.g. with the actual input of a remote
+		/// player that was predicted before.<para/>
+		/// Updates the edges of the frame and the frame after it, in O(1).
+		/// </summary>
+		Correction correct(FrameIndex iFrame, const InputSnapshot &oState) noexcept;
+
+		/// <summary>
+		/// A consumer that starts reading after the newest frame.
+		/// </summary>
+		Consumer consumer() const noexcept;
+
+		/// <summary>
+		/// Read all frames recorded since the last call for the same consumer.<para/>
+		/// Every consumer sees all edges exactly once, no matter how often the others read.
+		/// Only the consumer is changed, so any count of consumers can share a history.
+		/// </summary>
+		/// <returns>
+		/// The newest frame, with the edges of all frames read combined (a key pressed and
+		/// released in between has both <c>bPressed</c> and <c>bReleased</c> set) and the mouse
+		/// movement and wheel rotation of all frames read added up. If frames were dropped
+		/// before they were read, the edges between the consumer's last state and the oldest
+		/// frame are derived from the states.<para/>
+		/// If no new frame was recorded, the edges are empty; <c>iFrame</c> is the newest frame
+		/// pushed, or <c>NoFrame</c> if none was pushed since the last <c>clear()</c>.
+		/// </returns>
+		Frame read(Consumer &oConsumer) const noexcept;
+
+		/// <summary>
+		/// Get a recorded frame, in O(1).
+		/// </summary>
+		/// <returns>
+		/// The frame, or <c>nullptr</c> if it wasn't recorded yet or isn't kept anymore.
+		/// </returns>
+		const Frame *stateAt(FrameIndex iFrame) const noexcept
+		{
+			if (!contains(iFrame))
+				return nullptr;
+			return &m_oFrames[iFrame % m_oFrames.size()];
+		}
+
+		/// <summary>
+		/// Is a frame in the history?
+		/// </summary>
+		bool contains(FrameIndex iFrame) const noexcept
+		{
+			return iFrame < m_iNextFrame && m_iNextFrame - iFrame <= m_iCount;
+		}
+
+		/// <summary>
+		/// The count of frames in the history.
+		/// </summary>
+		size_t size() const noexcept { return m_iCount; }
+
+		bool empty() const noexcept { return m_iCount == 0; }
+
+		/// <summary>
+		/// The index of the oldest frame in the history. Only valid if it's not empty.
+		/// </summary>
+		FrameIndex oldestFrame() const noexcept { return m_iNextFrame - m_iCount; }
+
+		/// <summary>
+		/// The index of the newest frame in the history. Only valid if it's not empty.
+		/// </summary>
+		FrameIndex newestFrame() const noexcept { return m_iNextFrame - 1; }
+
+		/// <summary>
+		/// The index the next frame passed to <c>push()</c> will get.
+		/// </summary>
+		FrameIndex nextFrame() const noexcept { return m_iNextFrame; }
+
+
+	private: // static methods
+
+		static void ComputeEdges(Frame &oFrame, const InputSnapshot &oPrevious) noexcept;
+
+
+	private: // methods
+
+		Frame &frame(FrameIndex iFrame) noexcept { return m_oFrames[iFrame % m_oFrames.size()]; }
+
+		const Frame &frame(FrameIndex iFrame) const noexcept
+		{
+			return m_oFrames[iFrame % m_oFrames.size()];
+		}
+
+
+	private: // variables
+
+		std::pmr::vector<Frame> m_oFrames;
+		FrameIndex m_iNextFrame = 0;
+		FrameIndex m_iFirstFrame = 0; // the index passed to clear()
+		uint64_t m_iGeneration = 0;   // the count of clear() calls
+		size_t m_iCount = 0;
+		InputSnapshot m_oBase{}; // the state before the oldest frame (the newest if no capacity)
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_INPUTHISTORY
\ No newline at end of file
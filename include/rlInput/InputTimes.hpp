@@ -0,0 +1,78 @@
+#pragma once
+#ifndef RLINPUT_INPUTTIMES
+#define RLINPUT_INPUTTIMES
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+// STL
+#include <cstddef>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The timestamps of the last press and release of a fixed count of digital inputs.
+	/// </summary>
+	template <size_t N>
+	class InputTimes final
+	{
+	public: // methods
+
+		/// <summary>
+		/// The time the input was last pressed.<para/>
+		/// Default-constructed if the input was never pressed.
+		/// </summary>
+		Clock::time_point pressTime(size_t iInput) const noexcept
+		{
+			return m_oPressTimes[iInput];
+		}
+
+		/// <summary>
+		/// The time the input was last released.<para/>
+		/// Default-constructed if the input was never released.
+		/// </summary>
+		Clock::time_point releaseTime(size_t iInput) const noexcept
+		{
+			return m_oReleaseTimes[iInput];
+		}
+
+		void setPressTime(size_t iInput, Clock::time_point tp) noexcept
+		{
+			m_oPressTimes[iInput] = tp;
+		}
+
+		void setReleaseTime(size_t iInput, Clock::time_point tp) noexcept
+		{
+			m_oReleaseTimes[iInput] = tp;
+		}
+
+		/// <summary>
+		/// How long has the input been held down at the time <c>tpNow</c>?
+		/// </summary>
+		/// <param name="bDown">Is the input currently down?</param>
+		Clock::duration heldFor(size_t iInput, bool bDown, Clock::time_point tpNow) const noexcept
+		{
+			return bDown ? tpNow - m_oPressTimes[iInput] : Clock::duration::zero();
+		}
+
+
+	private: // variables
+
+		Clock::time_point m_oPressTimes[N]{};
+		Clock::time_point m_oReleaseTimes[N]{};
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_INPUTTIMES
\ No newline at end of file
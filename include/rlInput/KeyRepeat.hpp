@@ -0,0 +1,123 @@
+#pragma once
+#ifndef RLINPUT_KEYREPEAT
+#define RLINPUT_KEYREPEAT
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+// STL
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The timing of generated key repeats.
+	/// </summary>
+	struct RepeatSettings
+	{
+		/// <summary>
+		/// The time between the press of an input and its first repeat.
+		/// </summary>
+		Clock::duration tDelay = std::chrono::milliseconds(500);
+
+		/// <summary>
+		/// The time between the first and the second repeat.
+		/// </summary>
+		Clock::duration tInterval = std::chrono::milliseconds(50);
+
+		/// <summary>
+		/// The lower limit of the time between two repeats.
+		/// </summary>
+		Clock::duration tMinInterval = std::chrono::milliseconds(50);
+
+		/// <summary>
+		/// The factor the interval is multiplied with after each repeat.<para/>
+		/// Values below 1 make repeats faster the longer an input is held.
+		/// </summary>
+		float fAcceleration = 1.0f;
+	};
+
+
+
+	/// <summary>
+	/// A deterministic software key repeat generator.<para/>
+	/// Repeats are computed from the press timestamps instead of OS autorepeat messages, so they
+	/// behave identically for all devices. The cost only depends on the count of held inputs.
+	/// </summary>
+	class KeyRepeat final
+	{
+	public: // static variables
+
+		/// <summary>
+		/// The maximum count of inputs that can repeat at the same time.<para/>
+		/// Inputs pressed while this many inputs are held don't repeat.
+		/// </summary>
+		static constexpr size_t MaxHeld = 16;
+
+
+	public: // methods
+
+		const RepeatSettings &settings() const noexcept { return m_oSettings; }
+		void setSettings(const RepeatSettings &oSettings) noexcept { m_oSettings = oSettings; }
+
+		/// <summary>
+		/// Start repeating an input.
+		/// </summary>
+		/// <param name="tpPressed">The time the input was pressed.</param>
+		void press(unsigned iInput, Clock::time_point tpPressed) noexcept;
+
+		/// <summary>
+		/// Stop repeating an input.
+		/// </summary>
+		void release(unsigned iInput) noexcept;
+
+		/// <summary>
+		/// Stop repeating all inputs.
+		/// </summary>
+		void reset() noexcept { m_iHeldCount = 0; }
+
+		/// <summary>
+		/// Compute the repeats up until <c>tpNow</c>.<para/>
+		/// Inputs that repeated at least once since the last call are marked in
+		/// <c>pRepeatedMask</c>. Bits of other inputs are not modified.
+		/// </summary>
+		/// <param name="pRepeatedMask">
+		/// A bit mask with one bit per input.
+		/// Input <c>i</c> is represented by bit <c>i % 64</c> of word <c>i / 64</c>.
+		/// </param>
+		void advance(Clock::time_point tpNow, uint64_t *pRepeatedMask) noexcept;
+
+
+	private: // types
+
+		struct Held
+		{
+			unsigned iInput;
+			Clock::time_point tpNext;  // time of the next repeat
+			Clock::duration tInterval; // interval after the next repeat
+		};
+
+
+	private: // variables
+
+		RepeatSettings m_oSettings;
+
+		Held m_oHeld[MaxHeld]{};
+		size_t m_iHeldCount = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_KEYREPEAT
\ No newline at end of file
@@ -6,9 +6,18 @@
 
 
 
+#include <rlInput/Callbacks.hpp>
+#include <rlInput/Clock.hpp>
+#include <rlInput/DeviceMap.hpp>
+#include <rlInput/InputTimes.hpp>
+#include <rlInput/KeyRepeat.hpp>
+#include <rlInput/Stats.hpp>
+#include <rlInput/TextRing.hpp>
+#include <rlInput/WaitList.hpp>
+
 // STL
-#include <memory>
-#include <string>
+#include <memory_resource>
+#include <string_view>
 #include <vector>
 
 // Win32
@@ -35,6 +44,7 @@ namespace rlInput
 			bool bPressed;  // Was the key pressed down?
 			bool bDown;     // Is the key currently down?
 			bool bReleased; // Was the key released?
+			bool bRepeated; // Was the key repeated? (see <c>setRepeatSettings()</c>)
 		};
 
 		/// <summary>
@@ -47,6 +57,78 @@ namespace rlInput
 		static constexpr ModKeys ModKey_Control = 0x02;
 		static constexpr ModKeys ModKey_Shift   = 0x04;
 
+		/// <summary>
+		/// A read position in the recorded text (see <c>readText()</c>).<para/>
+		/// UTF-16 and UTF-8 positions are counted separately.
+		/// </summary>
+		using TextCursor = uint64_t;
+
+		/// <summary>
+		/// The state of a single physical keyboard (see <c>enableRawInput()</c>).
+		/// </summary>
+		class Seat final
+		{
+			friend class Keyboard;
+
+		public: // methods
+
+			/// <summary>
+			/// The Raw Input device handle of the keyboard.
+			/// </summary>
+			HANDLE device() const noexcept { return m_hDevice; }
+
+			/// <summary>
+			/// Was the keyboard connected at the time of the last call to <c>prepare()</c>?
+			/// </summary>
+			bool connected() const noexcept { return m_bConnected; }
+
+			/// <summary>
+			/// Get the state of a key at the time of the last call to <c>prepare()</c>.<para/>
+			/// <c>bRepeated</c> is always <c>FALSE</c>.
+			/// </summary>
+			Key key(unsigned char index) const noexcept
+			{
+				const auto iWord = index / 64;
+				const auto iBit  = uint64_t(1) << (index % 64);
+
+				return
+				{
+					.bPressed  = (m_oPressed[iWord]  & iBit) != 0,
+					.bDown     = (m_oDown[iWord]     & iBit) != 0,
+					.bReleased = (m_oReleased[iWord] & iBit) != 0,
+					.bRepeated = false
+				};
+			}
+
+			Key operator[](unsigned char index) const noexcept { return key(index); }
+
+
+		private: // variables
+
+			HANDLE m_hDevice       = NULL;
+			bool   m_bConnected    = false;
+			bool   m_bRawConnected = false; // updated by WM_INPUT_DEVICE_CHANGE
+
+			uint64_t m_oRawDown[4]{}; // updated by WM_INPUT
+			uint64_t m_oDown[4]{};
+			uint64_t m_oPressed[4]{};
+			uint64_t m_oReleased[4]{};
+		};
+
+		/// <summary>
+		/// The maximum count of physical keyboards tracked separately.
+		/// </summary>
+		static constexpr size_t MaxSeats = 16;
+
+		/// <summary>
+		/// The messages <c>update()</c> processes. It ignores all others.
+		/// </summary>
+		static constexpr UINT Messages[] =
+		{
+			WM_KEYDOWN, WM_KEYUP, WM_CHAR, WM_IME_STARTCOMPOSITION,
+			WM_INPUT, WM_INPUT_DEVICE_CHANGE, WM_KILLFOCUS
+		};
+
 
 
 
@@ -66,6 +148,20 @@ namespace rlInput
 
 	public: // methods
 
+		/// <summary>
+		/// Create an independent keyboard state, e.g. for an <c>InputContext</c>.<para/>
+		/// Most applications only need the default instance (see <c>Instance()</c>).
+		/// </summary>
+		/// <param name="pMemory">
+		/// The memory resource the text buffers and callback tables are allocated from.<para/>
+		/// Only the constructor, <c>setTextCapacity()</c> and subscribing callbacks allocate;
+		/// <c>update()</c> and <c>prepare()</c> never do.
+		/// </param>
+		explicit Keyboard(std::pmr::memory_resource *pMemory = std::pmr::get_default_resource());
+		~Keyboard() = default;
+		Keyboard(const Keyboard &) = delete;
+		Keyboard &operator=(const Keyboard &) = delete;
+
 		/// <summary>
 		/// Prepare the internal key infos for queries.<para />
 		/// Must be called every time an updated state of the keyboard is required.
@@ -100,7 +196,7 @@ namespace rlInput
 		/// <summary>
 		/// Get the state of a key at the time of the last call to <c>prepare()</c>.
 		/// </summary>
-		const Key &key(unsigned char index) const noexcept { return m_upStates[index]; }
+		const Key &key(unsigned char index) const noexcept { return m_oStates[index]; }
 
 		/// <summary>
 		/// Get all keys that have been pressed between the previous and current call to
@@ -113,13 +209,184 @@ namespace rlInput
 		/// </param>
 		void pressedKeys(std::vector<unsigned char> &oDest) const noexcept;
 
+		/// <summary>
+		/// Get all keys that have been pressed between the previous and current call to
+		/// <c>prepare()</c>, without allocating.
+		/// </summary>
+		/// <param name="pDest">
+		/// Receives the virtual key codes of the newly pressed keys, in ascending order.<para/>
+		/// 256 entries are always enough.
+		/// </param>
+		/// <returns>The count of key codes written to <c>pDest</c>.</returns>
+		size_t pressedKeys(unsigned char *pDest, size_t iDestSize) const noexcept;
+
+		/// <summary>
+		/// The memory resource passed to the constructor.
+		/// </summary>
+		std::pmr::memory_resource *memoryResource() const noexcept { return m_pMemory; }
+
+
+
+		/// <summary>
+		/// Register the keyboards for Raw Input (<c>WM_INPUT</c>) messages of a window.<para/>
+		/// Required for the per-device states (see <c>seat()</c>). The merged state
+		/// (<c>key()</c> etc.) isn't affected.
+		/// </summary>
+		/// <param name="bBackground">
+		/// Should input also be received while the window is not in the foreground?
+		/// </param>
+		/// <returns>Could the keyboards be registered?</returns>
+		bool enableRawInput(HWND hWnd, bool bBackground = false) noexcept;
+
+		/// <summary>
+		/// The count of physical keyboards that have sent input so far.<para/>
+		/// Seats are never removed, so indices stay valid. At most <c>MaxSeats</c>.
+		/// </summary>
+		size_t seatCount() const noexcept { return m_oSeatMap.size(); }
+
+		/// <summary>
+		/// Get the state of a single physical keyboard at the time of the last call to
+		/// <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iSeat">
+		/// The index of the keyboard. Must be less than <c>seatCount()</c>.
+		/// </param>
+		const Seat &seat(size_t iSeat) const noexcept { return m_oSeats[iSeat]; }
+
+		/// <summary>
+		/// Get the seat index of a Raw Input device.
+		/// </summary>
+		/// <returns>
+		/// The index of the keyboard, or <c>size_t(-1)</c> if it hasn't sent any input so far.
+		/// </returns>
+		size_t seatIndex(HANDLE hDevice) const noexcept { return m_oSeatMap.find(hDevice); }
+
 		/// <summary>
 		/// Get the state of the modifier keys at the time of the last call to <c>prepare()</c>.
 		/// </summary>
 		ModKeys modifierKeys() const noexcept;
 
+
+
+		/// <summary>
+		/// The time of the last call to <c>prepare()</c>.<para/>
+		/// All durations are measured relative to this point in time.
+		/// </summary>
+		Clock::time_point prepareTime() const noexcept { return m_tpPrepared; }
+
+		/// <summary>
+		/// The time a key was last pressed, as of the last call to <c>prepare()</c>.
+		/// </summary>
+		Clock::time_point pressTime(unsigned char index) const noexcept
+		{
+			return m_oTimes.pressTime(index);
+		}
+
+		/// <summary>
+		/// The time a key was last released, as of the last call to <c>prepare()</c>.
+		/// </summary>
+		Clock::time_point releaseTime(unsigned char index) const noexcept
+		{
+			return m_oTimes.releaseTime(index);
+		}
+
+		/// <summary>
+		/// How long a key has been held down at the time of the last call to
+		/// <c>prepare()</c>.<para/>
+		/// Zero if it isn't currently down.
+		/// </summary>
+		Clock::duration heldFor(unsigned char index) const noexcept
+		{
+			return m_oTimes.heldFor(index, key(index).bDown, m_tpPrepared);
+		}
+
+		/// <summary>
+		/// The time between the last press of a key and the last call to <c>prepare()</c>.
+		/// </summary>
+		Clock::duration timeSincePressed(unsigned char index) const noexcept
+		{
+			return m_tpPrepared - m_oTimes.pressTime(index);
+		}
+
+		/// <summary>
+		/// The time between the last release of a key and the last call to <c>prepare()</c>.
+		/// </summary>
+		Clock::duration timeSinceReleased(unsigned char index) const noexcept
+		{
+			return m_tpPrepared - m_oTimes.releaseTime(index);
+		}
+
+		/// <summary>
+		/// Has a key been held down for at least <c>tThreshold</c> at the time of the last
+		/// call to <c>prepare()</c>?
+		/// </summary>
+		bool longPressed(unsigned char index, Clock::duration tThreshold) const noexcept
+		{
+			return key(index).bDown && heldFor(index) >= tThreshold;
+		}
+
+
+
+		/// <summary>
+		/// The list of coroutines waiting for a key to be pressed.<para/>
+		/// Usually accessed via <c>rlInput::pressed()</c> (see <c>Awaitable.hpp</c>).
+		/// </summary>
+		WaitList &pressedWaitList(unsigned char index) noexcept
+		{
+			return m_oPressedWaiters[index];
+		}
+
+		/// <summary>
+		/// The list of coroutines waiting for a key to be released.<para/>
+		/// Usually accessed via <c>rlInput::released()</c> (see <c>Awaitable.hpp</c>).
+		/// </summary>
+		WaitList &releasedWaitList(unsigned char index) noexcept
+		{
+			return m_oReleasedWaiters[index];
+		}
+
+		/// <summary>
+		/// The callbacks called by <c>prepare()</c> when a key was pressed.<para/>
+		/// The input index is the virtual key code.
+		/// </summary>
+		CallbackTable &pressedCallbacks() noexcept { return m_oPressedCallbacks; }
+
+		/// <summary>
+		/// The callbacks called by <c>prepare()</c> when a key was released.<para/>
+		/// The input index is the virtual key code.
+		/// </summary>
+		CallbackTable &releasedCallbacks() noexcept { return m_oReleasedCallbacks; }
+
 		
 
+		/// <summary>
+		/// The timing of the <c>bRepeated</c> flag of held keys.
+		/// </summary>
+		const RepeatSettings &repeatSettings() const noexcept { return m_oRepeat.settings(); }
+
+		/// <summary>
+		/// Set the timing of the <c>bRepeated</c> flag of held keys.<para/>
+		/// Repeats are generated by <c>prepare()</c>, independent of the OS autorepeat settings.
+		/// </summary>
+		void setRepeatSettings(const RepeatSettings &oSettings) noexcept
+		{
+			m_oRepeat.setSettings(oSettings);
+		}
+
+		/// <summary>
+		/// Are OS autorepeat <c>WM_KEYDOWN</c> messages discarded by <c>update()</c>?
+		/// </summary>
+		bool ignoreAutoRepeat() const noexcept { return m_bIgnoreAutoRepeat; }
+
+		/// <summary>
+		/// Set if OS autorepeat <c>WM_KEYDOWN</c> messages should be discarded by
+		/// <c>update()</c> before any other processing.<para/>
+		/// The <c>bRepeated</c> flag is not affected by this.
+		/// </summary>
+		void setIgnoreAutoRepeat(bool bIgnore) noexcept { m_bIgnoreAutoRepeat = bIgnore; }
+
+
+
 		/// <summary>
 		/// Start recording text input.<para/>
 		/// Text is recorded only if the window sending messages uses Unicode
@@ -137,33 +404,136 @@ namespace rlInput
 		bool recordingText() const noexcept { return m_bRecordText; }
 
 		/// <summary>
-		/// The text recorded via <c>startTextRecording()</c> up until now.<para/>
-		/// New text input will always be appended.
-		/// You can call <c>clearRecordedText()</c> to empty this string.
+		/// Set the size of the buffers the recorded text is kept in.<para/>
+		/// The buffers are allocated once by this function; <c>update()</c> and <c>prepare()</c>
+		/// never allocate. Once a buffer is full, the oldest text is overwritten.<para/>
+		/// The default is 1024 UTF-16 code units and no UTF-8 buffer.
+		/// </summary>
+		/// <param name="iUTF16Capacity">
+		/// The count of UTF-16 code units kept. Rounded up to a power of two. 0 disables UTF-16
+		/// recording.
+		/// </param>
+		/// <param name="iUTF8Capacity">
+		/// The count of UTF-8 bytes kept. Rounded up to a power of two. 0 disables UTF-8
+		/// recording.
+		/// </param>
+		void setTextCapacity(size_t iUTF16Capacity, size_t iUTF8Capacity = 0);
+
+		/// <summary>
+		/// The text recorded between the previous and the last call to <c>prepare()</c>.<para/>
+		/// Valid until the next call to <c>prepare()</c>.
 		/// </summary>
-		auto &recordedText() const noexcept { return m_sRecordedText; }
+		std::wstring_view frameText() const noexcept { return m_oTextUTF16.frame(); }
 
 		/// <summary>
-		/// Clear the text recorded via <c>startTextRecording()</c> up until now.
+		/// The text recorded between the previous and the last call to <c>prepare()</c>, as
+		/// UTF-8.<para/>
+		/// Empty unless UTF-8 recording was enabled via <c>setTextCapacity()</c>. Valid until the
+		/// next call to <c>prepare()</c>.
 		/// </summary>
-		void clearRecordedText() noexcept { m_sRecordedText.clear(); }
+		std::string_view frameTextUTF8() const noexcept { return m_oTextUTF8.frame(); }
+
+		/// <summary>
+		/// The position after the newest recorded UTF-16 code unit.<para/>
+		/// Initialize a <c>TextCursor</c> with this value to only read text recorded from now on.
+		/// </summary>
+		TextCursor textEnd() const noexcept { return m_oTextUTF16.end(); }
+
+		/// <summary>
+		/// The position after the newest recorded UTF-8 byte.<para/>
+		/// Initialize a <c>TextCursor</c> with this value to only read text recorded from now on.
+		/// </summary>
+		TextCursor textEndUTF8() const noexcept { return m_oTextUTF8.end(); }
+
+		/// <summary>
+		/// Copy the recorded text from a position on, including text recorded after the last
+		/// call to <c>prepare()</c>.<para/>
+		/// Surrogate pairs are never split. Text that was already overwritten is skipped.
+		/// </summary>
+		/// <param name="iCursor">
+		/// The position to read from. Is advanced behind the text that was copied.
+		/// </param>
+		/// <returns>The count of code units written to <c>pDest</c>.</returns>
+		size_t readText(TextCursor &iCursor, wchar_t *pDest, size_t iDestSize) const noexcept
+		{
+			return m_oTextUTF16.read(iCursor, pDest, iDestSize);
+		}
+
+		/// <summary>
+		/// Copy the recorded UTF-8 text from a position on, including text recorded after the
+		/// last call to <c>prepare()</c>.<para/>
+		/// Code points are never split. Text that was already overwritten is skipped.
+		/// </summary>
+		/// <param name="iCursor">
+		/// The position to read from. Is advanced behind the text that was copied.
+		/// </param>
+		/// <returns>The count of bytes written to <c>pDest</c>.</returns>
+		size_t readTextUTF8(TextCursor &iCursor, char *pDest, size_t iDestSize) const noexcept
+		{
+			return m_oTextUTF8.read(iCursor, pDest, iDestSize);
+		}
+
+
+
+		/// <summary>
+		/// The instrumentation counters (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// </summary>
+		const DeviceStats &stats() const noexcept { return m_oStats.stats(); }
+
+		/// <summary>
+		/// The time between inputs entering <c>update()</c> and the <c>prepare()</c> call that
+		/// surfaced them (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// </summary>
+		const LatencyHistogram &latency() const noexcept { return m_oStats.latency(); }
+
+		void resetStats() noexcept { m_oStats.reset(); }
 
 
 	private: // methods
 
-		Keyboard(); // --> singleton
-		~Keyboard() = default;
+		// must only handle the messages listed in Messages
+		bool processMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept;
+
+
+		void processRawInput(HRAWINPUT hRawInput) noexcept;
+
+		/// <summary>
+		/// Append a code point to the text buffers.
+		/// </summary>
+		void recordCodePoint(char32_t cCodePoint) noexcept;
 
 
 	private: // variables
 
-		std::unique_ptr<Key[]> m_upStates = std::make_unique<Key[]>(256);
+		std::pmr::memory_resource *const m_pMemory; // must be declared first
+
+		Key m_oStates[256]{};
 		bool m_oRawStates_Old[256]{};
 		bool m_oRawStates_New[256]{};
+		Clock::time_point m_oRawTimes[256]{}; // time of the last change of m_oRawStates_New
+
+		InputTimes<256> m_oTimes;
+		Clock::time_point m_tpPrepared{};
+
+		KeyRepeat m_oRepeat;
+		bool m_bIgnoreAutoRepeat = false;
+
+		WaitList m_oPressedWaiters[256];
+		WaitList m_oReleasedWaiters[256];
+
+		CallbackTable m_oPressedCallbacks{ 256, m_pMemory };
+		CallbackTable m_oReleasedCallbacks{ 256, m_pMemory };
+
+		DeviceMap<MaxSeats> m_oSeatMap;
+		Seat m_oSeats[MaxSeats];
 
 		bool m_bRecordText       = false;
 		bool m_bRecordingStopped = true;
-		std::wstring m_sRecordedText;
+		wchar_t m_cHighSurrogate = 0; // first half of a surrogate pair, waiting for the second
+		TextRing<wchar_t> m_oTextUTF16{ m_pMemory };
+		TextRing<char>    m_oTextUTF8{ m_pMemory };
+
+		StatsRecorder m_oStats;
 
 	};
 
@@ -6,6 +6,20 @@
 
 
 
+#include <rlInput/Callbacks.hpp>
+#include <rlInput/Clock.hpp>
+#include <rlInput/DeviceMap.hpp>
+#include <rlInput/Filters.hpp>
+#include <rlInput/Gestures.hpp>
+#include <rlInput/InputTimes.hpp>
+#include <rlInput/Stats.hpp>
+#include <rlInput/WaitList.hpp>
+
+// STL
+#include <memory_resource>
+#include <span>
+#include <vector>
+
 // Win32
 #define WIN32_MEAN_AND_LEAN
 #define NOMINMAX
@@ -18,10 +32,47 @@
 namespace rlInput
 {
 
+	constexpr unsigned char MOUSE_BUTTON_LEFT   = 0;
+	constexpr unsigned char MOUSE_BUTTON_RIGHT  = 1;
+	constexpr unsigned char MOUSE_BUTTON_MIDDLE = 2;
+
+	// the additional buttons of a seat (see Mouse::Seat::button())
+	constexpr unsigned char MOUSE_SEAT_BUTTON_X1 = 3;
+	constexpr unsigned char MOUSE_SEAT_BUTTON_X2 = 4;
+
+
+
 	class Mouse
 	{
 	public: // types
 
+		/// <summary>
+		/// A single cursor position recorded by <c>update()</c>.
+		/// </summary>
+		struct PathPoint
+		{
+			int iX; // Horizontal client position
+			int iY; // Vertical client position
+			Clock::time_point tpTime; // Time the <c>WM_MOUSEMOVE</c> message was processed
+		};
+
+		/// <summary>
+		/// What to do when the path history is full.
+		/// </summary>
+		enum class PathDecimation
+		{
+			/// <summary>
+			/// Remove every second point, so the path keeps covering the whole frame at a lower
+			/// resolution.
+			/// </summary>
+			Halve,
+			/// <summary>
+			/// Overwrite the last point, so the path keeps the start of the movement and the
+			/// current position.
+			/// </summary>
+			ReplaceLast
+		};
+
 		/// <summary>
 		/// The state of a single mouse button.
 		/// </summary>
@@ -33,6 +84,107 @@ namespace rlInput
 			bool bReleased;      // Was the button released?
 		};
 
+		/// <summary>
+		/// The state of a single physical mouse (see <c>enableRawInput()</c>).
+		/// </summary>
+		class Seat final
+		{
+			friend class Mouse;
+
+		public: // methods
+
+			/// <summary>
+			/// The Raw Input device handle of the mouse.
+			/// </summary>
+			HANDLE device() const noexcept { return m_hDevice; }
+
+			/// <summary>
+			/// Was the mouse connected at the time of the last call to <c>prepare()</c>?
+			/// </summary>
+			bool connected() const noexcept { return m_bConnected; }
+
+			/// <summary>
+			/// Get the state of a mouse button at the time of the last call to <c>prepare()</c>.
+			/// <para/>
+			/// <c>bDoubleClicked</c> is always <c>FALSE</c>.
+			/// </summary>
+			/// <param name="iButtonID">
+			/// One of the <c>MOUSE_BUTTON_[...]</c> or <c>MOUSE_SEAT_BUTTON_[...]</c> constants.
+			/// </param>
+			Button button(unsigned char iButtonID) const noexcept
+			{
+				const uint8_t iBit = uint8_t(1 << iButtonID);
+
+				return
+				{
+					.bClicked       = (m_iPressed  & iBit) != 0,
+					.bDoubleClicked = false,
+					.bDown          = (m_iDown     & iBit) != 0,
+					.bReleased      = (m_iReleased & iBit) != 0
+				};
+			}
+
+			/// <summary>
+			/// The horizontal movement of this mouse between the previous and the last call to
+			/// <c>prepare()</c>, multiplied with <c>Mouse::rawScale()</c>.
+			/// </summary>
+			auto deltaX() const noexcept { return m_dDeltaX; }
+
+			/// <summary>
+			/// The vertical movement of this mouse between the previous and the last call to
+			/// <c>prepare()</c>, multiplied with <c>Mouse::rawScale()</c>.
+			/// </summary>
+			auto deltaY() const noexcept { return m_dDeltaY; }
+
+			/// <summary>
+			/// The wheel rotation of this mouse between the previous and the last call to
+			/// <c>prepare()</c>, in multiples or divisions of <c>WHEEL_DELTA</c>.
+			/// </summary>
+			auto wheelRotation() const noexcept { return m_iWheelRotation; }
+
+
+		private: // variables
+
+			HANDLE m_hDevice       = NULL;
+			bool   m_bConnected    = false;
+			bool   m_bRawConnected = false; // updated by WM_INPUT_DEVICE_CHANGE
+
+			// updated by WM_INPUT
+			uint8_t   m_iRawDown   = 0; // bit per button
+			long long m_iRawDeltaX = 0;
+			long long m_iRawDeltaY = 0;
+			double m_dAbsoluteDeltaX = 0.0;
+			double m_dAbsoluteDeltaY = 0.0;
+			double m_dLastAbsoluteX  = 0.0;
+			double m_dLastAbsoluteY  = 0.0;
+			bool   m_bHasAbsolute    = false;
+			int    m_iRawWheel       = 0;
+
+			uint8_t m_iDown     = 0;
+			uint8_t m_iPressed  = 0;
+			uint8_t m_iReleased = 0;
+			double  m_dDeltaX   = 0.0;
+			double  m_dDeltaY   = 0.0;
+			int     m_iWheelRotation = 0;
+		};
+
+		/// <summary>
+		/// The maximum count of physical mice tracked separately.
+		/// </summary>
+		static constexpr size_t MaxSeats = 16;
+
+		/// <summary>
+		/// The messages <c>update()</c> processes. It ignores all others.
+		/// </summary>
+		static constexpr UINT Messages[] =
+		{
+			WM_MOUSEMOVE, WM_MOUSELEAVE,
+			WM_LBUTTONDOWN, WM_LBUTTONUP, WM_LBUTTONDBLCLK,
+			WM_RBUTTONDOWN, WM_RBUTTONUP, WM_RBUTTONDBLCLK,
+			WM_MBUTTONDOWN, WM_MBUTTONUP, WM_MBUTTONDBLCLK,
+			WM_MOUSEWHEEL, WM_INPUT, WM_INPUT_DEVICE_CHANGE, WM_KILLFOCUS
+		};
+
 
 
 
@@ -52,6 +204,22 @@ namespace rlInput
 
 	public: // methods
 
+		/// <summary>
+		/// Create an independent mouse state, e.g. for an <c>InputContext</c>.<para/>
+		/// Most applications only need the default instance (see <c>Instance()</c>).
+		/// </summary>
+		/// <param name="pMemory">
+		/// The memory resource the path history and callback tables are allocated from.<para/>
+		/// Only the constructor, <c>setPathHistory()</c> and subscribing callbacks allocate;
+		/// <c>update()</c> and <c>prepare()</c> never do.
+		/// </param>
+		explicit Mouse(std::pmr::memory_resource *pMemory = std::pmr::get_default_resource()) :
+			m_pMemory(pMemory)
+		{}
+		~Mouse() = default;
+		Mouse(const Mouse &) = delete;
+		Mouse &operator=(const Mouse &) = delete;
+
 		/// <summary>
 		/// Prepare the internal button info for queries.<para />
 		/// Must be called every time an updated state of the mouse is required.
@@ -80,19 +248,94 @@ namespace rlInput
 		/// <summary>
 		/// Get the state of the left mouse button at the time of the last call to <c>prepare()</c>.
 		/// </summary>
-		const Button &leftButton()   const noexcept { return m_oStates[0]; }
+		const Button &leftButton()   const noexcept { return m_oStates[MOUSE_BUTTON_LEFT]; }
 
 		/// <summary>
 		/// Get the state of the right mouse button at the time of the last call to
 		/// <c>prepare()</c>.
 		/// </summary>
-		const Button &rightButton()  const noexcept { return m_oStates[1]; }
+		const Button &rightButton()  const noexcept { return m_oStates[MOUSE_BUTTON_RIGHT]; }
 
 		/// <summary>
 		/// Get the state of the middle mouse button at the time of the last call to
 		/// <c>prepare()</c>.
 		/// </summary>
-		const Button &middleButton() const noexcept { return m_oStates[2]; }
+		const Button &middleButton() const noexcept { return m_oStates[MOUSE_BUTTON_MIDDLE]; }
+
+		/// <summary>
+		/// Get the state of a mouse button at the time of the last call to <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		const Button &button(unsigned char iButtonID) const noexcept
+		{
+			return m_oStates[iButtonID];
+		}
+
+
+
+		/// <summary>
+		/// The time of the last call to <c>prepare()</c>.<para/>
+		/// All durations are measured relative to this point in time.
+		/// </summary>
+		Clock::time_point prepareTime() const noexcept { return m_tpPrepared; }
+
+		/// <summary>
+		/// The time a mouse button was last pressed, as of the last call to <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		Clock::time_point pressTime(unsigned char iButtonID) const noexcept
+		{
+			return m_oTimes.pressTime(iButtonID);
+		}
+
+		/// <summary>
+		/// The time a mouse button was last released, as of the last call to <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		Clock::time_point releaseTime(unsigned char iButtonID) const noexcept
+		{
+			return m_oTimes.releaseTime(iButtonID);
+		}
+
+		/// <summary>
+		/// How long a mouse button has been held down at the time of the last call to
+		/// <c>prepare()</c>.<para/>
+		/// Zero if it isn't currently down.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		Clock::duration heldFor(unsigned char iButtonID) const noexcept
+		{
+			return m_oTimes.heldFor(iButtonID, button(iButtonID).bDown, m_tpPrepared);
+		}
+
+		/// <summary>
+		/// The time between the last press of a mouse button and the last call to <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		Clock::duration timeSincePressed(unsigned char iButtonID) const noexcept
+		{
+			return m_tpPrepared - m_oTimes.pressTime(iButtonID);
+		}
+
+		/// <summary>
+		/// The time between the last release of a mouse button and the last call to
+		/// <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		Clock::duration timeSinceReleased(unsigned char iButtonID) const noexcept
+		{
+			return m_tpPrepared - m_oTimes.releaseTime(iButtonID);
+		}
+
+		/// <summary>
+		/// Has a mouse button been held down for at least <c>tThreshold</c> at the time of the last
+		/// call to <c>prepare()</c>?
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		bool longPressed(unsigned char iButtonID, Clock::duration tThreshold) const noexcept
+		{
+			return button(iButtonID).bDown && heldFor(iButtonID) >= tThreshold;
+		}
 
 
 
@@ -109,6 +352,118 @@ namespace rlInput
 		/// </summary>
 		auto y() const noexcept { return m_iCachedClientY; }
 
+		/// <summary>
+		/// Get the smoothed horizontal client position of the cursor at the time of the last call
+		/// to <c>prepare()</c>.<para/>
+		/// Equal to <c>x()</c> unless the position filter is enabled (see
+		/// <c>setPositionFilter()</c>).
+		/// </summary>
+		auto filteredX() const noexcept { return m_fCachedFilteredX; }
+		/// <summary>
+		/// Get the smoothed vertical client position of the cursor at the time of the last call to
+		/// <c>prepare()</c>.<para/>
+		/// Equal to <c>y()</c> unless the position filter is enabled (see
+		/// <c>setPositionFilter()</c>).
+		/// </summary>
+		auto filteredY() const noexcept { return m_fCachedFilteredY; }
+
+		/// <summary>
+		/// Enable or disable the smoothing of the cursor position.<para/>
+		/// The filter is fed with every <c>WM_MOUSEMOVE</c> message and once per call to
+		/// <c>prepare()</c>.
+		/// </summary>
+		void setPositionFilter(bool bEnabled,
+			const OneEuroFilter::Settings &oSettings = {}) noexcept;
+
+		/// <summary>
+		/// Is the smoothing of the cursor position enabled?
+		/// </summary>
+		bool positionFilterEnabled() const noexcept { return m_bFilterEnabled; }
+
+		/// <summary>
+		/// Set the method used by <c>predictedX()</c> and <c>predictedY()</c>.<para/>
+		/// The prediction is based on the filtered position if the position filter is enabled.
+		/// </summary>
+		void setPrediction(const MotionPredictor::Settings &oSettings) noexcept;
+
+		/// <summary>
+		/// The method used by <c>predictedX()</c> and <c>predictedY()</c>.
+		/// </summary>
+		const MotionPredictor::Settings &prediction() const noexcept
+		{
+			return m_oPredictors[0].settings();
+		}
+
+		/// <summary>
+		/// Predict the horizontal client position of the cursor at a point in time (e.g. the time
+		/// the next frame will be presented), based on the movement up to the last call to
+		/// <c>prepare()</c>.
+		/// </summary>
+		float predictedX(Clock::time_point tpTime) const noexcept
+		{
+			return m_oCachedPredictors[0].predict(tpTime);
+		}
+		/// <summary>
+		/// Predict the vertical client position of the cursor at a point in time (e.g. the time the
+		/// next frame will be presented), based on the movement up to the last call to
+		/// <c>prepare()</c>.
+		/// </summary>
+		float predictedY(Clock::time_point tpTime) const noexcept
+		{
+			return m_oCachedPredictors[1].predict(tpTime);
+		}
+
+
+
+		/// <summary>
+		/// Get the gestures (drag, flick, press-and-hold) of a mouse button recognized by the last
+		/// call to <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iButtonID">One of the <c>MOUSE_BUTTON_[...]</c> constants.</param>
+		const Gesture &gesture(unsigned char iButtonID) const noexcept
+		{
+			return m_oGestures[iButtonID].state();
+		}
+
+		/// <summary>
+		/// The thresholds used for recognizing gestures.
+		/// </summary>
+		const GestureSettings &gestureSettings() const noexcept
+		{
+			return m_oGestures[0].settings();
+		}
+
+		/// <summary>
+		/// Set the thresholds used for recognizing gestures of all mouse buttons.
+		/// </summary>
+		void setGestureSettings(const GestureSettings &oSettings) noexcept;
+
+
+
+		/// <summary>
+		/// Set up the recording of all cursor positions between two calls to <c>prepare()</c>.
+		/// <para/>
+		/// The buffers are allocated once by this function; <c>update()</c> and
+		/// <c>prepare()</c> never allocate.
+		/// </summary>
+		/// <param name="iCapacity">
+		/// The maximum count of points per frame. 0 disables the path history.
+		/// </param>
+		/// <param name="eDecimation">What to do when more points are recorded.</param>
+		void setPathHistory(size_t iCapacity, PathDecimation eDecimation = PathDecimation::Halve);
+
+		/// <summary>
+		/// All cursor positions recorded between the previous and the last call to
+		/// <c>prepare()</c>, in chronological order.<para/>
+		/// Empty if the path history is disabled (see <c>setPathHistory()</c>).
+		/// </summary>
+		std::span<const PathPoint> path() const noexcept { return m_oCachedPath; }
+
+		/// <summary>
+		/// The memory resource passed to the constructor.
+		/// </summary>
+		std::pmr::memory_resource *memoryResource() const noexcept { return m_pMemory; }
+
 
 
 		/// <summary>
@@ -126,21 +481,168 @@ namespace rlInput
 		auto weelRotation() const noexcept { return m_iCachedWheelRotation; }
 
 
+
+		/// <summary>
+		/// Register the mouse for Raw Input (<c>WM_INPUT</c>) messages of a window.<para/>
+		/// Required for <c>deltaX()</c>, <c>deltaY()</c> and the per-device states (see
+		/// <c>seat()</c>).
+		/// </summary>
+		/// <param name="bBackground">
+		/// Should input also be received while the window is not in the foreground?
+		/// </param>
+		/// <returns>Could the mouse be registered?</returns>
+		bool enableRawInput(HWND hWnd, bool bBackground = false) noexcept;
+
+		/// <summary>
+		/// Set the factor raw mouse movement is multiplied with before being returned by
+		/// <c>deltaX()</c> and <c>deltaY()</c>.<para/>
+		/// The default is 1, meaning the values are in device units (mickeys).
+		/// </summary>
+		void setRawScale(double dScale) noexcept { m_dRawScale = dScale; }
+
+		/// <summary>
+		/// The factor raw mouse movement is multiplied with.
+		/// </summary>
+		auto rawScale() const noexcept { return m_dRawScale; }
+
+		/// <summary>
+		/// The horizontal raw mouse movement between the previous and the last call to
+		/// <c>prepare()</c>.<para/>
+		/// Not affected by the screen edges or the pointer acceleration of the OS. Only available
+		/// after a successful call to <c>enableRawInput()</c>.
+		/// </summary>
+		auto deltaX() const noexcept { return m_dCachedDeltaX; }
+
+		/// <summary>
+		/// The vertical raw mouse movement between the previous and the last call to
+		/// <c>prepare()</c>.<para/>
+		/// Not affected by the screen edges or the pointer acceleration of the OS. Only available
+		/// after a successful call to <c>enableRawInput()</c>.
+		/// </summary>
+		auto deltaY() const noexcept { return m_dCachedDeltaY; }
+
+		/// <summary>
+		/// The count of physical mice that have sent input so far (requires
+		/// <c>enableRawInput()</c>).<para/>
+		/// Seats are never removed, so indices stay valid. At most <c>MaxSeats</c>.
+		/// </summary>
+		size_t seatCount() const noexcept { return m_oSeatMap.size(); }
+
+		/// <summary>
+		/// Get the state of a single physical mouse at the time of the last call to
+		/// <c>prepare()</c>.
+		/// </summary>
+		/// <param name="iSeat">
+		/// The index of the mouse. Must be less than <c>seatCount()</c>.
+		/// </param>
+		const Seat &seat(size_t iSeat) const noexcept { return m_oSeats[iSeat]; }
+
+		/// <summary>
+		/// Get the seat index of a Raw Input device.
+		/// </summary>
+		/// <returns>
+		/// The index of the mouse, or <c>size_t(-1)</c> if it hasn't sent any input so far.
+		/// </returns>
+		size_t seatIndex(HANDLE hDevice) const noexcept { return m_oSeatMap.find(hDevice); }
+
+
+
+		/// <summary>
+		/// The list of coroutines waiting for a mouse button to be clicked.<para/>
+		/// Usually accessed via <c>rlInput::pressed()</c> (see <c>Awaitable.hpp</c>).
+		/// </summary>
+		WaitList &pressedWaitList(unsigned char iButtonID) noexcept
+		{
+			return m_oPressedWaiters[iButtonID];
+		}
+
+		/// <summary>
+		/// The list of coroutines waiting for a mouse button to be released.<para/>
+		/// Usually accessed via <c>rlInput::released()</c> (see <c>Awaitable.hpp</c>).
+		/// </summary>
+		WaitList &releasedWaitList(unsigned char iButtonID) noexcept
+		{
+			return m_oReleasedWaiters[iButtonID];
+		}
+
+		/// <summary>
+		/// The callbacks called by <c>prepare()</c> when a mouse button was clicked.<para/>
+		/// The input index is one of the <c>MOUSE_BUTTON_[...]</c> constants.
+		/// </summary>
+		CallbackTable &clickedCallbacks() noexcept { return m_oClickedCallbacks; }
+
+		/// <summary>
+		/// The callbacks called by <c>prepare()</c> when a mouse button was double clicked.
+		/// <para/>
+		/// The input index is one of the <c>MOUSE_BUTTON_[...]</c> constants.
+		/// </summary>
+		CallbackTable &doubleClickedCallbacks() noexcept { return m_oDoubleClickedCallbacks; }
+
+		/// <summary>
+		/// The callbacks called by <c>prepare()</c> when a mouse button was released.<para/>
+		/// The input index is one of the <c>MOUSE_BUTTON_[...]</c> constants.
+		/// </summary>
+		CallbackTable &releasedCallbacks() noexcept { return m_oReleasedCallbacks; }
+
+		/// <summary>
+		/// The callbacks called by <c>prepare()</c> when the mouse wheel was rotated.<para/>
+		/// There's only a single input (index 0); query the rotation via <c>weelRotation()</c>.
+		/// </summary>
+		CallbackTable &wheelCallbacks() noexcept { return m_oWheelCallbacks; }
+
+
+
+		/// <summary>
+		/// The instrumentation counters (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// </summary>
+		const DeviceStats &stats() const noexcept { return m_oStats.stats(); }
+
+		/// <summary>
+		/// The time between inputs entering <c>update()</c> and the <c>prepare()</c> call that
+		/// surfaced them (see <c>RLINPUT_ENABLE_STATS</c>).
+		/// </summary>
+		const LatencyHistogram &latency() const noexcept { return m_oStats.latency(); }
+
+		void resetStats() noexcept { m_oStats.reset(); }
+
+
 	private: // methods
 
-		Mouse()  = default; // --> singleton
-		~Mouse() = default;
+		// must only handle the messages listed in Messages
+		bool processMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept;
 
 		void beginCapture(HWND hWnd);
 		void endCapture();
 
+		void processRawInput(HRAWINPUT hRawInput) noexcept;
+		void addPathPoint(int iX, int iY) noexcept;
+		// only new positions (bMotion) are passed to the predictors; repeating a position would
+		// make them estimate zero velocity
+		void sampleFilters(Clock::time_point tpTime, bool bMotion) noexcept;
+
 
 	private: // variables
 
+		std::pmr::memory_resource *const m_pMemory; // must be declared first
+
 		Button m_oStates[3]{};
 		bool m_oRawStates_Old[3]{};
 		bool m_oRawStates_New[3]{};
 		bool m_oDoubleClicked[3]{};
+		Clock::time_point m_oRawTimes[3]{}; // time of the last change of m_oRawStates_New
+
+		InputTimes<3> m_oTimes;
+		Clock::time_point m_tpPrepared{};
+
+		GestureRecognizer m_oGestures[3];
+
+		WaitList m_oPressedWaiters[3];
+		WaitList m_oReleasedWaiters[3];
+
+		CallbackTable m_oClickedCallbacks{ 3, m_pMemory };
+		CallbackTable m_oDoubleClickedCallbacks{ 3, m_pMemory };
+		CallbackTable m_oReleasedCallbacks{ 3, m_pMemory };
+		CallbackTable m_oWheelCallbacks{ 1, m_pMemory };
 
 		int m_iClientX = 0;
 		int m_iClientY = 0;
@@ -155,6 +657,45 @@ namespace rlInput
 		bool m_bCachedOnClient      = false;
 		int  m_iCachedWheelRotation = 0;
 
+		// filtering and prediction
+		bool m_bFilterEnabled = false;
+		OneEuroFilter m_oFilters[2]; // x, y
+		MotionPredictor m_oPredictors[2];
+		MotionPredictor m_oCachedPredictors[2]; // copied from m_oPredictors in prepare()
+		Clock::time_point m_tpFiltered{}; // time of the last sample passed to the filters
+		Clock::time_point m_tpPredicted{}; // time of the last sample passed to the predictors
+		float m_fFilteredX = 0.0f;
+		float m_fFilteredY = 0.0f;
+		float m_fCachedFilteredX = 0.0f;
+		float m_fCachedFilteredY = 0.0f;
+
+		// Raw Input
+		// Relative movement is summed up as integers, so there's neither saturation nor rounding.
+		long long m_iRawDeltaX = 0;
+		long long m_iRawDeltaY = 0;
+		double m_dAbsoluteDeltaX = 0.0; // movement of absolute devices (tablets, remote desktop)
+		double m_dAbsoluteDeltaY = 0.0;
+		double m_dLastAbsoluteX  = 0.0;
+		double m_dLastAbsoluteY  = 0.0;
+		bool   m_bHasAbsolute    = false;
+		double m_dRawScale       = 1.0;
+
+		double m_dCachedDeltaX = 0.0;
+		double m_dCachedDeltaY = 0.0;
+
+		DeviceMap<MaxSeats> m_oSeatMap;
+		Seat m_oSeats[MaxSeats];
+
+		// path history
+		size_t m_iPathCapacity = 0;
+		PathDecimation m_ePathDecimation = PathDecimation::Halve;
+		std::pmr::vector<PathPoint> m_oPath{ m_pMemory }; // never grows beyond m_iPathCapacity
+		std::pmr::vector<PathPoint> m_oCachedPath{ m_pMemory }; // swapped with m_oPath
+
+		StatsRecorder m_oStats;
+		// oldest movement/wheel input not yet surfaced by prepare(); only set if stats are enabled
+		Clock::time_point m_tpPendingMotion{};
+
 	};
 
 }
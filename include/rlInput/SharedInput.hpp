@@ -0,0 +1,164 @@
+#pragma once
+#ifndef RLINPUT_SHAREDINPUT
+#define RLINPUT_SHAREDINPUT
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+#include <rlInput/InputCodec.hpp>
+
+// STL
+#include <cstdint>
+#include <type_traits>
+
+// Win32
+#define WIN32_MEAN_AND_LEAN
+#define NOMINMAX
+#include <Windows.h>
+#undef WIN32_MEAN_AND_LEAN
+#undef NOMINMAX
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// The state of a DirectInput gamepad in a <c>SharedInputState</c>.
+	/// </summary>
+	struct SharedDirectInputPad
+	{
+		GUID     guidInstance; // identifies the gamepad (see DirectInput::Gamepad::guidInstance())
+		bool     bConnected;
+		uint32_t iButtons;     // bit = index in DirectInput::Gamepad::buttons()
+		int32_t  oAxes[6];     // index = one of the DINPUT_AXIS_[...] constants
+	};
+
+	/// <summary>
+	/// The input state an <c>InputPublisher</c> shares with other processes.
+	/// </summary>
+	struct SharedInputState
+	{
+		/// <summary>
+		/// The maximum count of DirectInput gamepads in a state.
+		/// </summary>
+		static constexpr size_t MaxDirectInputPads = 8;
+
+		uint64_t          iFrame;      // count of states published so far, including this one
+		Clock::time_point tpPublished; // same clock in all processes of the machine
+		int32_t           iMouseX;     // client position (see Mouse::x())
+		int32_t           iMouseY;     // client position (see Mouse::y())
+		InputSnapshot     oInput;      // keyboard, mouse and XInput gamepads
+
+		/// <summary>
+		/// The first <c>MaxDirectInputPads</c> gamepads of <c>DirectInput::gamepads()</c>.<para/>
+		/// Only <c>iDirectInputPads</c> entries are valid. The order can change when gamepads are
+		/// removed; use <c>guidInstance</c> to follow a gamepad.
+		/// </summary>
+		SharedDirectInputPad oDirectInputPads[MaxDirectInputPads];
+		uint32_t iDirectInputPads;
+	};
+
+	static_assert(std::is_trivially_copyable_v<SharedInputState>);
+
+	struct SharedInputBlock; // the layout of the shared memory
+
+
+
+	/// <summary>
+	/// Publishes input states in a named shared memory segment, for other processes (overlays,
+	/// recording tools, test harnesses) to read via <c>InputReader</c>.<para/>
+	/// The segment is protected by a sequence lock: <c>publish()</c> never waits for readers
+	/// and doesn't make any system calls. There should be only one publisher per name.
+	/// </summary>
+	class InputPublisher final
+	{
+	public: // static variables
+
+		static constexpr const wchar_t *DefaultName = L"Local\\rlInput.SharedInput";
+
+
+	public: // methods
+
+		/// <summary>
+		/// Create (or open) the shared memory segment.<para/>
+		/// Throws an <c>std::exception</c> if that fails.
+		/// </summary>
+		explicit InputPublisher(const wchar_t *szName = DefaultName);
+		~InputPublisher();
+
+		InputPublisher(const InputPublisher &) = delete;
+		InputPublisher &operator=(const InputPublisher &) = delete;
+
+		/// <summary>
+		/// Publish a state. <c>iFrame</c> and <c>tpPublished</c> are set automatically.
+		/// </summary>
+		void publish(const SharedInputState &oState) noexcept;
+
+		/// <summary>
+		/// The count of states published in the segment so far (also by previous publishers).
+		/// </summary>
+		uint64_t frame() const noexcept { return m_iFrame; }
+
+
+	private: // variables
+
+		HANDLE m_hMapping = NULL;
+		SharedInputBlock *m_pBlock = nullptr;
+		uint64_t m_iFrame = 0;
+
+	};
+
+
+
+	/// <summary>
+	/// Reads the input states published by an <c>InputPublisher</c>, usually in another process.
+	/// <para/>
+	/// Reading is lock-free and doesn't make any system calls.
+	/// </summary>
+	class InputReader final
+	{
+	public: // methods
+
+		/// <summary>
+		/// Open the shared memory segment of a publisher.<para/>
+		/// Throws an <c>std::exception</c> if there's no publisher with this name.
+		/// </summary>
+		explicit InputReader(const wchar_t *szName = InputPublisher::DefaultName);
+		~InputReader();
+
+		InputReader(const InputReader &) = delete;
+		InputReader &operator=(const InputReader &) = delete;
+
+		/// <summary>
+		/// Read the last published state.<para/>
+		/// Retries while the publisher is writing.
+		/// </summary>
+		/// <returns>
+		/// Was a consistent state read? <c>FALSE</c> if nothing was published yet or the
+		/// publisher kept writing during all <c>iMaxAttempts</c> attempts.
+		/// </returns>
+		bool read(SharedInputState &oDest, unsigned iMaxAttempts = 64) const noexcept;
+
+		/// <summary>
+		/// The count of states published so far. Cheap, for checking whether there's a new one.
+		/// </summary>
+		uint64_t frame() const noexcept;
+
+
+	private: // variables
+
+		HANDLE m_hMapping = NULL;
+		SharedInputBlock *m_pBlock = nullptr; // mapped read-only
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_SHAREDINPUT
\ No newline at end of file
@@ -0,0 +1,220 @@
+#pragma once
+#ifndef RLINPUT_SLOTMAP
+#define RLINPUT_SLOTMAP
+
+
+
+
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// A stable reference to a device (see <c>SlotMap</c>).<para/>
+	/// Stays valid while the device exists, independent of (dis)connections of the physical
+	/// device. Once the device was destroyed, lookups via the handle fail instead of dangling.
+	/// <para/>
+	/// Default-constructed handles are never valid.
+	/// </summary>
+	struct DeviceHandle
+	{
+		uint32_t iIndex      = uint32_t(-1);
+		uint32_t iGeneration = 0; // odd while the slot is in use
+
+		explicit operator bool() const noexcept { return iGeneration & 1; }
+
+		friend bool operator==(const DeviceHandle &, const DeviceHandle &) noexcept = default;
+	};
+
+
+
+	/// <summary>
+	/// A generational slot map.<para/>
+	/// The values are stored contiguously (in no particular order), lookups via a
+	/// <c>DeviceHandle</c> are O(1). Removing a value invalidates its handle for good: the slot's
+	/// generation is increased, so stale handles are detected even after the slot was reused.
+	/// <para/>
+	/// Only <c>insert()</c> and <c>reserve()</c> allocate, from the
+	/// <c>std::pmr::memory_resource</c> passed to the constructor.
+	/// </summary>
+	template <typename T>
+	class SlotMap final
+	{
+		static_assert(std::is_nothrow_move_constructible_v<T> &&
+			std::is_nothrow_move_assignable_v<T>, "SlotMap: T must be nothrow movable");
+
+	public: // methods
+
+		explicit SlotMap(std::pmr::memory_resource *pMemory = std::pmr::get_default_resource()) :
+			m_oValues(pMemory), m_oValueSlots(pMemory), m_oSlots(pMemory)
+		{}
+
+		/// <summary>
+		/// The count of values in the map.
+		/// </summary>
+		size_t size() const noexcept { return m_oValues.size(); }
+
+		bool empty() const noexcept { return m_oValues.empty(); }
+
+		/// <summary>
+		/// Make sure a certain count of values can be inserted without allocating.
+		/// </summary>
+		void reserve(size_t iCount)
+		{
+			m_oValues.reserve(iCount);
+			m_oValueSlots.reserve(iCount);
+			m_oSlots.reserve(iCount);
+		}
+
+		/// <summary>
+		/// Add a value to the map.<para/>
+		/// If an exception is thrown, the map stays unchanged.
+		/// </summary>
+		/// <returns>The handle of the new value.</returns>
+		DeviceHandle insert(T oValue)
+		{
+			const size_t iCount = m_oValues.size() + 1;
+			if (m_oValues.capacity() < iCount)
+				m_oValues.reserve(iCount * 2);
+			if (m_oValueSlots.capacity() < iCount)
+				m_oValueSlots.reserve(iCount * 2);
+			if (m_iFirstFree == NoSlot && m_oSlots.capacity() < m_oSlots.size() + 1)
+				m_oSlots.reserve((m_oSlots.size() + 1) * 2);
+
+			// --> nothing below throws
+
+			uint32_t iSlot;
+			if (m_iFirstFree != NoSlot)
+			{
+				iSlot        = m_iFirstFree;
+				m_iFirstFree = m_oSlots[iSlot].iValue;
+			}
+			else
+			{
+				iSlot = uint32_t(m_oSlots.size());
+				m_oSlots.push_back({ 0, 0 });
+			}
+
+			auto &oSlot = m_oSlots[iSlot];
+			oSlot.iValue = uint32_t(m_oValues.size());
+			++oSlot.iGeneration; // --> odd
+
+			m_oValues.push_back(std::move(oValue));
+			m_oValueSlots.push_back(iSlot);
+
+			return { iSlot, oSlot.iGeneration };
+		}
+
+		/// <summary>
+		/// Remove a value from the map.<para/>
+		/// The last value is moved to the position of the removed one.
+		/// </summary>
+		/// <returns>Was the handle valid?</returns>
+		bool erase(DeviceHandle hValue) noexcept
+		{
+			if (!contains(hValue))
+				return false;
+
+			auto &oSlot = m_oSlots[hValue.iIndex];
+			const uint32_t iValue = oSlot.iValue;
+			const uint32_t iLast  = uint32_t(m_oValues.size() - 1);
+			if (iValue != iLast)
+			{
+				m_oValues[iValue]     = std::move(m_oValues[iLast]);
+				m_oValueSlots[iValue] = m_oValueSlots[iLast];
+				m_oSlots[m_oValueSlots[iValue]].iValue = iValue;
+			}
+			m_oValues.pop_back();
+			m_oValueSlots.pop_back();
+
+			++oSlot.iGeneration; // --> even
+			oSlot.iValue = m_iFirstFree;
+			m_iFirstFree = hValue.iIndex;
+			return true;
+		}
+
+		/// <summary>
+		/// Does a handle reference a value in the map?
+		/// </summary>
+		bool contains(DeviceHandle hValue) const noexcept
+		{
+			return hValue && hValue.iIndex < m_oSlots.size() &&
+				m_oSlots[hValue.iIndex].iGeneration == hValue.iGeneration;
+		}
+
+		/// <summary>
+		/// Get the value a handle references.
+		/// </summary>
+		/// <returns>The value, or <c>nullptr</c> if the handle is invalid or stale.</returns>
+		T *find(DeviceHandle hValue) noexcept
+		{
+			return contains(hValue) ? &m_oValues[m_oSlots[hValue.iIndex].iValue] : nullptr;
+		}
+
+		const T *find(DeviceHandle hValue) const noexcept
+		{
+			return contains(hValue) ? &m_oValues[m_oSlots[hValue.iIndex].iValue] : nullptr;
+		}
+
+		/// <summary>
+		/// The handle of the value at a certain position of <c>values()</c>.
+		/// </summary>
+		DeviceHandle handle(size_t iPosition) const noexcept
+		{
+			const uint32_t iSlot = m_oValueSlots[iPosition];
+			return { iSlot, m_oSlots[iSlot].iGeneration };
+		}
+
+		/// <summary>
+		/// All values, contiguously. The order changes when values are removed.
+		/// </summary>
+		std::span<T>       values()       noexcept { return m_oValues; }
+		std::span<const T> values() const noexcept { return m_oValues; }
+
+		auto begin()       noexcept { return m_oValues.begin(); }
+		auto end()         noexcept { return m_oValues.end(); }
+		auto begin() const noexcept { return m_oValues.begin(); }
+		auto end()   const noexcept { return m_oValues.end(); }
+
+
+	private: // types
+
+		struct Slot
+		{
+			uint32_t iValue;      // index in m_oValues, or the next free slot
+			uint32_t iGeneration; // odd while in use
+		};
+
+
+	private: // static variables
+
+		static constexpr uint32_t NoSlot = uint32_t(-1);
+
+
+	private: // variables
+
+		std::pmr::vector<T>        m_oValues;
+		std::pmr::vector<uint32_t> m_oValueSlots; // the slot of each value
+		std::pmr::vector<Slot>     m_oSlots;
+		uint32_t m_iFirstFree = NoSlot;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_SLOTMAP
\ No newline at end of file
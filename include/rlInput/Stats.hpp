@@ -0,0 +1,339 @@
+#pragma once
+#ifndef RLINPUT_STATS
+#define RLINPUT_STATS
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+// STL
+#include <bit>
+#include <cstdint>
+
+
+
+/// <summary>
+/// Define as 1 (for the library <b>and</b> all code using it) to collect <c>DeviceStats</c> and
+/// latency histograms.
+/// <para/>
+/// If 0 (the default), the counters don't exist and <c>stats()</c> always returns zeros.
+/// </summary>
+#ifndef RLINPUT_ENABLE_STATS
+#define RLINPUT_ENABLE_STATS 0
+#endif
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// Instrumentation counters of a device (see <c>RLINPUT_ENABLE_STATS</c>).
+	/// </summary>
+	struct DeviceStats
+	{
+		struct Counters
+		{
+			uint64_t iMessagesHandled;  // update() returned true
+			uint64_t iMessagesIgnored;  // update() returned false
+			uint64_t iPrepares;         // calls to prepare()
+			uint64_t iPrepareNanoseconds;
+			uint64_t iPolls;            // XInputGetState() / IDirectInputDevice8::Poll() calls
+			uint64_t iPollFailures;
+			uint64_t iAcquireFailures;  // IDirectInputDevice8::Acquire() failed
+			uint64_t iReconnects;       // the device was connected again after being absent
+			uint64_t iTextCharacters;   // code points recorded
+			uint64_t iOverflows;        // text ring overflows, mouse path decimations
+		};
+
+		Counters oTotal;     // since the creation of the device or the last resetStats()
+		Counters oLastFrame; // between the previous and the last call to prepare()
+	};
+
+
+
+	/// <summary>
+	/// A streaming histogram of durations in fixed memory.<para/>
+	/// Values are bucketed with a relative error of at most 1/16 (exact below 32 microseconds);
+	/// values above about 134 seconds end up in the last bucket. The maximum is exact.
+	/// </summary>
+	class LatencyHistogram final
+	{
+	public: // methods
+
+		void record(Clock::duration tdValue) noexcept
+		{
+			const auto iMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+				tdValue).count();
+			const uint64_t iValue = iMicroseconds > 0 ? uint64_t(iMicroseconds) : 0;
+
+			++m_oBuckets[BucketIndex(iValue)];
+			++m_iCount;
+			if (tdValue > m_tdMax)
+				m_tdMax = tdValue;
+		}
+
+		/// <summary>
+		/// The count of recorded values.
+		/// </summary>
+		uint64_t count() const noexcept { return m_iCount; }
+
+		/// <summary>
+		/// The largest recorded value.
+		/// </summary>
+		Clock::duration max() const noexcept { return m_tdMax; }
+
+		/// <summary>
+		/// Get a percentile of the recorded values.
+		/// </summary>
+		/// <param name="dPercentile">The percentile, between 0 and 100 (e.g. 99 for p99).</param>
+		/// <returns>
+		/// The upper bound of the bucket the percentile falls into, at most <c>max()</c>.<para/>
+		/// Zero if no values were recorded.
+		/// </returns>
+		Clock::duration percentile(double dPercentile) const noexcept
+		{
+			if (m_iCount == 0)
+				return {};
+
+			uint64_t iRank = uint64_t(dPercentile / 100.0 * double(m_iCount) + 0.5);
+			if (iRank < 1)
+				iRank = 1;
+			else if (iRank > m_iCount)
+				iRank = m_iCount;
+
+			uint64_t iSum = 0;
+			for (size_t i = 0; i < BucketCount; ++i)
+			{
+				iSum += m_oBuckets[i];
+				if (iSum < iRank)
+					continue;
+
+				const Clock::duration tdUpper = std::chrono::duration_cast<Clock::duration>(
+					std::chrono::microseconds(BucketUpperBound(i)));
+				return tdUpper < m_tdMax ? tdUpper : m_tdMax;
+			}
+			return m_tdMax;
+		}
+
+		Clock::duration p50() const noexcept { return percentile(50); }
+		Clock::duration p95() const noexcept { return percentile(95); }
+		Clock::duration p99() const noexcept { return percentile(99); }
+
+		void reset() noexcept { *this = {}; }
+
+
+	private: // static variables
+
+		// 16 sub-buckets per power of two
+		static constexpr unsigned SubBucketBits = 4;
+		static constexpr unsigned SubBuckets    = 1u << SubBucketBits;
+		static constexpr unsigned MaxExponent   = 22; // --> up to 2^27 microseconds
+		static constexpr size_t   BucketCount   = SubBuckets * (MaxExponent + 2);
+
+
+	private: // static methods
+
+		static size_t BucketIndex(uint64_t iValue) noexcept
+		{
+			if (iValue < 2 * SubBuckets)
+				return size_t(iValue);
+
+			const unsigned iExponent = unsigned(std::bit_width(iValue)) - (SubBucketBits + 1);
+			if (iExponent > MaxExponent)
+				return BucketCount - 1;
+
+			return size_t(SubBuckets * iExponent + (iValue >> iExponent));
+		}
+
+		static uint64_t BucketUpperBound(size_t iIndex) noexcept
+		{
+			if (iIndex < 2 * SubBuckets)
+				return iIndex;
+
+			const unsigned iExponent = unsigned(iIndex / SubBuckets) - 1;
+			const uint64_t iMantissa = iIndex % SubBuckets + SubBuckets;
+			return ((iMantissa + 1) << iExponent) - 1;
+		}
+
+
+	private: // variables
+
+		uint64_t m_oBuckets[BucketCount]{};
+		uint64_t m_iCount = 0;
+		Clock::duration m_tdMax{};
+
+	};
+
+
+
+	/// <summary>
+	/// The counting part of a device. Has no state if <c>RLINPUT_ENABLE_STATS</c> is 0.
+	/// </summary>
+	class StatsRecorder final
+	{
+	public: // types
+
+		using Counter = uint64_t DeviceStats::Counters::*;
+
+		/// <summary>
+		/// Measures a call to <c>prepare()</c> and closes the frame when destroyed.
+		/// </summary>
+		class PrepareScope final
+		{
+		public: // methods
+
+#if RLINPUT_ENABLE_STATS
+			explicit PrepareScope(StatsRecorder &oRecorder) noexcept :
+				m_oRecorder(oRecorder), m_tpStart(Clock::now()) {}
+			~PrepareScope()
+			{
+				const auto iNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					Clock::now() - m_tpStart).count();
+
+				m_oRecorder.count(&DeviceStats::Counters::iPrepares);
+				m_oRecorder.count(&DeviceStats::Counters::iPrepareNanoseconds,
+					uint64_t(iNanoseconds));
+				m_oRecorder.endFrame();
+			}
+#else
+			explicit PrepareScope(StatsRecorder &) noexcept {}
+#endif
+			PrepareScope(const PrepareScope &) = delete;
+			PrepareScope &operator=(const PrepareScope &) = delete;
+
+
+#if RLINPUT_ENABLE_STATS
+		private: // variables
+
+			StatsRecorder &m_oRecorder;
+			const Clock::time_point m_tpStart;
+#endif
+
+		};
+
+
+	public: // static variables
+
+		static constexpr bool Enabled = RLINPUT_ENABLE_STATS != 0;
+
+
+	public: // methods
+
+#if RLINPUT_ENABLE_STATS
+
+		const DeviceStats &stats() const noexcept { return m_oStats; }
+
+		void count(Counter pCounter, uint64_t iCount = 1) noexcept
+		{
+			m_oStats.oTotal.*pCounter += iCount;
+		}
+
+		void countMessage(bool bHandled) noexcept
+		{
+			++(bHandled ? m_oStats.oTotal.iMessagesHandled : m_oStats.oTotal.iMessagesIgnored);
+		}
+
+		/// <summary>
+		/// The time between inputs entering the library and the <c>prepare()</c> call that
+		/// surfaced them.
+		/// </summary>
+		const LatencyHistogram &latency() const noexcept { return m_oLatency; }
+
+		/// <summary>
+		/// Record the latency of an input.
+		/// </summary>
+		/// <param name="tpInput">The time the input entered <c>update()</c> or was sampled.</param>
+		/// <param name="tpSurfaced">The time of the <c>prepare()</c> call that surfaced it.</param>
+		void recordLatency(Clock::time_point tpInput, Clock::time_point tpSurfaced) noexcept
+		{
+			m_oLatency.record(tpSurfaced - tpInput);
+		}
+
+		/// <summary>
+		/// Record the latency of an input, surfaced now.
+		/// </summary>
+		void recordLatency(Clock::time_point tpInput) noexcept
+		{
+			recordLatency(tpInput, Clock::now());
+		}
+
+		/// <summary>
+		/// Make the counts since the previous call available as <c>DeviceStats::oLastFrame</c>.
+		/// </summary>
+		void endFrame() noexcept
+		{
+			for (auto p : AllCounters)
+			{
+				m_oStats.oLastFrame.*p = m_oStats.oTotal.*p - m_oFrameStart.*p;
+			}
+			m_oFrameStart = m_oStats.oTotal;
+		}
+
+		void reset() noexcept
+		{
+			m_oStats      = {};
+			m_oFrameStart = {};
+			m_oLatency.reset();
+		}
+
+#else
+
+		const DeviceStats &stats() const noexcept
+		{
+			static constexpr DeviceStats oEmpty{};
+			return oEmpty;
+		}
+
+		const LatencyHistogram &latency() const noexcept
+		{
+			static const LatencyHistogram oEmpty;
+			return oEmpty;
+		}
+
+		void count(Counter, uint64_t = 1) noexcept {}
+		void countMessage(bool) noexcept {}
+		void recordLatency(Clock::time_point, Clock::time_point) noexcept {}
+		void recordLatency(Clock::time_point) noexcept {}
+		void endFrame() noexcept {}
+		void reset() noexcept {}
+
+#endif
+
+
+#if RLINPUT_ENABLE_STATS
+	private: // static variables
+
+		static constexpr Counter AllCounters[] =
+		{
+			&DeviceStats::Counters::iMessagesHandled,
+			&DeviceStats::Counters::iMessagesIgnored,
+			&DeviceStats::Counters::iPrepares,
+			&DeviceStats::Counters::iPrepareNanoseconds,
+			&DeviceStats::Counters::iPolls,
+			&DeviceStats::Counters::iPollFailures,
+			&DeviceStats::Counters::iAcquireFailures,
+			&DeviceStats::Counters::iReconnects,
+			&DeviceStats::Counters::iTextCharacters,
+			&DeviceStats::Counters::iOverflows
+		};
+
+
+	private: // variables
+
+		DeviceStats m_oStats{};
+		DeviceStats::Counters m_oFrameStart{};
+		LatencyHistogram m_oLatency;
+#endif
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_STATS
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+#ifndef RLINPUT_TEXTRING
+#define RLINPUT_TEXTRING
+
+
+
+
+
+// STL
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// A fixed-size ring buffer of UTF-8 (<c>char</c>) or UTF-16 (<c>wchar_t</c>) text.<para/>
+	/// Positions in the ring are counted in code units since its creation and never wrap, so
+	/// readers can keep their own cursor. Old text is overwritten once the ring is full.<para/>
+	/// Only <c>setCapacity()</c> allocates, from the <c>std::pmr::memory_resource</c> passed to the
+	/// constructor.
+	/// </summary>
+	template <typename TChar>
+	class TextRing final
+	{
+		static_assert(std::is_same_v<TChar, char> || std::is_same_v<TChar, wchar_t>,
+			"TextRing: UTF-8 (char) or UTF-16 (wchar_t) only");
+
+	public: // methods
+
+		explicit TextRing(
+			std::pmr::memory_resource *pMemory = std::pmr::get_default_resource()) noexcept :
+			m_oRing(pMemory), m_oFrame(pMemory)
+		{}
+
+		/// <summary>
+		/// Allocate the buffers and discard all text.
+		/// </summary>
+		/// <param name="iCapacity">
+		/// The count of code units kept. Rounded up to a power of two. 0 disables the ring.
+		/// </param>
+		void setCapacity(size_t iCapacity)
+		{
+			iCapacity = iCapacity ? std::bit_ceil(iCapacity) : 0;
+
+			// swap instead of assign() so a smaller capacity also releases memory
+			std::pmr::vector<TChar>(iCapacity, m_oRing.get_allocator()).swap(m_oRing);
+			std::pmr::vector<TChar>(iCapacity, m_oFrame.get_allocator()).swap(m_oFrame);
+			m_iCapacity    = iCapacity;
+			m_iEnd         = 0;
+			m_iFrameEnd    = 0;
+			m_iFrameLength = 0;
+		}
+
+		size_t capacity() const noexcept { return m_iCapacity; }
+
+		/// <summary>
+		/// The position of the oldest code unit still in the ring.
+		/// </summary>
+		uint64_t begin() const noexcept { return m_iEnd > m_iCapacity ? m_iEnd - m_iCapacity : 0; }
+
+		/// <summary>
+		/// The position after the newest code unit.
+		/// </summary>
+		uint64_t end() const noexcept { return m_iEnd; }
+
+		/// <summary>
+		/// Append complete code points.
+		/// </summary>
+		void append(const TChar *p, size_t iCount) noexcept
+		{
+			if (m_iCapacity == 0)
+				return;
+
+			for (size_t i = 0; i < iCount; ++i)
+			{
+				m_oRing[m_iEnd++ & (m_iCapacity - 1)] = p[i];
+			}
+		}
+
+		/// <summary>
+		/// Copy text from a position on.<para/>
+		/// Code points are never split. If the text at the cursor was already overwritten, the
+		/// cursor first skips to the oldest text still available.
+		/// </summary>
+		/// <param name="iCursor">
+		/// The position to read from. Is advanced behind the text that was copied.
+		/// </param>
+		/// <returns>The count of code units written to <c>pDest</c>.</returns>
+		size_t read(uint64_t &iCursor, TChar *pDest, size_t iDestSize) const noexcept
+		{
+			if (iCursor < begin())
+			{
+				iCursor = begin();
+				while (iCursor < m_iEnd && IsContinuation(at(iCursor)))
+				{
+					++iCursor;
+				}
+			}
+			if (iCursor >= m_iEnd)
+				return 0;
+
+			size_t iCount = size_t(m_iEnd - iCursor);
+			if (iCount > iDestSize)
+			{
+				iCount = iDestSize;
+				while (iCount > 0 && IsContinuation(at(iCursor + iCount)))
+				{
+					--iCount;
+				}
+			}
+
+			copy(iCursor, iCount, pDest);
+			iCursor += iCount;
+			return iCount;
+		}
+
+		/// <summary>
+		/// Make the text appended since the previous call available via <c>frame()</c>.
+		/// </summary>
+		/// <returns>
+		/// Was text lost because more than <c>capacity()</c> code units were appended?
+		/// </returns>
+		bool markFrame() noexcept
+		{
+			uint64_t iStart = m_iFrameEnd;
+			const bool bOverflow = iStart < begin();
+			if (bOverflow)
+			{
+				iStart = begin();
+				while (iStart < m_iEnd && IsContinuation(at(iStart)))
+				{
+					++iStart;
+				}
+			}
+
+			m_iFrameLength = size_t(m_iEnd - iStart);
+			copy(iStart, m_iFrameLength, m_oFrame.data());
+			m_iFrameEnd = m_iEnd;
+
+			return bOverflow;
+		}
+
+		/// <summary>
+		/// The text appended between the previous and the last call to <c>markFrame()</c>.
+		/// </summary>
+		std::basic_string_view<TChar> frame() const noexcept
+		{
+			return { m_oFrame.data(), m_iFrameLength };
+		}
+
+
+	private: // static methods
+
+		/// <summary>
+		/// Is a code unit not the start of a code point?
+		/// </summary>
+		static bool IsContinuation(TChar c) noexcept
+		{
+			if constexpr (sizeof(TChar) == 1)
+				return (uint8_t(c) & 0xC0) == 0x80;
+			else
+				return (uint16_t(c) & 0xFC00) == 0xDC00; // low surrogate
+		}
+
+
+	private: // methods
+
+		TChar at(uint64_t iPos) const noexcept { return m_oRing[iPos & (m_iCapacity - 1)]; }
+
+		void copy(uint64_t iPos, size_t iCount, TChar *pDest) const noexcept
+		{
+			if (iCount == 0)
+				return;
+
+			const size_t iOffset = size_t(iPos & (m_iCapacity - 1));
+			const size_t iFirst  = iCount < m_iCapacity - iOffset ? iCount : m_iCapacity - iOffset;
+
+			memcpy(pDest, m_oRing.data() + iOffset, iFirst * sizeof(TChar));
+			memcpy(pDest + iFirst, m_oRing.data(), (iCount - iFirst) * sizeof(TChar));
+		}
+
+
+	private: // variables
+
+		std::pmr::vector<TChar> m_oRing;
+		std::pmr::vector<TChar> m_oFrame; // contiguous copy of the last frame's text
+		size_t m_iCapacity = 0;
+
+		uint64_t m_iEnd         = 0;
+		uint64_t m_iFrameEnd    = 0;
+		size_t   m_iFrameLength = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_TEXTRING
\ No newline at end of file
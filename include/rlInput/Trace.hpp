@@ -0,0 +1,166 @@
+#pragma once
+#ifndef RLINPUT_TRACE
+#define RLINPUT_TRACE
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+// STL
+#include <atomic>
+#include <cstdint>
+
+
+
+/// <summary>
+/// Define as 0 to remove all trace points from the library.<para/>
+/// If 1 (the default), tracing is still off until <c>Tracer::Start()</c> is called; an inactive
+/// trace point costs a single relaxed atomic load.
+/// </summary>
+#ifndef RLINPUT_ENABLE_TRACE
+#define RLINPUT_ENABLE_TRACE 1
+#endif
+
+
+
+namespace rlInput
+{
+
+	/// <summary>
+	/// Writes spans and events to a Chrome Trace Event JSON file (readable by
+	/// <c>chrome://tracing</c> and Perfetto).<para/>
+	/// Every thread records into its own lock-free ring; a background thread writes the rings to
+	/// the file. Events are dropped (and counted) if a ring is full.<para/>
+	/// Timestamps are <c>Clock</c> time points in microseconds, so they line up with other traces
+	/// based on <c>QueryPerformanceCounter</c>.
+	/// </summary>
+	class Tracer final
+	{
+	public: // static variables
+
+		static constexpr uint64_t NoArg = uint64_t(-1);
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Start tracing to a file.
+		/// </summary>
+		/// <returns>
+		/// Was tracing started? <c>false</c> if the file couldn't be created or tracing is already
+		/// active.
+		/// </returns>
+		static bool Start(const wchar_t *szPath) noexcept;
+
+		/// <summary>
+		/// Stop tracing, write the remaining events and close the file.
+		/// </summary>
+		static void Stop() noexcept;
+
+		static bool Active() noexcept { return s_bActive.load(std::memory_order_relaxed); }
+
+		/// <summary>
+		/// Record a span (<c>"ph":"X"</c>).
+		/// </summary>
+		/// <param name="szName">
+		/// The name of the span. Must stay valid until tracing was stopped (e.g. a literal).
+		/// </param>
+		/// <param name="iArg">An optional numeric argument (e.g. a message ID).</param>
+		static void Span(const char *szName, Clock::time_point tpBegin, Clock::time_point tpEnd,
+			uint64_t iArg = NoArg) noexcept;
+
+		/// <summary>
+		/// Record an instant event (<c>"ph":"i"</c>).
+		/// </summary>
+		/// <param name="szName">
+		/// The name of the event. Must stay valid until tracing was stopped (e.g. a literal).
+		/// </param>
+		/// <param name="iArg">An optional numeric argument (e.g. a key code).</param>
+		static void Instant(const char *szName, uint64_t iArg = NoArg) noexcept;
+
+
+	private: // static variables
+
+		static std::atomic<bool> s_bActive;
+
+	};
+
+
+
+	/// <summary>
+	/// Records a span from its construction to its destruction, if tracing was active when it was
+	/// constructed.<para/>
+	/// Usually created via <c>RLINPUT_TRACE_SCOPE</c>.
+	/// </summary>
+	class TraceScope final
+	{
+	public: // methods
+
+		explicit TraceScope(const char *szName, uint64_t iArg = Tracer::NoArg) noexcept :
+			m_szName(Tracer::Active() ? szName : nullptr), m_iArg(iArg)
+		{
+			if (m_szName)
+				m_tpBegin = Clock::now();
+		}
+
+		~TraceScope()
+		{
+			if (m_szName)
+				Tracer::Span(m_szName, m_tpBegin, Clock::now(), m_iArg);
+		}
+
+		TraceScope(const TraceScope &) = delete;
+		TraceScope &operator=(const TraceScope &) = delete;
+
+
+	private: // variables
+
+		const char *m_szName;
+		uint64_t m_iArg;
+		Clock::time_point m_tpBegin{};
+
+	};
+
+}
+
+
+
+#define RLINPUT_TRACE_CONCAT_INNER(a, b) a##b
+#define RLINPUT_TRACE_CONCAT(a, b) RLINPUT_TRACE_CONCAT_INNER(a, b)
+
+#if RLINPUT_ENABLE_TRACE
+
+/// <summary>
+/// Trace the rest of the current scope as a span (see <c>Tracer</c>).
+/// </summary>
+#define RLINPUT_TRACE_SCOPE(szName) \
+	::rlInput::TraceScope RLINPUT_TRACE_CONCAT(oTraceScope_, __LINE__)(szName)
+
+/// <summary>
+/// Trace the rest of the current scope as a span with a numeric argument (see <c>Tracer</c>).
+/// </summary>
+#define RLINPUT_TRACE_SCOPE_ARG(szName, iArg) \
+	::rlInput::TraceScope RLINPUT_TRACE_CONCAT(oTraceScope_, __LINE__)(szName, uint64_t(iArg))
+
+/// <summary>
+/// Trace an instant event with a numeric argument (see <c>Tracer</c>).
+/// </summary>
+#define RLINPUT_TRACE_EVENT(szName, iArg) \
+	do { if (::rlInput::Tracer::Active()) ::rlInput::Tracer::Instant(szName, uint64_t(iArg)); } \
+	while (false)
+
+#else
+
+#define RLINPUT_TRACE_SCOPE(szName)           do {} while (false)
+#define RLINPUT_TRACE_SCOPE_ARG(szName, iArg) do {} while (false)
+#define RLINPUT_TRACE_EVENT(szName, iArg)     do {} while (false)
+
+#endif
+
+
+
+
+
+#endif // RLINPUT_TRACE
\ No newline at end of file
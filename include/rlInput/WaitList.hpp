@@ -0,0 +1,199 @@
+#pragma once
+#ifndef RLINPUT_WAITLIST
+#define RLINPUT_WAITLIST
+
+
+
+
+
+#include <rlInput/Clock.hpp>
+
+// STL
+#include <coroutine>
+#include <cstddef>
+
+
+
+namespace rlInput
+{
+
+	class WaitList;
+	class Waiter;
+
+
+
+	/// <summary>
+	/// A single condition a coroutine can wait for.<para/>
+	/// Either a change of an input (<c>pList</c> points to the wait list of that change) or a
+	/// point in time (<c>pList</c> is <c>nullptr</c>).
+	/// </summary>
+	struct Condition
+	{
+		WaitList *pList;
+		Clock::time_point tpDeadline;
+	};
+
+
+
+	/// <summary>
+	/// A coroutine suspended on one or more conditions.<para/>
+	/// The coroutine is resumed exactly once, by the first condition that is met.
+	/// </summary>
+	struct WaitGroup
+	{
+		std::coroutine_handle<> hCoroutine;
+		Waiter *pWaiters;
+		size_t iWaiterCount;
+		size_t iFired; // Index of the condition that resumed the coroutine.
+
+		/// <summary>
+		/// Link the waiters of this group to their conditions.
+		/// </summary>
+		/// <param name="pConditions">
+		/// An array of <c>iWaiterCount</c> conditions, matching <c>pWaiters</c>.
+		/// </param>
+		void suspend(const Condition *pConditions) noexcept;
+	};
+
+
+
+	/// <summary>
+	/// An intrusive node of a <c>WaitList</c>.<para/>
+	/// Unlinks itself on destruction, so a coroutine that is destroyed while suspended doesn't
+	/// leave a dangling waiter behind.
+	/// </summary>
+	class Waiter final
+	{
+		friend class WaitList;
+		friend struct WaitGroup;
+
+	public: // methods
+
+		Waiter() = default;
+		Waiter(const Waiter &) noexcept {} // copies are never linked
+		~Waiter() { unlink(); }
+
+		Waiter &operator=(const Waiter &) = delete;
+
+		/// <summary>
+		/// Remove this waiter from the list it's currently in (if any).
+		/// </summary>
+		void unlink() noexcept;
+
+		/// <summary>
+		/// Is this waiter currently part of a list?
+		/// </summary>
+		bool linked() const noexcept { return m_pList != nullptr; }
+
+
+	private: // variables
+
+		Waiter    *m_pPrev  = nullptr;
+		Waiter    *m_pNext  = nullptr;
+		WaitList  *m_pList  = nullptr;
+		WaitGroup *m_pGroup = nullptr;
+
+		Clock::time_point m_tpDeadline{}; // only used by timers
+	};
+
+
+
+	/// <summary>
+	/// An intrusive list of waiters for a single input change (for example "key pressed").<para/>
+	/// Devices only touch the lists of inputs whose state actually changed.
+	/// </summary>
+	class WaitList final
+	{
+		friend class Waiter;
+
+	public: // static methods
+
+		/// <summary>
+		/// Add a waiter to the timer list of the calling thread.
+		/// </summary>
+		static void AddTimer(Waiter &oWaiter, Clock::time_point tpDeadline) noexcept;
+
+		/// <summary>
+		/// Wake all waiters of the calling thread whose deadline is not after <c>tpNow</c>.
+		/// </summary>
+		static void ExpireTimers(WaitList &oDest, Clock::time_point tpNow) noexcept;
+
+
+	public: // methods
+
+		WaitList() = default;
+		WaitList(const WaitList &) = delete;
+		~WaitList();
+
+		WaitList &operator=(const WaitList &) = delete;
+
+		bool empty() const noexcept { return m_pFirst == nullptr; }
+
+		/// <summary>
+		/// Append a waiter to the end of the list.<para/>
+		/// If the waiter is currently part of another list, it's removed from that list first.
+		/// </summary>
+		void push(Waiter &oWaiter) noexcept;
+
+		/// <summary>
+		/// Wake all waiters of this list.<para/>
+		/// The waiters are moved to <c>oDest</c>; all other waiters of their groups are unlinked.
+		/// </summary>
+		void notify(WaitList &oDest) noexcept;
+
+		/// <summary>
+		/// Resume the coroutines of all waiters in this list, emptying the list.
+		/// </summary>
+		void resumeAll() noexcept;
+
+
+	private: // methods
+
+		void wake(Waiter &oWaiter, WaitList &oDest) noexcept;
+
+
+	private: // variables
+
+		Waiter *m_pFirst = nullptr;
+		Waiter *m_pLast  = nullptr;
+	};
+
+
+
+	/// <summary>
+	/// Collects the waiters woken during a single call to a <c>prepare()</c> method.<para/>
+	/// On construction, expired timers are woken; on destruction, all collected coroutines are
+	/// resumed. This way, coroutines always see the fully prepared state of the device.
+	/// </summary>
+	class WakeQueue final
+	{
+	public: // methods
+
+		WakeQueue() noexcept { WaitList::ExpireTimers(m_oWoken, Clock::now()); }
+		~WakeQueue() { m_oWoken.resumeAll(); }
+
+		WakeQueue(const WakeQueue &) = delete;
+		WakeQueue &operator=(const WakeQueue &) = delete;
+
+		/// <summary>
+		/// Wake all waiters of a list.
+		/// </summary>
+		void wake(WaitList &oList) noexcept
+		{
+			if (!oList.empty())
+				oList.notify(m_oWoken);
+		}
+
+
+	private: // variables
+
+		WaitList m_oWoken;
+	};
+
+}
+
+
+
+
+
+#endif // RLINPUT_WAITLIST
\ No newline at end of file
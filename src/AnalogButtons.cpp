@@ -0,0 +1,67 @@
+#include <rlInput/AnalogButtons.hpp>
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		constexpr float fDegToRad = 3.14159265f / 180.0f;
+
+	}
+
+
+
+
+
+	uint8_t StickButtons(float fX, float fY, uint8_t iDown,
+		const StickButtonSettings &oSettings) noexcept
+	{
+		const float fLength = std::sqrt(fX * fX + fY * fY);
+		if (fLength <= 0.0f || !oSettings.oThreshold.apply(iDown != 0, fLength))
+			return 0;
+
+		// the cosine of the angle between the stick and each direction, in bit order
+		const float oCos[] = { fY / fLength, -fY / fLength, -fX / fLength, fX / fLength };
+
+		// the sectors of two opposite directions must never overlap
+		const float fMargin = std::clamp(oSettings.fAngleHysteresis, 0.0f, 20.0f) * fDegToRad;
+
+		if (oSettings.eDirections == StickDirections::Eight)
+		{
+			// every direction covers 67.5 degrees to each side, so diagonals overlap
+			const float fPress   = std::cos(67.5f * fDegToRad);
+			const float fRelease = std::cos(67.5f * fDegToRad + fMargin);
+
+			uint8_t iResult = 0;
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				const bool bDown = iDown & (1 << i);
+				if (oCos[i] >= (bDown ? fRelease : fPress))
+					iResult |= uint8_t(1 << i);
+			}
+			return iResult;
+		}
+
+		// four directions --> keep the held one until the stick is clearly in another sector
+		const float fRelease = std::cos(45.0f * fDegToRad + fMargin);
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			if ((iDown & (1 << i)) && oCos[i] >= fRelease)
+				return uint8_t(1 << i);
+		}
+
+		unsigned iNearest = 0;
+		for (unsigned i = 1; i < 4; ++i)
+		{
+			if (oCos[i] > oCos[iNearest])
+				iNearest = i;
+		}
+		return uint8_t(1 << iNearest);
+	}
+
+}
@@ -0,0 +1,97 @@
+#include <rlInput/Callbacks.hpp>
+
+// STL
+#include <bit>
+
+namespace rlInput
+{
+
+	CallbackTable::CallbackTable(unsigned iInputCount, std::pmr::memory_resource *pMemory) :
+		m_oEntries(pMemory),
+		m_oOffsets(size_t(iInputCount) + 1, pMemory),
+		m_oSubscribedMask((size_t(iInputCount) + 63) / 64, pMemory)
+	{}
+
+	void CallbackTable::subscribe(unsigned iInput, Callback fnCallback, void *pContext)
+	{
+		m_oEntries.insert(m_oEntries.begin() + m_oOffsets[size_t(iInput) + 1],
+			Entry{ fnCallback, pContext });
+
+		for (size_t i = size_t(iInput) + 1; i < m_oOffsets.size(); ++i)
+		{
+			++m_oOffsets[i];
+		}
+
+		m_oSubscribedMask[iInput / 64] |= uint64_t(1) << (iInput % 64);
+	}
+
+	bool CallbackTable::unsubscribe(unsigned iInput, Callback fnCallback, void *pContext) noexcept
+	{
+		const unsigned iBegin = m_oOffsets[iInput];
+		const unsigned iEnd   = m_oOffsets[size_t(iInput) + 1];
+
+		for (unsigned iEntry = iBegin; iEntry < iEnd; ++iEntry)
+		{
+			const auto &o = m_oEntries[iEntry];
+			if (o.fnCallback != fnCallback || o.pContext != pContext)
+				continue;
+
+			m_oEntries.erase(m_oEntries.begin() + iEntry);
+			for (size_t i = size_t(iInput) + 1; i < m_oOffsets.size(); ++i)
+			{
+				--m_oOffsets[i];
+			}
+
+			if (iEnd - iBegin == 1)
+				m_oSubscribedMask[iInput / 64] &= ~(uint64_t(1) << (iInput % 64));
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void CallbackTable::clear() noexcept
+	{
+		m_oEntries.clear();
+
+		for (auto &i : m_oOffsets)
+		{
+			i = 0;
+		}
+		for (auto &i : m_oSubscribedMask)
+		{
+			i = 0;
+		}
+	}
+
+	void CallbackTable::dispatch(unsigned iInput) const noexcept
+	{
+		const unsigned iEnd = m_oOffsets[size_t(iInput) + 1];
+
+		for (unsigned iEntry = m_oOffsets[iInput]; iEntry < iEnd; ++iEntry)
+		{
+			m_oEntries[iEntry].fnCallback(m_oEntries[iEntry].pContext, iInput);
+		}
+	}
+
+	void CallbackTable::dispatchMask(const uint64_t *pMask) const noexcept
+	{
+		if (m_oEntries.empty())
+			return;
+
+		for (size_t iWord = 0; iWord < m_oSubscribedMask.size(); ++iWord)
+		{
+			uint64_t iBits = pMask[iWord] & m_oSubscribedMask[iWord];
+
+			while (iBits)
+			{
+				const unsigned iBit = unsigned(std::countr_zero(iBits));
+				iBits &= iBits - 1;
+
+				dispatch(unsigned(iWord * 64 + iBit));
+			}
+		}
+	}
+
+}
@@ -0,0 +1,146 @@
+#include <rlInput/Filters.hpp>
+
+// STL
+#include <cmath>
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		constexpr float fPI = 3.14159265f;
+
+		/// <summary>
+		/// The smoothing factor of an exponential low-pass filter.
+		/// </summary>
+		float LowPassAlpha(float fCutoff, float fDeltaTime) noexcept
+		{
+			const float fTau = 1.0f / (2.0f * fPI * fCutoff);
+			return 1.0f / (1.0f + fTau / fDeltaTime);
+		}
+
+	}
+
+
+
+
+
+	float OneEuroFilter::filter(float fValue, float fDeltaTime) noexcept
+	{
+		if (!m_bInitialized || fDeltaTime <= 0.0f)
+		{
+			if (!m_bInitialized)
+			{
+				m_fValue      = fValue;
+				m_fDerivative = 0.0f;
+			}
+			m_fRawValue    = fValue;
+			m_bInitialized = true;
+			return m_fValue;
+		}
+
+		const float fDerivative = (fValue - m_fRawValue) / fDeltaTime;
+		m_fDerivative +=
+			LowPassAlpha(m_oSettings.fDerivativeCutoff, fDeltaTime) * (fDerivative - m_fDerivative);
+
+		const float fCutoff = m_oSettings.fMinCutoff + m_oSettings.fBeta * std::abs(m_fDerivative);
+		m_fValue += LowPassAlpha(fCutoff, fDeltaTime) * (fValue - m_fValue);
+
+		m_fRawValue = fValue;
+		return m_fValue;
+	}
+
+
+
+
+
+	void MotionPredictor::setSettings(const Settings &oSettings) noexcept
+	{
+		m_oSettings = oSettings;
+		reset();
+	}
+
+	void MotionPredictor::update(float fValue, Clock::time_point tpTime) noexcept
+	{
+		if (!m_bInitialized)
+		{
+			m_bInitialized = true;
+			m_fValue    = fValue;
+			m_fVelocity = 0.0f;
+			m_tpLast    = tpTime;
+
+			m_fP00 = m_oSettings.fMeasurementNoise;
+			m_fP01 = 0.0f;
+			m_fP11 = m_oSettings.fProcessNoise;
+			return;
+		}
+
+		const float fDeltaTime = std::chrono::duration<float>(tpTime - m_tpLast).count();
+		if (fDeltaTime <= 0.0f)
+		{
+			m_fValue = fValue;
+			return;
+		}
+		m_tpLast = tpTime;
+
+		switch (m_oSettings.eMode)
+		{
+		case PredictionMode::None:
+			m_fValue = fValue;
+			break;
+
+		case PredictionMode::Linear:
+			m_fVelocity = (fValue - m_fValue) / fDeltaTime;
+			m_fValue    = fValue;
+			break;
+
+		case PredictionMode::Kalman:
+		{
+			// predict (constant velocity, white noise acceleration)
+			const float dt  = fDeltaTime;
+			const float q   = m_oSettings.fProcessNoise;
+			const float dt2 = dt * dt;
+
+			m_fValue += m_fVelocity * dt;
+			const float fP00 = m_fP00 + dt * (2.0f * m_fP01 + dt * m_fP11) + q * dt2 * dt / 3.0f;
+			const float fP01 = m_fP01 + dt * m_fP11 + q * dt2 / 2.0f;
+			const float fP11 = m_fP11 + q * dt;
+
+			// correct
+			const float fInnovation = fValue - m_fValue;
+			const float fS  = fP00 + m_oSettings.fMeasurementNoise;
+			const float fK0 = fP00 / fS;
+			const float fK1 = fP01 / fS;
+
+			m_fValue    += fK0 * fInnovation;
+			m_fVelocity += fK1 * fInnovation;
+
+			m_fP00 = (1.0f - fK0) * fP00;
+			m_fP01 = (1.0f - fK0) * fP01;
+			m_fP11 = fP11 - fK1 * fP01;
+			break;
+		}
+		}
+	}
+
+	float MotionPredictor::predict(Clock::time_point tpTime) const noexcept
+	{
+		if (m_oSettings.eMode == PredictionMode::None || tpTime <= m_tpLast)
+			return m_fValue;
+
+		auto tHorizon = tpTime - m_tpLast;
+		if (tHorizon > m_oSettings.tMaxHorizon)
+			tHorizon = m_oSettings.tMaxHorizon;
+
+		return m_fValue + m_fVelocity * std::chrono::duration<float>(tHorizon).count();
+	}
+
+	void MotionPredictor::reset() noexcept
+	{
+		m_bInitialized = false;
+		m_fValue    = 0.0f;
+		m_fVelocity = 0.0f;
+	}
+
+}
@@ -3,6 +3,15 @@
 // RegisterDeviceNotification
 
 #include <rlInput/Gamepad.DirectInput.hpp>
+#include <rlInput/Trace.hpp>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <span>
+#include <string_view>
+#include <thread>
 
 // Win32
 #include <wbemidl.h>
@@ -43,17 +52,17 @@ namespace rlInput
 
 			using Meta = DirectInput::GamepadMeta;
 
-			auto &oDest = *reinterpret_cast<std::vector<Meta> *>(pvRef);
+			auto &oDest = *reinterpret_cast<std::pmr::vector<Meta> *>(pvRef);
 
 			try
 			{
-				oDest.push_back(Meta
-				{
+				// constructed in place --> the names are allocated from the list's resource
+				oDest.emplace_back(
 					lpddi->guidInstance,
 					lpddi->guidProduct,
 					lpddi->tszInstanceName,
 					lpddi->tszProductName
-				});
+				);
 			}
 			catch (...)
 			{
@@ -63,22 +72,36 @@ namespace rlInput
 			return DIENUM_CONTINUE;
 		}
 
+		HRESULT Poll(IDirectInputDevice8 *pDevice) noexcept
+		{
+			RLINPUT_TRACE_SCOPE("IDirectInputDevice8::Poll");
+			return pDevice->Poll();
+		}
+
+		HRESULT Acquire(IDirectInputDevice8 *pDevice) noexcept
+		{
+			RLINPUT_TRACE_SCOPE("IDirectInputDevice8::Acquire");
+			return pDevice->Acquire();
+		}
+
 	}
 
 
 
 
 
-	DirectInput::Gamepad::Gamepad(const GamepadMeta &oMeta, HWND hWnd) :
+	DirectInput::Gamepad::Gamepad(const GamepadMeta &oMeta, HWND hWnd, DirectInput &oOwner) :
+		Gamepad(CreateDevice(oOwner, oMeta), oMeta, hWnd, oOwner) {}
+
+	DirectInput::Gamepad::Gamepad(IDirectInputDevice8 *pDevice, const GamepadMeta &oMeta,
+		HWND hWnd, DirectInput &oOwner) :
 		m_oGuidInstance(oMeta.guidInstance),  m_oGuidProduct(oMeta.guidProduct),
-		m_sInstanceName(oMeta.sInstanceName), m_sProductName(oMeta.sProductName),
-		m_hWnd(hWnd), m_oAxes(6)
+		m_sInstanceName(std::wstring_view(oMeta.sInstanceName), oOwner.memoryResource()),
+		m_sProductName(std::wstring_view(oMeta.sProductName), oOwner.memoryResource()),
+		m_hWnd(hWnd), m_pOwner(&oOwner), m_pDevice(pDevice),
+		m_oButtons(oOwner.memoryResource()), m_oAxisButtons(oOwner.memoryResource()),
+		m_oAxes(6, oOwner.memoryResource())
 	{
-		const auto pDirectInput = DirectInput::s_oInstance.m_pDirectInput;
-		
-		if (pDirectInput->CreateDevice(m_oGuidInstance, &m_pDevice, NULL) != DI_OK)
-			throw std::exception("Failed to initialize DirectInput device");
-
 		if (m_pDevice->SetDataFormat(&c_dfDIJoystick) != DI_OK)
 			goto lbError;
 
@@ -100,14 +123,20 @@ namespace rlInput
 
 			m_bConnected = didc.dwFlags & DIDC_ATTACHED;
 			m_oButtons.resize(didc.dwButtons < 32 ? didc.dwButtons : 32);
+			m_iPhysicalButtons = m_oButtons.size();
 			m_iAxesCount = didc.dwAxes;
-
-			m_oRawStates_Old = std::make_unique<bool[]>(m_oButtons.size());
-			memset(m_oRawStates_Old.get(), 0, m_oButtons.size() * sizeof(bool));
 		}
 
 
-		s_oInstance.m_oGamepadInstances.insert(this);
+		try
+		{
+			m_hHandle = oOwner.m_oGamepads.insert(this);
+		}
+		catch (...)
+		{
+			m_pDevice->Release();
+			throw;
+		}
 		return;
 
 	lbError:
@@ -117,21 +146,41 @@ namespace rlInput
 
 	DirectInput::Gamepad::~Gamepad()
 	{
-		if (s_bInstanceValid)
-			s_oInstance.m_oGamepadInstances.erase(this);
+		if (m_pOwner)
+			m_pOwner->m_oGamepads.erase(m_hHandle);
 
 		m_pDevice->Release();
 	}
 
+	IDirectInputDevice8 *DirectInput::Gamepad::CreateDevice(DirectInput &oOwner,
+		const GamepadMeta &oMeta)
+	{
+		IDirectInputDevice8 *pDevice = nullptr;
+		if (oOwner.m_pDirectInput->CreateDevice(oMeta.guidInstance, &pDevice, NULL) != DI_OK)
+			throw std::exception("Failed to initialize DirectInput device");
+
+		return pDevice;
+	}
+
 	bool DirectInput::Gamepad::prepare() noexcept
 	{
-		if (!s_bForeground)
+		RLINPUT_TRACE_SCOPE("DirectInput::Gamepad::prepare");
+		StatsRecorder::PrepareScope oStatsScope(m_oStats);
+
+		sample();
+		return publish();
+	}
+
+	void DirectInput::Gamepad::sample() noexcept
+	{
+		if (!m_pOwner || !m_pOwner->m_bForeground)
 		{
-			reset();
-			return false;
+			m_eSample = SampleResult::Inactive;
+			return;
 		}
 
-		auto hr = m_pDevice->Poll();
+		auto hr = Poll(m_pDevice);
+		m_oStats.count(&DeviceStats::Counters::iPolls);
 
 		switch (hr)
 		{
@@ -141,100 +190,392 @@ namespace rlInput
 
 		case DIERR_INPUTLOST:
 		case DIERR_NOTACQUIRED:
-			hr = m_pDevice->Acquire();
+			m_oStats.count(&DeviceStats::Counters::iPollFailures);
+			hr = Acquire(m_pDevice);
 
 			if (hr != DI_OK && hr != S_FALSE)
 			{
-				m_bConnected = (hr != DIERR_INPUTLOST);
-				reset();
-				return false;
+				m_oStats.count(&DeviceStats::Counters::iAcquireFailures);
+				m_eSample  = SampleResult::Lost;
+				m_hrSample = hr;
+				return;
 			}
 
-			hr = m_pDevice->Poll();
+			hr = Poll(m_pDevice);
+			m_oStats.count(&DeviceStats::Counters::iPolls);
 			if (hr != DI_OK && hr != DI_NOEFFECT)
 			{
-				m_bConnected = (hr != DIERR_INPUTLOST);
-				reset();
-				return false;
+				m_oStats.count(&DeviceStats::Counters::iPollFailures);
+				m_eSample  = SampleResult::Lost;
+				m_hrSample = hr;
+				return;
 			}
 		}
 
-		DIJOYSTATE oState{};
-		if (m_pDevice->GetDeviceState(sizeof(oState), &oState) != DI_OK)
+		if (m_pDevice->GetDeviceState(sizeof(m_oSample), &m_oSample) != DI_OK)
+		{
+			m_oStats.count(&DeviceStats::Counters::iPollFailures);
+			m_eSample = SampleResult::NoState;
+			return;
+		}
+
+		m_tpSample = Clock::now();
+		m_eSample  = SampleResult::Valid;
+	}
+
+	bool DirectInput::Gamepad::publish() noexcept
+	{
+		WakeQueue oWake;
+
+		const bool bWasConnected = m_bConnected;
+
+		switch (m_eSample)
+		{
+		case SampleResult::Inactive:
+			reset();
 			return false;
 
-		auto pOld = m_oRawStates_Old.get();
+		case SampleResult::Lost:
+			reset();
+			m_bConnected = (m_hrSample != DIERR_INPUTLOST);
+			if (bWasConnected && !m_bConnected)
+			{
+				RLINPUT_TRACE_EVENT("DirectInput gamepad disconnected", Tracer::NoArg);
+				m_oDisconnectedCallbacks.dispatch(0);
+			}
+			return false;
+
+		case SampleResult::NoState:
+			return false;
+
+		case SampleResult::Valid:
+			break;
+		}
+
+		const DIJOYSTATE &oState = m_oSample;
+
+		if (!bWasConnected)
+			m_oStats.count(&DeviceStats::Counters::iReconnects);
+		m_bConnected = true;
+		m_tpPrepared = m_tpSample;
+
+		// indexed by the DINPUT_AXIS_[...] constants
+		const Axis oAxes[] =
+			{ oState.lX, oState.lY, oState.lZ, oState.lRx, oState.lRy, oState.lRz };
+
+		uint64_t iPressedMask  = 0;
+		uint64_t iReleasedMask = 0;
+
+		auto pOld = m_oRawStates_Old;
 		auto pNew  = m_oButtons.data();
 		for (size_t iButton = 0; iButton < m_oButtons.size(); ++iButton)
 		{
-			const bool bNew = oState.rgbButtons[iButton] & 0x80;
+			bool bNew;
+			if (iButton < m_iPhysicalButtons)
+			{
+				bNew = oState.rgbButtons[iButton] & 0x80;
+			}
+			else
+			{
+				const auto &oAxisButton = m_oAxisButtons[iButton - m_iPhysicalButtons];
+
+				constexpr float fRange = float(DINPUT_AXISPOS_MAX - DINPUT_AXISPOS_CENTER);
+				float fDeflection = (oAxes[oAxisButton.iAxis] - DINPUT_AXISPOS_CENTER) / fRange;
+				if (!oAxisButton.bPositive)
+					fDeflection = -fDeflection;
+
+				bNew = oAxisButton.oThreshold.apply(*pOld, fDeflection);
+			}
 
 			pNew->bPressed  =  bNew && !*pOld;
 			pNew->bDown     =  bNew;
 			pNew->bReleased = !bNew && *pOld;
+			pNew->bRepeated = false;
+
+			iPressedMask  |= uint64_t(pNew->bPressed)  << iButton;
+			iReleasedMask |= uint64_t(pNew->bReleased) << iButton;
+
+			if (pNew->bPressed)
+			{
+				m_oTimes.setPressTime(iButton, m_tpPrepared);
+				m_oRepeat.press(unsigned(iButton), m_tpPrepared);
+				oWake.wake(m_oPressedWaiters[iButton]);
+			}
+			else if (pNew->bReleased)
+			{
+				m_oTimes.setReleaseTime(iButton, m_tpPrepared);
+				m_oRepeat.release(unsigned(iButton));
+				oWake.wake(m_oReleasedWaiters[iButton]);
+			}
 
 			*pOld = bNew;
 			++pOld;
 			++pNew;
 		}
 
-		m_oAxes[DINPUT_AXIS_X]  = oState.lX;
-		m_oAxes[DINPUT_AXIS_Y]  = oState.lY;
-		m_oAxes[DINPUT_AXIS_Z]  = oState.lZ;
-		m_oAxes[DINPUT_AXIS_RX] = oState.lRx;
-		m_oAxes[DINPUT_AXIS_RY] = oState.lRy;
-		m_oAxes[DINPUT_AXIS_RZ] = oState.lRz;
+		uint64_t iRepeatedMask = 0;
+		m_oRepeat.advance(m_tpPrepared, &iRepeatedMask);
+		for (; iRepeatedMask; iRepeatedMask &= iRepeatedMask - 1)
+		{
+			m_oButtons[std::countr_zero(iRepeatedMask)].bRepeated = true;
+		}
+
+		if constexpr (StatsRecorder::Enabled)
+		{
+			if (iPressedMask || iReleasedMask || memcmp(m_oAxes.data(), oAxes, sizeof(oAxes)) != 0)
+				m_pOwner->m_oStats.recordLatency(m_tpPrepared);
+		}
+		memcpy(m_oAxes.data(), oAxes, sizeof(oAxes));
+
+		if (!bWasConnected)
+		{
+			RLINPUT_TRACE_EVENT("DirectInput gamepad connected", Tracer::NoArg);
+			m_oConnectedCallbacks.dispatch(0);
+		}
+		m_oPressedCallbacks.dispatchMask(&iPressedMask);
+		m_oReleasedCallbacks.dispatchMask(&iReleasedMask);
 
 		return true;
 	}
 
+	void DirectInput::Gamepad::setAxisButtons(std::span<const AxisButton> oButtons)
+	{
+		for (const auto &o : oButtons)
+		{
+			if (o.iAxis >= 6)
+				throw std::exception("DirectInput::Gamepad: Invalid axis index");
+		}
+
+		const size_t iCount = std::min(oButtons.size(), 32 - m_iPhysicalButtons);
+		m_oAxisButtons.assign(oButtons.begin(), oButtons.begin() + iCount);
+		m_oButtons.resize(m_iPhysicalButtons + iCount);
+
+		for (size_t i = m_iPhysicalButtons; i < 32; ++i)
+		{
+			if (m_oRawStates_Old[i])
+				m_oRepeat.release(unsigned(i));
+
+			m_oRawStates_Old[i] = false;
+		}
+		memset(m_oButtons.data() + m_iPhysicalButtons, 0, iCount * sizeof(Button));
+	}
+
 	void DirectInput::Gamepad::reset() noexcept
 	{
-		m_bConnected = false;
-		memset(m_oRawStates_Old.get(), 0, m_oButtons.size() * sizeof(bool));
-		memset(m_oButtons.data(),      0, m_oButtons.size() * sizeof(Button));
-		memset(m_oAxes.data(),         0, m_oAxes.size()    * sizeof(Axis));
+		// m_bConnected is kept: losing the focus doesn't disconnect the gamepad
+		memset(m_oRawStates_Old,  0, sizeof(m_oRawStates_Old));
+		memset(m_oButtons.data(), 0, m_oButtons.size() * sizeof(Button));
+		memset(m_oAxes.data(),    0, m_oAxes.size()    * sizeof(Axis));
+		m_oRepeat.reset();
 	}
 
 
 
 
 
+	/// <summary>
+	/// Threads that sample gamepads in parallel (see <c>setPollThreads()</c>).<para/>
+	/// A round of sampling neither allocates nor locks: the gamepads are handed out via an atomic
+	/// index, the workers are woken and joined via <c>std::atomic::wait()</c>.
+	/// </summary>
+	class DirectInput::PollWorkers final
+	{
+	public: // methods
+
+		PollWorkers(unsigned iWorkers, std::pmr::memory_resource *pMemory) : m_oThreads(pMemory)
+		{
+			m_oThreads.reserve(iWorkers);
+			try
+			{
+				for (unsigned i = 0; i < iWorkers; ++i)
+				{
+					m_oThreads.emplace_back(&PollWorkers::threadProc, this);
+				}
+			}
+			catch (...)
+			{
+				stop();
+				throw;
+			}
+		}
+
+		~PollWorkers() { stop(); }
+
+		/// <summary>
+		/// The count of threads sampling, including the one calling <c>sample()</c>.
+		/// </summary>
+		unsigned threadCount() const noexcept { return unsigned(m_oThreads.size()) + 1; }
+
+		/// <summary>
+		/// Call <c>Gamepad::sample()</c> of all gamepads, return when all calls are done.
+		/// </summary>
+		void sample(std::span<Gamepad *const> oGamepads) noexcept
+		{
+			m_oGamepads = oGamepads;
+			m_iNext.store(0, std::memory_order_relaxed);
+			m_iBusy.store(unsigned(m_oThreads.size()), std::memory_order_relaxed);
+			m_iRound.fetch_add(1, std::memory_order_release);
+			m_iRound.notify_all();
+
+			work();
+
+			for (unsigned i; (i = m_iBusy.load(std::memory_order_acquire)) != 0; )
+			{
+				m_iBusy.wait(i, std::memory_order_acquire);
+			}
+		}
+
+
+	private: // methods
+
+		void work() noexcept
+		{
+			for (size_t i; (i = m_iNext.fetch_add(1, std::memory_order_relaxed)) <
+				m_oGamepads.size(); )
+			{
+				m_oGamepads[i]->sample();
+			}
+		}
+
+		void threadProc() noexcept
+		{
+			uint32_t iRound = 0;
+			while (true)
+			{
+				m_iRound.wait(iRound, std::memory_order_acquire);
+				iRound = m_iRound.load(std::memory_order_acquire);
+				if (m_bStop.load(std::memory_order_relaxed))
+					return;
+
+				work();
+
+				if (m_iBusy.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					m_iBusy.notify_one();
+			}
+		}
+
+		void stop() noexcept
+		{
+			m_bStop.store(true, std::memory_order_relaxed);
+			m_iRound.fetch_add(1, std::memory_order_release);
+			m_iRound.notify_all();
+
+			for (auto &o : m_oThreads)
+			{
+				o.join();
+			}
+			m_oThreads.clear();
+		}
+
+
+	private: // variables
+
+		std::pmr::vector<std::thread> m_oThreads;
+
+		std::span<Gamepad *const> m_oGamepads; // of the current round
+		std::atomic<size_t>   m_iNext  = 0;    // next gamepad to sample
+		std::atomic<unsigned> m_iBusy  = 0;    // workers that haven't finished the round yet
+		std::atomic<uint32_t> m_iRound = 0;
+		std::atomic<bool>     m_bStop  = false;
+
+	};
+
+
+
+
+
 	DirectInput DirectInput::s_oInstance;
-	bool DirectInput::s_bForeground    = false;
-	bool DirectInput::s_bInstanceValid = false;
 
 	void DirectInput::prepare() noexcept
 	{
-		for (auto p : m_oGamepadInstances)
-			p->prepare();
+		RLINPUT_TRACE_SCOPE("DirectInput::prepare");
+		if (m_pWorkers && m_oGamepads.size() > 1)
+		{
+			m_pWorkers->sample(m_oGamepads.values());
+
+			for (auto p : m_oGamepads)
+			{
+				StatsRecorder::PrepareScope oStatsScope(p->m_oStats);
+				p->publish();
+			}
+		}
+		else
+		{
+			for (auto p : m_oGamepads)
+				p->prepare();
+		}
+
+		m_oStats.endFrame();
 	}
 
 	void DirectInput::update(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
 	{
+		RLINPUT_TRACE_SCOPE_ARG("DirectInput::update", uMsg);
 		switch (uMsg)
 		{
 		case WM_SETFOCUS:
-			s_bForeground = true;
+			m_bForeground = true;
 			break;
 
 
 
 		case WM_KILLFOCUS:
-			s_bForeground = false;
+			m_bForeground = false;
 			reset();
 			break;
+
+
+
+		default:
+			m_oStats.countMessage(false);
+			return;
 		}
+
+		m_oStats.countMessage(true);
 	}
 
 	void DirectInput::reset() noexcept
 	{
-		for (auto p : m_oGamepadInstances)
+		for (auto p : m_oGamepads)
 			p->reset();
 	}
 
+	void DirectInput::setPollThreads(unsigned iCount)
+	{
+		if (iCount == pollThreads())
+			return;
+
+		std::pmr::polymorphic_allocator<> oAllocator(m_pMemory);
+		if (m_pWorkers)
+		{
+			oAllocator.delete_object(m_pWorkers);
+			m_pWorkers = nullptr;
+		}
+
+		if (iCount > 1)
+			m_pWorkers = oAllocator.new_object<PollWorkers>(iCount - 1, m_pMemory);
+	}
+
+	unsigned DirectInput::pollThreads() const noexcept
+	{
+		return m_pWorkers ? m_pWorkers->threadCount() : 1;
+	}
+
+	DeviceHandle DirectInput::find(const GUID &guidInstance) const noexcept
+	{
+		const auto oGamepads = m_oGamepads.values();
+		for (size_t i = 0; i < oGamepads.size(); ++i)
+		{
+			if (IsEqualGUID(oGamepads[i]->m_oGuidInstance, guidInstance))
+				return m_oGamepads.handle(i);
+		}
+
+		return {};
+	}
+
 	void DirectInput::updateControllerList()
 	{
+		RLINPUT_TRACE_SCOPE("DirectInput::updateControllerList");
 		m_oAvailableControllers.clear();
 		const auto hr = m_pDirectInput->EnumDevices(
 			DI8DEVCLASS_GAMECTRL,     // dwDevType
@@ -249,6 +590,7 @@ namespace rlInput
 
 	bool DirectInput::isXInput(const GUID &guidProduct) const noexcept
 	{
+		RLINPUT_TRACE_SCOPE("DirectInput::isXInput");
 		// TODO: OPTIMIZE!
 
 		// SOURCE CODE BY MICROSOFT
@@ -376,7 +718,7 @@ namespace rlInput
 		return bIsXinputDevice;
 	}
 
-	DirectInput::DirectInput()
+	DirectInput::DirectInput(std::pmr::memory_resource *pMemory) : m_pMemory(pMemory)
 	{
 		const auto hr =
 			DirectInput8Create(GetModuleHandle(NULL), DIRECTINPUT_VERSION, IID_IDirectInput8,
@@ -386,14 +728,18 @@ namespace rlInput
 			throw std::exception("Error initializing DirectInput");
 
 		updateControllerList();
-
-		s_bInstanceValid = true;
 	}
 
 	DirectInput::~DirectInput()
 	{
+		if (m_pWorkers)
+			std::pmr::polymorphic_allocator<>(m_pMemory).delete_object(m_pWorkers);
+
+		// gamepads may outlive their owner (e.g. static objects at shutdown)
+		for (auto p : m_oGamepads)
+			p->m_pOwner = nullptr;
+
 		m_pDirectInput->Release();
-		s_bInstanceValid = false;
 	}
 
 }
@@ -1,6 +1,8 @@
 #include <rlInput/Gamepad.XInput.hpp>
+#include <rlInput/Trace.hpp>
 
 // STL
+#include <bit>
 #include <cmath>
 
 // Win32
@@ -10,29 +12,72 @@ namespace rlInput
 {
 
 	XInput XInput::s_oInstance;
-	bool XInput::s_bForeground = false;
 
 
 
-	XInput::Gamepad::Gamepad(unsigned iID) : m_iID(iID) {}
+	XInput::Gamepad::Gamepad(unsigned iID, XInput &oOwner) : m_iID(iID), m_oOwner(oOwner) {}
 
 	bool XInput::Gamepad::prepare() noexcept
 	{
-		if (!s_bForeground)
+		RLINPUT_TRACE_SCOPE_ARG("XInput::Gamepad::prepare", m_iID);
+		StatsRecorder::PrepareScope oStatsScope(m_oStats);
+		WakeQueue oWake;
+
+		if (!m_oOwner.m_bForeground)
 		{
 			reset();
 			return false;
 		}
 
-		m_bConnected = XInputGetState(m_iID, &m_oRawState_New) == ERROR_SUCCESS;
+		const bool bWasConnected = m_bConnected;
+		DWORD dwResult;
+		{
+			RLINPUT_TRACE_SCOPE_ARG("XInputGetState", m_iID);
+			dwResult = m_oOwner.m_oBackend.pfnGetState(m_iID, &m_oRawState_New);
+		}
+		m_bConnected = dwResult == ERROR_SUCCESS;
+		m_tpPrepared = Clock::now();
+
+		m_oStats.count(&DeviceStats::Counters::iPolls);
+		if (!m_bConnected && dwResult != ERROR_DEVICE_NOT_CONNECTED)
+			m_oStats.count(&DeviceStats::Counters::iPollFailures);
+		if (m_bConnected && !bWasConnected)
+		{
+			if (m_bEverConnected)
+				m_oStats.count(&DeviceStats::Counters::iReconnects);
+			m_bEverConnected = true;
+		}
 		if (!m_bConnected)
 		{
 			reset();
+			if (bWasConnected)
+			{
+				RLINPUT_TRACE_EVENT("XInput gamepad disconnected", m_iID);
+				m_oDisconnectedCallbacks.dispatch(0);
+			}
 			return false;
 		}
 
-		if (m_oRawState_New.dwPacketNumber == m_oRawState_Old.dwPacketNumber)
-			return true; // no change
+		if (bWasConnected && m_oRawState_New.dwPacketNumber == m_oRawState_Old.dwPacketNumber)
+		{
+			// no change --> only the edges have to be cleared
+			for (auto &o : m_oButtons)
+			{
+				o.bPressed  = false;
+				o.bReleased = false;
+				o.bRepeated = false;
+			}
+			for (auto &o : m_oThumbSticks)
+			{
+				o.oButton.bPressed  = false;
+				o.oButton.bReleased = false;
+				o.oButton.bRepeated = false;
+			}
+
+			applyFilters();
+			applyRepeats();
+			return true;
+		}
 
 
 
@@ -51,6 +96,17 @@ namespace rlInput
 			m_oButtons + 10,
 			m_oButtons + 11,
 
+			m_oButtons + 12,
+			m_oButtons + 13,
+			m_oButtons + 14,
+			m_oButtons + 15,
+			m_oButtons + 16,
+			m_oButtons + 17,
+			m_oButtons + 18,
+			m_oButtons + 19,
+			m_oButtons + 20,
+			m_oButtons + 21,
+
 			&m_oThumbSticks[0].oButton,
 			&m_oThumbSticks[1].oButton
 		};
@@ -70,23 +126,95 @@ namespace rlInput
 			XINPUT_GAMEPAD_X,
 			XINPUT_GAMEPAD_Y,
 
+			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // virtual buttons, see below
+
 			XINPUT_GAMEPAD_LEFT_THUMB,
 			XINPUT_GAMEPAD_RIGHT_THUMB
 		};
+		constexpr size_t iButtonCount = sizeof(pButtons) / sizeof(pButtons[0]);
+		static_assert(sizeof(iMasks) / sizeof(iMasks[0]) == iButtonCount);
+
+		const auto &oGamepad = m_oRawState_New.Gamepad;
 
-		for (size_t i = 0; i < sizeof(pButtons) / sizeof(pButtons[0]); ++i)
+		// one bit per entry of pButtons
+		uint32_t iOldDown = 0;
+		uint32_t iNewDown = 0;
+		for (size_t i = 0; i < iButtonCount; ++i)
 		{
-			const bool bOld = m_oRawState_Old.Gamepad.wButtons & iMasks[i];
-			const bool bNew = m_oRawState_New.Gamepad.wButtons & iMasks[i];
+			iOldDown |= uint32_t(pButtons[i]->bDown) << i;
+			iNewDown |= uint32_t((oGamepad.wButtons & iMasks[i]) != 0) << i;
+		}
 
-			pButtons[i]->bPressed  =  bNew && !bOld;
-			pButtons[i]->bDown     =  bNew;
-			pButtons[i]->bReleased = !bNew && bOld;
+		// the virtual buttons depend on their old state (hysteresis)
+		{
+			constexpr float fStickRange   = 32767.0f;
+			constexpr float fTriggerRange = 255.0f;
+			const auto &oSettings = m_oVirtualSettings;
+
+			const auto iLeftStick = StickButtons(oGamepad.sThumbLX / fStickRange,
+				oGamepad.sThumbLY / fStickRange,
+				uint8_t((iOldDown >> XINPUT_BUTTON_LEFT_STICK_UP) & 0x0F), oSettings.oSticks);
+			const auto iRightStick = StickButtons(oGamepad.sThumbRX / fStickRange,
+				oGamepad.sThumbRY / fStickRange,
+				uint8_t((iOldDown >> XINPUT_BUTTON_RIGHT_STICK_UP) & 0x0F), oSettings.oSticks);
+
+			const bool bLeftTrigger = oSettings.oTriggers.apply(
+				m_oButtons[XINPUT_BUTTON_LEFT_TRIGGER].bDown,
+				oGamepad.bLeftTrigger / fTriggerRange);
+			const bool bRightTrigger = oSettings.oTriggers.apply(
+				m_oButtons[XINPUT_BUTTON_RIGHT_TRIGGER].bDown,
+				oGamepad.bRightTrigger / fTriggerRange);
+
+			iNewDown |= uint32_t(iLeftStick)    << XINPUT_BUTTON_LEFT_STICK_UP;
+			iNewDown |= uint32_t(iRightStick)   << XINPUT_BUTTON_RIGHT_STICK_UP;
+			iNewDown |= uint32_t(bLeftTrigger)  << XINPUT_BUTTON_LEFT_TRIGGER;
+			iNewDown |= uint32_t(bRightTrigger) << XINPUT_BUTTON_RIGHT_TRIGGER;
 		}
 
+		// the indexes of pButtons are the XINPUT_BUTTON_[...] constants
+		static_assert(iButtonCount == XINPUT_BUTTON_RIGHT_THUMB + 1);
 
+		const uint32_t iPressed  =  iNewDown & ~iOldDown;
+		const uint32_t iReleased = ~iNewDown &  iOldDown;
 
-		const auto &oGamepad = m_oRawState_New.Gamepad;
+		uint64_t iPressedMask  = iPressed;
+		uint64_t iReleasedMask = iReleased;
+
+		for (size_t i = 0; i < iButtonCount; ++i)
+		{
+			pButtons[i]->bPressed  = (iPressed  >> i) & 1;
+			pButtons[i]->bDown     = (iNewDown  >> i) & 1;
+			pButtons[i]->bReleased = (iReleased >> i) & 1;
+			pButtons[i]->bRepeated = false;
+		}
+
+		// only the buttons that changed
+		for (uint32_t iChanged = iPressed | iReleased; iChanged; iChanged &= iChanged - 1)
+		{
+			const auto i = unsigned(std::countr_zero(iChanged));
+			const bool bPressed = (iPressed >> i) & 1;
+
+			if (bPressed)
+			{
+				m_oRepeat.press(i, m_tpPrepared);
+				m_oTimes.setPressTime(i, m_tpPrepared);
+				oWake.wake(m_oPressedWaiters[i]);
+			}
+			else
+			{
+				m_oRepeat.release(i);
+				m_oTimes.setReleaseTime(i, m_tpPrepared);
+				oWake.wake(m_oReleasedWaiters[i]);
+			}
+		}
+
+
+
+		const bool bWasOutsideDeadzone[] =
+		{
+			m_oThumbSticks[0].bXOutsideDeadzone || m_oThumbSticks[0].bYOutsideDeadzone,
+			m_oThumbSticks[1].bXOutsideDeadzone || m_oThumbSticks[1].bYOutsideDeadzone
+		};
 
 
 		m_oTriggerButtons[0].iState = oGamepad.bLeftTrigger;
@@ -116,8 +244,31 @@ namespace rlInput
 			std::abs(oGamepad.sThumbRY) > XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE;
 
 
+		uint64_t iDeadzoneMask = 0;
+		for (size_t i = 0; i < 2; ++i)
+		{
+			const bool bOutside =
+				m_oThumbSticks[i].bXOutsideDeadzone || m_oThumbSticks[i].bYOutsideDeadzone;
+
+			iDeadzoneMask |= uint64_t(bOutside && !bWasOutsideDeadzone[i]) << i;
+		}
+
+
 
 		m_oRawState_Old = m_oRawState_New;
+		applyFilters();
+		applyRepeats();
+		m_oOwner.m_oStats.recordLatency(m_tpPrepared);
+
+		if (!bWasConnected)
+		{
+			RLINPUT_TRACE_EVENT("XInput gamepad connected", m_iID);
+			m_oConnectedCallbacks.dispatch(0);
+		}
+		m_oPressedCallbacks.dispatchMask(&iPressedMask);
+		m_oReleasedCallbacks.dispatchMask(&iReleasedMask);
+		m_oDeadzoneCallbacks.dispatchMask(&iDeadzoneMask);
+
 		return true;
 	}
 
@@ -129,7 +280,14 @@ namespace rlInput
 		memset(m_oButtons,        0, sizeof(m_oButtons));
 		memset(m_oThumbSticks,    0, sizeof(m_oThumbSticks));
 		memset(m_oTriggerButtons, 0, sizeof(m_oTriggerButtons));
+		m_oRepeat.reset();
+		for (auto &oStick : m_oStickFilters)
+		{
+			for (auto &o : oStick)
+				o.reset();
+		}
 
+		// setVibration() skips the write if the motors are already known to be off
 		if (!setVibration(0, 0))
 		{
 			m_iLeftVibration  = 0;
@@ -137,15 +295,76 @@ namespace rlInput
 		}
 	}
 
+	void XInput::Gamepad::applyRepeats() noexcept
+	{
+		uint64_t iRepeatedMask = 0;
+		m_oRepeat.advance(m_tpPrepared, &iRepeatedMask);
+
+		for (; iRepeatedMask; iRepeatedMask &= iRepeatedMask - 1)
+		{
+			const auto i = std::countr_zero(iRepeatedMask);
+
+			if (i < XINPUT_BUTTON_LEFT_THUMB)
+				m_oButtons[i].bRepeated = true;
+			else
+				m_oThumbSticks[i - XINPUT_BUTTON_LEFT_THUMB].oButton.bRepeated = true;
+		}
+	}
+
+	void XInput::Gamepad::applyFilters() noexcept
+	{
+		const float fDeltaTime = std::chrono::duration<float>(m_tpPrepared - m_tpFiltered).count();
+		m_tpFiltered = m_tpPrepared;
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			auto &o = m_oThumbSticks[i];
+
+			if (!m_bStickFilterEnabled[i])
+			{
+				o.fFilteredX = o.iX;
+				o.fFilteredY = o.iY;
+				continue;
+			}
+
+			o.fFilteredX = m_oStickFilters[i][0].filter(o.iX, fDeltaTime);
+			o.fFilteredY = m_oStickFilters[i][1].filter(o.iY, fDeltaTime);
+		}
+	}
+
+	void XInput::Gamepad::setThumbStickFilter(unsigned iStick, bool bEnabled,
+		const OneEuroFilter::Settings &oSettings) noexcept
+	{
+		m_bStickFilterEnabled[iStick] = bEnabled;
+
+		for (auto &o : m_oStickFilters[iStick])
+		{
+			o.setSettings(oSettings);
+			o.reset();
+		}
+	}
+
+	void XInput::Gamepad::silence() noexcept
+	{
+		XINPUT_VIBRATION oVib{};
+		m_oOwner.m_oBackend.pfnSetState(m_iID, &oVib);
+
+		m_iLeftVibration  = 0;
+		m_iRightVibration = 0;
+	}
+
 	bool XInput::Gamepad::setVibration(WORD iLeftVibration, WORD iRightVibration) noexcept
 	{
+		if (iLeftVibration == m_iLeftVibration && iRightVibration == m_iRightVibration)
+			return true; // already applied
+
 		XINPUT_VIBRATION oVib =
 		{
 			.wLeftMotorSpeed  = iLeftVibration,
 			.wRightMotorSpeed = iRightVibration
 		};
 
-		bool bResult = XInputSetState(m_iID, &oVib) == ERROR_SUCCESS;
+		bool bResult = m_oOwner.m_oBackend.pfnSetState(m_iID, &oVib) == ERROR_SUCCESS;
 
 		if (bResult)
 		{
@@ -162,27 +381,46 @@ namespace rlInput
 
 	void XInput::prepare() noexcept
 	{
+		RLINPUT_TRACE_SCOPE("XInput::prepare");
 		for (auto &o : m_oGamepads)
 			o.prepare();
+
+		m_oStats.endFrame();
 	}
 
 	bool XInput::update(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
 	{
+		RLINPUT_TRACE_SCOPE_ARG("XInput::update", uMsg);
 		switch (uMsg)
 		{
 		case WM_SETFOCUS:
-			s_bForeground = true;
+			m_bForeground = true;
 			break;
 
 		case WM_KILLFOCUS:
-			s_bForeground = false;
+		{
+			std::lock_guard oLock(m_oMotorMutex);
+			m_bForeground = false;
+
+			// only the motors that may be running
+			for (auto &o : m_oGamepads)
+			{
+				if (o.m_iLeftVibration || o.m_iRightVibration ||
+					(m_iScheduledMotors & (1 << o.m_iID)))
+					o.silence();
+			}
+			m_iScheduledMotors = 0;
+
 			reset();
 			break;
+		}
 
 		default:
+			m_oStats.countMessage(false);
 			return false;
 		}
 
+		m_oStats.countMessage(true);
 		return true;
 	}
 
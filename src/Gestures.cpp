@@ -0,0 +1,95 @@
+#include <rlInput/Gestures.hpp>
+
+// STL
+#include <cmath>
+
+namespace rlInput
+{
+
+	void GestureRecognizer::advance(bool bPressed, bool bDown, bool bReleased, int iX, int iY,
+		Clock::time_point tpNow) noexcept
+	{
+		auto &o = m_oState;
+
+		o.bDragStarted = false;
+		o.bDragEnded   = false;
+		o.bHeld        = false;
+		o.bFlicked     = false;
+
+
+
+		// velocity estimate (exponential moving average over the frame velocities)
+		if (m_bHasLast && tpNow > m_tpLast)
+		{
+			const double dDeltaTime = std::chrono::duration<double>(tpNow - m_tpLast).count();
+			const double dSmoothing =
+				std::chrono::duration<double>(m_oSettings.tVelocitySmoothing).count();
+			const double dAlpha =
+				dSmoothing > 0.0 ? 1.0 - std::exp(-dDeltaTime / dSmoothing) : 1.0;
+
+			o.dVelocityX += dAlpha * ((iX - m_iLastX) / dDeltaTime - o.dVelocityX);
+			o.dVelocityY += dAlpha * ((iY - m_iLastY) / dDeltaTime - o.dVelocityY);
+		}
+		m_bHasLast = true;
+		m_iLastX   = iX;
+		m_iLastY   = iY;
+		m_tpLast   = tpNow;
+
+
+
+		if (bPressed)
+		{
+			m_ePhase          = Phase::Pressed;
+			m_bHoldRecognized = false;
+			m_tpPressed       = tpNow;
+
+			o.iStartX = iX;
+			o.iStartY = iY;
+		}
+
+		if (m_ePhase == Phase::Idle)
+			return;
+
+		o.iDeltaX = iX - o.iStartX;
+		o.iDeltaY = iY - o.iStartY;
+
+		if (m_ePhase == Phase::Pressed)
+		{
+			const long long iThreshold = m_oSettings.iDragThreshold;
+			const long long iDistanceSq =
+				(long long)o.iDeltaX * o.iDeltaX + (long long)o.iDeltaY * o.iDeltaY;
+
+			if (iDistanceSq > iThreshold * iThreshold)
+			{
+				m_ePhase       = Phase::Dragging;
+				o.bDragStarted = true;
+			}
+			else if (bDown && !m_bHoldRecognized && tpNow - m_tpPressed >= m_oSettings.tHoldDelay)
+			{
+				m_bHoldRecognized = true;
+				o.bHeld           = true;
+			}
+		}
+
+		o.bDragging = m_ePhase == Phase::Dragging;
+
+		if (bReleased || !bDown)
+		{
+			const double dSpeedSq = o.dVelocityX * o.dVelocityX + o.dVelocityY * o.dVelocityY;
+
+			o.bDragEnded = o.bDragging;
+			o.bDragging  = false;
+			o.bFlicked   = dSpeedSq >= m_oSettings.dFlickSpeed * m_oSettings.dFlickSpeed;
+			m_ePhase     = Phase::Idle;
+		}
+	}
+
+	void GestureRecognizer::reset() noexcept
+	{
+		m_oState          = {};
+		m_ePhase          = Phase::Idle;
+		m_bHoldRecognized = false;
+		m_bHasLast        = false;
+	}
+
+}
@@ -0,0 +1,321 @@
+#include <rlInput/Haptics.hpp>
+#include <rlInput/Trace.hpp>
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		WORD MotorSpeed(float fStrength) noexcept
+		{
+			if (fStrength <= 0.0f)
+				return 0;
+			if (fStrength >= 1.0f)
+				return 65535;
+
+			return WORD(fStrength * 65535.0f + 0.5f);
+		}
+
+	}
+
+
+
+
+
+	HapticsScheduler::HapticsScheduler(XInput &oXInput, bool bThread) : m_oXInput(oXInput)
+	{
+		if (bThread)
+			m_oThread = std::thread(&HapticsScheduler::threadProc, this);
+	}
+
+	HapticsScheduler::~HapticsScheduler()
+	{
+		if (m_oThread.joinable())
+		{
+			{
+				std::lock_guard oLock(m_oMutex);
+				m_bStop = true;
+			}
+			m_oCondition.notify_one();
+			m_oThread.join();
+		}
+
+		// silence the motors directly, without the rate limit
+		for (unsigned iPad = 0; iPad < 4; ++iPad)
+		{
+			if (m_oPads[iPad].iLeft == 0 && m_oPads[iPad].iRight == 0)
+				continue;
+
+			XINPUT_VIBRATION oVib{};
+			write(iPad, oVib);
+		}
+	}
+
+	HapticsScheduler::EffectID HapticsScheduler::play(unsigned iGamepad,
+		const HapticEffect &oEffect) noexcept
+	{
+		if (iGamepad >= 4)
+			return 0;
+
+		EffectID iID;
+		{
+			std::lock_guard oLock(m_oMutex);
+
+			auto &oPad = m_oPads[iGamepad];
+			if (oPad.iEffectCount == MaxEffects)
+				return 0;
+
+			iID = m_iNextID++;
+			oPad.oEffects[oPad.iEffectCount++] = { oEffect, iID, Clock::now() };
+			m_bWake = true;
+		}
+		m_oCondition.notify_one();
+
+		return iID;
+	}
+
+	bool HapticsScheduler::stop(EffectID iEffect) noexcept
+	{
+		{
+			std::lock_guard oLock(m_oMutex);
+
+			bool bFound = false;
+			for (auto &oPad : m_oPads)
+			{
+				for (size_t i = 0; i < oPad.iEffectCount; ++i)
+				{
+					if (oPad.oEffects[i].iID != iEffect)
+						continue;
+
+					oPad.oEffects[i] = oPad.oEffects[--oPad.iEffectCount];
+					bFound = true;
+					break;
+				}
+			}
+			if (!bFound)
+				return false;
+
+			m_bWake = true;
+		}
+		m_oCondition.notify_one();
+
+		return true;
+	}
+
+	void HapticsScheduler::stopAll(unsigned iGamepad) noexcept
+	{
+		if (iGamepad >= 4)
+			return;
+
+		{
+			std::lock_guard oLock(m_oMutex);
+			m_oPads[iGamepad].iEffectCount = 0;
+			m_bWake = true;
+		}
+		m_oCondition.notify_one();
+	}
+
+	void HapticsScheduler::stopAll() noexcept
+	{
+		{
+			std::lock_guard oLock(m_oMutex);
+			for (auto &oPad : m_oPads)
+			{
+				oPad.iEffectCount = 0;
+			}
+			m_bWake = true;
+		}
+		m_oCondition.notify_one();
+	}
+
+	bool HapticsScheduler::playing(EffectID iEffect) const noexcept
+	{
+		std::lock_guard oLock(m_oMutex);
+		for (auto &oPad : m_oPads)
+		{
+			for (size_t i = 0; i < oPad.iEffectCount; ++i)
+			{
+				if (oPad.oEffects[i].iID == iEffect)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	void HapticsScheduler::setSettings(const Settings &oSettings) noexcept
+	{
+		{
+			std::lock_guard oLock(m_oMutex);
+			m_oSettings = oSettings;
+			m_bWake = true;
+		}
+		m_oCondition.notify_one();
+	}
+
+	void HapticsScheduler::tick(Clock::time_point tpNow) noexcept
+	{
+		update(tpNow);
+	}
+
+	WORD HapticsScheduler::leftMotor(unsigned iGamepad) const noexcept
+	{
+		std::lock_guard oLock(m_oMutex);
+		return m_oPads[iGamepad].iLeft;
+	}
+
+	WORD HapticsScheduler::rightMotor(unsigned iGamepad) const noexcept
+	{
+		std::lock_guard oLock(m_oMutex);
+		return m_oPads[iGamepad].iRight;
+	}
+
+	uint64_t HapticsScheduler::writeCount() const noexcept
+	{
+		std::lock_guard oLock(m_oMutex);
+		return m_iWrites;
+	}
+
+	float HapticsScheduler::Envelope(const Effect &oEffect, Clock::time_point tpNow) noexcept
+	{
+		const auto &o = oEffect.oEffect;
+
+		auto td = tpNow - oEffect.tpStart;
+		if (td.count() < 0)
+			td = {}; // started after tpNow was taken
+
+		float f;
+		if (td < o.tdAttack)
+			f = float(td.count()) / float(o.tdAttack.count());
+		else
+		{
+			const auto tdAfterAttack = td - o.tdAttack;
+			if (o.tdSustain == HapticEffect::Infinite || tdAfterAttack < o.tdSustain)
+				f = 1.0f;
+			else
+			{
+				const auto tdReleasing = tdAfterAttack - o.tdSustain;
+				if (tdReleasing >= o.tdRelease)
+					return -1.0f; // ended
+
+				f = 1.0f - float(tdReleasing.count()) / float(o.tdRelease.count());
+			}
+		}
+
+		if (o.tdPulsePeriod.count() > 0 &&
+			float((td % o.tdPulsePeriod).count()) >= o.fPulseDuty * float(o.tdPulsePeriod.count()))
+			f = 0.0f;
+
+		return f;
+	}
+
+	bool HapticsScheduler::update(Clock::time_point tpNow) noexcept
+	{
+		bool bWrite[4]{};
+		XINPUT_VIBRATION oVibs[4]{};
+		bool bBusy = false;
+
+		// XInput::update() silences the motors when the focus is lost (see write())
+		const bool bForeground = m_oXInput.foreground();
+
+		{
+			std::lock_guard oLock(m_oMutex);
+
+			for (unsigned iPad = 0; iPad < 4; ++iPad)
+			{
+				auto &oPad = m_oPads[iPad];
+
+				float fLow  = 0.0f;
+				float fHigh = 0.0f;
+				for (size_t i = 0; i < oPad.iEffectCount; )
+				{
+					const float f = Envelope(oPad.oEffects[i], tpNow);
+					if (f < 0.0f)
+					{
+						oPad.oEffects[i] = oPad.oEffects[--oPad.iEffectCount];
+						continue;
+					}
+
+					fLow  += f * oPad.oEffects[i].oEffect.fLowFrequency;
+					fHigh += f * oPad.oEffects[i].oEffect.fHighFrequency;
+					++i;
+				}
+				if (oPad.iEffectCount)
+					bBusy = true;
+
+				if (!bForeground)
+					fLow = fHigh = 0.0f; // the effects keep running, but can't be felt
+
+				const WORD iLeft  = MotorSpeed(fLow);
+				const WORD iRight = MotorSpeed(fHigh);
+				if (iLeft == oPad.iLeft && iRight == oPad.iRight)
+					continue; // unchanged
+
+				if (tpNow - oPad.tpLastWrite < m_oSettings.tdMinWriteInterval)
+				{
+					bBusy = true; // write later
+					continue;
+				}
+
+				bWrite[iPad] = true;
+				oVibs[iPad]  = { .wLeftMotorSpeed = iLeft, .wRightMotorSpeed = iRight };
+
+				// not retried if the write fails (e.g. the gamepad isn't connected)
+				oPad.iLeft       = iLeft;
+				oPad.iRight      = iRight;
+				oPad.tpLastWrite = tpNow;
+				++m_iWrites;
+			}
+		}
+
+		for (unsigned iPad = 0; iPad < 4; ++iPad)
+		{
+			if (!bWrite[iPad])
+				continue;
+
+			write(iPad, oVibs[iPad]);
+		}
+
+		return bBusy;
+	}
+
+	void HapticsScheduler::write(unsigned iGamepad, XINPUT_VIBRATION &oVibration) noexcept
+	{
+		const bool bOn = oVibration.wLeftMotorSpeed || oVibration.wRightMotorSpeed;
+
+		std::lock_guard oLock(m_oXInput.m_oMotorMutex);
+		if (bOn && !m_oXInput.m_bForeground)
+			return; // the focus was lost after the speeds were computed --> next update() fixes it
+
+		{
+			RLINPUT_TRACE_SCOPE_ARG("XInputSetState", iGamepad);
+			m_oXInput.m_oBackend.pfnSetState(iGamepad, &oVibration);
+		}
+
+		// --> XInput::update() knows which motors to stop when the focus is lost
+		if (bOn)
+			m_oXInput.m_iScheduledMotors |= uint8_t(1 << iGamepad);
+		else
+			m_oXInput.m_iScheduledMotors &= uint8_t(~(1 << iGamepad));
+	}
+
+	void HapticsScheduler::threadProc() noexcept
+	{
+		std::unique_lock oLock(m_oMutex);
+		while (!m_bStop)
+		{
+			m_bWake = false;
+
+			oLock.unlock();
+			const bool bBusy = update(Clock::now());
+			oLock.lock();
+
+			const auto oWake = [this] { return m_bStop || m_bWake; };
+			if (bBusy)
+				m_oCondition.wait_for(oLock, m_oSettings.tdTick, oWake);
+			else
+				m_oCondition.wait(oLock, oWake); // sleep until something changes
+		}
+	}
+
+}
@@ -0,0 +1,580 @@
+#include <rlInput/InputCodec.hpp>
+
+// STL
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		/// <summary>
+		/// Writes values of up to 32 bits, least significant bit first.
+		/// </summary>
+		class BitWriter final
+		{
+		public: // methods
+
+			BitWriter(uint8_t *pDest, size_t iDestSize) noexcept :
+				m_pDest(pDest), m_pEnd(pDest + iDestSize)
+			{}
+
+			void write(uint32_t iValue, unsigned iBits) noexcept
+			{
+				m_iBuffer |= uint64_t(iValue) << m_iBufferBits;
+				m_iBufferBits += iBits;
+				while (m_iBufferBits >= 8)
+				{
+					put(uint8_t(m_iBuffer));
+					m_iBuffer >>= 8;
+					m_iBufferBits -= 8;
+				}
+			}
+
+			void writeBit(bool b) noexcept { write(b, 1); }
+
+			/// <returns>The count of bytes written, or 0 if the buffer was too small.</returns>
+			size_t finish() noexcept
+			{
+				if (m_iBufferBits)
+					put(uint8_t(m_iBuffer));
+				return m_bOverflow ? 0 : size_t(m_pPos - m_pDest);
+			}
+
+
+		private: // methods
+
+			void put(uint8_t i) noexcept
+			{
+				if (m_pPos == m_pEnd)
+					m_bOverflow = true;
+				else
+					*m_pPos++ = i;
+			}
+
+
+		private: // variables
+
+			uint8_t *const m_pDest;
+			uint8_t *const m_pEnd;
+			uint8_t *m_pPos = m_pDest;
+			uint64_t m_iBuffer = 0;
+			unsigned m_iBufferBits = 0;
+			bool m_bOverflow = false;
+
+		};
+
+		/// <summary>
+		/// Reads the values written by a <c>BitWriter</c>.<para/>
+		/// Reading past the end yields zeros and marks the data as invalid.
+		/// </summary>
+		class BitReader final
+		{
+		public: // methods
+
+			BitReader(const uint8_t *pSrc, size_t iSize) noexcept :
+				m_pPos(pSrc), m_pEnd(pSrc + iSize)
+			{}
+
+			uint32_t read(unsigned iBits) noexcept
+			{
+				while (m_iBufferBits < iBits)
+				{
+					if (m_pPos == m_pEnd)
+					{
+						m_bOverflow = true;
+						return 0;
+					}
+					m_iBuffer |= uint64_t(*m_pPos++) << m_iBufferBits;
+					m_iBufferBits += 8;
+				}
+
+				const uint32_t iValue = uint32_t(m_iBuffer & ((uint64_t(1) << iBits) - 1));
+				m_iBuffer >>= iBits;
+				m_iBufferBits -= iBits;
+				return iValue;
+			}
+
+			bool readBit() noexcept { return read(1) != 0; }
+
+			/// <summary>
+			/// Was all data read, without reading past the end?
+			/// </summary>
+			bool complete() const noexcept
+			{
+				return !m_bOverflow && m_pPos == m_pEnd && m_iBuffer == 0;
+			}
+
+
+		private: // variables
+
+			const uint8_t *m_pPos;
+			const uint8_t *const m_pEnd;
+			uint64_t m_iBuffer = 0;
+			unsigned m_iBufferBits = 0;
+			bool m_bOverflow = false;
+
+		};
+
+
+
+		int32_t ClampSigned(int32_t i, unsigned iBits) noexcept
+		{
+			if (iBits == 0)
+				return 0;
+
+			const int64_t iMax = (int64_t(1) << (iBits - 1)) - 1;
+			return int32_t(std::clamp<int64_t>(i, -iMax - 1, iMax));
+		}
+
+		uint32_t EncodeSigned(int32_t i, unsigned iBits) noexcept
+		{
+			return uint32_t(i) & uint32_t((uint64_t(1) << iBits) - 1);
+		}
+
+		int32_t DecodeSigned(uint32_t i, unsigned iBits) noexcept
+		{
+			return int32_t(i << (32 - iBits)) >> (32 - iBits); // sign extension
+		}
+
+		// sticks: the upper iBits of the (unsigned) value
+		uint32_t EncodeStick(int16_t i, unsigned iBits) noexcept
+		{
+			return uint32_t(uint16_t(i + 32768)) >> (16 - iBits);
+		}
+
+		int16_t DecodeStick(uint32_t i, unsigned iBits) noexcept
+		{
+			return int16_t(int32_t(i << (16 - iBits)) - 32768);
+		}
+
+		// triggers: the upper iBits of the value, decoded to the full range (0 to 255)
+		uint32_t EncodeTrigger(uint8_t i, unsigned iBits) noexcept
+		{
+			return uint32_t(i) >> (8 - iBits);
+		}
+
+		uint8_t DecodeTrigger(uint32_t i, unsigned iBits) noexcept
+		{
+			return uint8_t(i * 255 / ((1u << iBits) - 1));
+		}
+
+		// the bits of iValue selected by iMask, packed (like the BMI2 instruction PEXT)
+		uint32_t Extract(uint32_t iValue, uint32_t iMask) noexcept
+		{
+			uint32_t iResult = 0;
+			for (unsigned iBit = 0; iMask; iMask &= iMask - 1, ++iBit)
+			{
+				if (iValue & iMask & (~iMask + 1))
+					iResult |= 1u << iBit;
+			}
+			return iResult;
+		}
+
+		// the reverse of Extract() (like the BMI2 instruction PDEP)
+		uint32_t Deposit(uint32_t iValue, uint32_t iMask) noexcept
+		{
+			uint32_t iResult = 0;
+			for (unsigned iBit = 0; iMask; iMask &= iMask - 1, ++iBit)
+			{
+				if (iValue & (1u << iBit))
+					iResult |= iMask & (~iMask + 1);
+			}
+			return iResult;
+		}
+
+		uint64_t Mix(uint64_t iHash, uint64_t iValue) noexcept
+		{
+			iHash = (iHash ^ iValue) * 0x9E3779B97F4A7C15ull;
+			return iHash ^ (iHash >> 29);
+		}
+
+		bool SameKeys(const InputSnapshot &o1, const InputSnapshot &o2) noexcept
+		{
+			return o1.oKeys[0] == o2.oKeys[0] && o1.oKeys[1] == o2.oKeys[1] &&
+				o1.oKeys[2] == o2.oKeys[2] && o1.oKeys[3] == o2.oKeys[3];
+		}
+
+		bool SameSticks(const InputSnapshot::Pad &o1, const InputSnapshot::Pad &o2) noexcept
+		{
+			return o1.iLeftX == o2.iLeftX && o1.iLeftY == o2.iLeftY &&
+				o1.iRightX == o2.iRightX && o1.iRightY == o2.iRightY;
+		}
+
+	}
+
+
+
+
+
+	InputSnapshot InputSnapshot::Capture(const Keyboard *pKeyboard, const Mouse *pMouse,
+		const XInput *pXInput) noexcept
+	{
+		InputSnapshot o{};
+
+		if (pKeyboard)
+		{
+			for (unsigned iKey = 0; iKey < 256; ++iKey)
+			{
+				if (pKeyboard->key((unsigned char)iKey).bDown)
+					o.oKeys[iKey / 64] |= uint64_t(1) << (iKey % 64);
+			}
+		}
+
+		if (pMouse)
+		{
+			for (unsigned char iButton = 0; iButton < 3; ++iButton)
+			{
+				if (pMouse->button(iButton).bDown)
+					o.iMouseButtons |= uint8_t(1 << iButton);
+			}
+
+			constexpr double dMax = 2147483647.0;
+			o.iMouseDeltaX = int32_t(std::clamp(std::round(pMouse->deltaX()), -dMax, dMax));
+			o.iMouseDeltaY = int32_t(std::clamp(std::round(pMouse->deltaY()), -dMax, dMax));
+			o.iWheel       = pMouse->weelRotation();
+		}
+
+		if (pXInput)
+		{
+			for (unsigned iPad = 0; iPad < 4; ++iPad)
+			{
+				const auto &oGamepad = pXInput->gamepad(iPad);
+				if (!oGamepad.connected())
+					continue;
+
+				auto &oPad = o.oPads[iPad];
+				oPad.bConnected = true;
+				for (unsigned char iButton = 0; iButton < 12; ++iButton)
+				{
+					if (oGamepad.button(iButton).bDown)
+						oPad.iButtons |= uint16_t(1 << iButton);
+				}
+				oPad.iLeftTrigger  = oGamepad.leftTrigger().iState;
+				oPad.iRightTrigger = oGamepad.rightTrigger().iState;
+				oPad.iLeftX        = oGamepad.leftThumbStick().iX;
+				oPad.iLeftY        = oGamepad.leftThumbStick().iY;
+				oPad.iRightX       = oGamepad.rightThumbStick().iX;
+				oPad.iRightY       = oGamepad.rightThumbStick().iY;
+			}
+		}
+
+		return o;
+	}
+
+	InputCodec::InputCodec(const InputLayout &oLayout) noexcept : m_oLayout(oLayout)
+	{
+		auto &o = m_oLayout;
+		o.iMouseButtons  &= 0x07;
+		o.iMouseDeltaBits = std::min<uint8_t>(o.iMouseDeltaBits, 32);
+		o.iWheelBits      = std::min<uint8_t>(o.iWheelBits, 32);
+		o.iPads          &= 0x0F;
+		o.iPadButtons    &= 0x0FFF;
+		o.iStickBits      = std::min<uint8_t>(o.iStickBits, 16);
+		o.iTriggerBits    = std::min<uint8_t>(o.iTriggerBits, 8);
+
+		for (unsigned iKey = 0; iKey < 256; ++iKey)
+		{
+			if (o.oKeys[iKey / 64] & (uint64_t(1) << (iKey % 64)))
+				m_oKeyList[m_iKeyCount++] = (unsigned char)iKey;
+		}
+
+		// worst case: a full snapshot (or all "changed" flags set)
+		size_t iBits = 1; // relative to a reference?
+		if (m_iKeyCount)
+			iBits += 1 + m_iKeyCount;
+		if (o.iMouseButtons)
+			iBits += 1 + std::popcount(o.iMouseButtons);
+		if (o.iMouseDeltaBits)
+			iBits += 1 + 2 * o.iMouseDeltaBits;
+		if (o.iWheelBits)
+			iBits += 1 + o.iWheelBits;
+
+		size_t iPadBits = 2; // changed, connected
+		if (o.iPadButtons)
+			iPadBits += 1 + std::popcount(o.iPadButtons);
+		if (o.iTriggerBits)
+			iPadBits += 1 + 2 * o.iTriggerBits;
+		if (o.iStickBits)
+			iPadBits += 1 + 4 * o.iStickBits;
+		iBits += iPadBits * std::popcount(o.iPads);
+
+		m_iMaxBytes = (iBits + 7) / 8;
+	}
+
+	void InputCodec::quantize(InputSnapshot &oSnapshot) const noexcept
+	{
+		const auto &oLayout = m_oLayout;
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			oSnapshot.oKeys[i] &= oLayout.oKeys[i];
+		}
+
+		oSnapshot.iMouseButtons &= oLayout.iMouseButtons;
+		oSnapshot.iMouseDeltaX = ClampSigned(oSnapshot.iMouseDeltaX, oLayout.iMouseDeltaBits);
+		oSnapshot.iMouseDeltaY = ClampSigned(oSnapshot.iMouseDeltaY, oLayout.iMouseDeltaBits);
+		oSnapshot.iWheel       = ClampSigned(oSnapshot.iWheel, oLayout.iWheelBits);
+
+		for (unsigned iPad = 0; iPad < 4; ++iPad)
+		{
+			auto &oPad = oSnapshot.oPads[iPad];
+			if (!(oLayout.iPads & (1 << iPad)) || !oPad.bConnected)
+			{
+				oPad = {};
+				continue;
+			}
+
+			oPad.iButtons &= oLayout.iPadButtons;
+
+			if (const unsigned iBits = oLayout.iTriggerBits)
+			{
+				oPad.iLeftTrigger  = DecodeTrigger(EncodeTrigger(oPad.iLeftTrigger,  iBits), iBits);
+				oPad.iRightTrigger = DecodeTrigger(EncodeTrigger(oPad.iRightTrigger, iBits), iBits);
+			}
+			else
+				oPad.iLeftTrigger = oPad.iRightTrigger = 0;
+
+			if (const unsigned iBits = oLayout.iStickBits)
+			{
+				oPad.iLeftX  = DecodeStick(EncodeStick(oPad.iLeftX,  iBits), iBits);
+				oPad.iLeftY  = DecodeStick(EncodeStick(oPad.iLeftY,  iBits), iBits);
+				oPad.iRightX = DecodeStick(EncodeStick(oPad.iRightX, iBits), iBits);
+				oPad.iRightY = DecodeStick(EncodeStick(oPad.iRightY, iBits), iBits);
+			}
+			else
+				oPad.iLeftX = oPad.iLeftY = oPad.iRightX = oPad.iRightY = 0;
+		}
+	}
+
+	size_t InputCodec::encode(const InputSnapshot &oSnapshot, const InputSnapshot *pReference,
+		uint8_t *pDest, size_t iDestSize) const noexcept
+	{
+		const auto &oLayout = m_oLayout;
+
+		InputSnapshot oNew = oSnapshot;
+		quantize(oNew);
+
+		InputSnapshot oOld{};
+		if (pReference)
+		{
+			oOld = *pReference;
+			quantize(oOld);
+		}
+
+		BitWriter oWriter(pDest, iDestSize);
+		const bool bDelta = pReference != nullptr;
+		oWriter.writeBit(bDelta);
+
+		// in delta mode, every group of values is preceded by a "changed" flag
+		const auto fnGroup = [&](bool bChanged) noexcept
+		{
+			if (!bDelta)
+				return true;
+
+			oWriter.writeBit(bChanged);
+			return bChanged;
+		};
+
+		if (m_iKeyCount && fnGroup(!SameKeys(oNew, oOld)))
+		{
+			uint32_t iChunk = 0;
+			unsigned iChunkBits = 0;
+			for (unsigned i = 0; i < m_iKeyCount; ++i)
+			{
+				const unsigned char iKey = m_oKeyList[i];
+				iChunk |= uint32_t((oNew.oKeys[iKey / 64] >> (iKey % 64)) & 1) << iChunkBits;
+				if (++iChunkBits == 32)
+				{
+					oWriter.write(iChunk, 32);
+					iChunk     = 0;
+					iChunkBits = 0;
+				}
+			}
+			if (iChunkBits)
+				oWriter.write(iChunk, iChunkBits);
+		}
+
+		if (oLayout.iMouseButtons && fnGroup(oNew.iMouseButtons != oOld.iMouseButtons))
+		{
+			oWriter.write(Extract(oNew.iMouseButtons, oLayout.iMouseButtons),
+				std::popcount(oLayout.iMouseButtons));
+		}
+
+		if (const unsigned iBits = oLayout.iMouseDeltaBits; iBits &&
+			fnGroup(oNew.iMouseDeltaX != oOld.iMouseDeltaX ||
+				oNew.iMouseDeltaY != oOld.iMouseDeltaY))
+		{
+			oWriter.write(EncodeSigned(oNew.iMouseDeltaX, iBits), iBits);
+			oWriter.write(EncodeSigned(oNew.iMouseDeltaY, iBits), iBits);
+		}
+
+		if (const unsigned iBits = oLayout.iWheelBits; iBits && fnGroup(oNew.iWheel != oOld.iWheel))
+			oWriter.write(EncodeSigned(oNew.iWheel, iBits), iBits);
+
+		for (unsigned iPad = 0; iPad < 4; ++iPad)
+		{
+			if (!(oLayout.iPads & (1 << iPad)))
+				continue;
+
+			const auto &oPad    = oNew.oPads[iPad];
+			const auto &oOldPad = oOld.oPads[iPad];
+			if (!fnGroup(oPad != oOldPad))
+				continue;
+
+			oWriter.writeBit(oPad.bConnected);
+			if (!oPad.bConnected)
+				continue;
+
+			if (oLayout.iPadButtons && fnGroup(oPad.iButtons != oOldPad.iButtons))
+			{
+				oWriter.write(Extract(oPad.iButtons, oLayout.iPadButtons),
+					std::popcount(oLayout.iPadButtons));
+			}
+
+			if (const unsigned iBits = oLayout.iTriggerBits; iBits &&
+				fnGroup(oPad.iLeftTrigger != oOldPad.iLeftTrigger ||
+					oPad.iRightTrigger != oOldPad.iRightTrigger))
+			{
+				oWriter.write(EncodeTrigger(oPad.iLeftTrigger,  iBits), iBits);
+				oWriter.write(EncodeTrigger(oPad.iRightTrigger, iBits), iBits);
+			}
+
+			if (const unsigned iBits = oLayout.iStickBits; iBits &&
+				fnGroup(!SameSticks(oPad, oOldPad)))
+			{
+				oWriter.write(EncodeStick(oPad.iLeftX,  iBits), iBits);
+				oWriter.write(EncodeStick(oPad.iLeftY,  iBits), iBits);
+				oWriter.write(EncodeStick(oPad.iRightX, iBits), iBits);
+				oWriter.write(EncodeStick(oPad.iRightY, iBits), iBits);
+			}
+		}
+
+		return oWriter.finish();
+	}
+
+	bool InputCodec::decode(const uint8_t *pSrc, size_t iSize, const InputSnapshot *pReference,
+		InputSnapshot &oDest) const noexcept
+	{
+		const auto &oLayout = m_oLayout;
+
+		BitReader oReader(pSrc, iSize);
+		const bool bDelta = oReader.readBit();
+		if (bDelta && !pReference)
+			return false;
+
+		// unchanged groups keep the values of the reference
+		InputSnapshot o{};
+		if (bDelta)
+		{
+			o = *pReference;
+			quantize(o);
+		}
+
+		const auto fnGroup = [&]() noexcept { return !bDelta || oReader.readBit(); };
+
+		if (m_iKeyCount && fnGroup())
+		{
+			for (size_t i = 0; i < 4; ++i)
+			{
+				o.oKeys[i] = 0;
+			}
+
+			for (unsigned i = 0; i < m_iKeyCount; i += 32)
+			{
+				const unsigned iChunkBits = std::min(32u, m_iKeyCount - i);
+				const uint32_t iChunk     = oReader.read(iChunkBits);
+				for (unsigned iBit = 0; iBit < iChunkBits; ++iBit)
+				{
+					const unsigned char iKey = m_oKeyList[i + iBit];
+					o.oKeys[iKey / 64] |= uint64_t((iChunk >> iBit) & 1) << (iKey % 64);
+				}
+			}
+		}
+
+		if (oLayout.iMouseButtons && fnGroup())
+		{
+			o.iMouseButtons = uint8_t(Deposit(oReader.read(std::popcount(oLayout.iMouseButtons)),
+				oLayout.iMouseButtons));
+		}
+
+		if (const unsigned iBits = oLayout.iMouseDeltaBits; iBits && fnGroup())
+		{
+			o.iMouseDeltaX = DecodeSigned(oReader.read(iBits), iBits);
+			o.iMouseDeltaY = DecodeSigned(oReader.read(iBits), iBits);
+		}
+
+		if (const unsigned iBits = oLayout.iWheelBits; iBits && fnGroup())
+			o.iWheel = DecodeSigned(oReader.read(iBits), iBits);
+
+		for (unsigned iPad = 0; iPad < 4; ++iPad)
+		{
+			if (!(oLayout.iPads & (1 << iPad)) || !fnGroup())
+				continue;
+
+			auto &oPad = o.oPads[iPad];
+			if (!oReader.readBit())
+			{
+				oPad = {};
+				continue;
+			}
+			oPad.bConnected = true; // if it wasn't connected before, the reference values are zero
+
+			if (oLayout.iPadButtons && fnGroup())
+			{
+				oPad.iButtons = uint16_t(Deposit(oReader.read(std::popcount(oLayout.iPadButtons)),
+					oLayout.iPadButtons));
+			}
+
+			if (const unsigned iBits = oLayout.iTriggerBits; iBits && fnGroup())
+			{
+				oPad.iLeftTrigger  = DecodeTrigger(oReader.read(iBits), iBits);
+				oPad.iRightTrigger = DecodeTrigger(oReader.read(iBits), iBits);
+			}
+
+			if (const unsigned iBits = oLayout.iStickBits; iBits && fnGroup())
+			{
+				oPad.iLeftX  = DecodeStick(oReader.read(iBits), iBits);
+				oPad.iLeftY  = DecodeStick(oReader.read(iBits), iBits);
+				oPad.iRightX = DecodeStick(oReader.read(iBits), iBits);
+				oPad.iRightY = DecodeStick(oReader.read(iBits), iBits);
+			}
+		}
+
+		if (!oReader.complete())
+			return false;
+
+		oDest = o;
+		return true;
+	}
+
+	uint64_t InputCodec::hash(const InputSnapshot &oSnapshot) const noexcept
+	{
+		InputSnapshot o = oSnapshot;
+		quantize(o);
+
+		uint64_t iHash = 0xCBF29CE484222325ull;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			iHash = Mix(iHash, o.oKeys[i]);
+		}
+		iHash = Mix(iHash, o.iMouseButtons);
+		iHash = Mix(iHash, uint64_t(uint32_t(o.iMouseDeltaX)) << 32 | uint32_t(o.iMouseDeltaY));
+		iHash = Mix(iHash, uint32_t(o.iWheel));
+
+		for (const auto &oPad : o.oPads)
+		{
+			iHash = Mix(iHash, uint64_t(oPad.bConnected) << 32 | uint64_t(oPad.iButtons) << 16 |
+				uint64_t(oPad.iLeftTrigger) << 8 | oPad.iRightTrigger);
+			iHash = Mix(iHash,
+				uint64_t(uint16_t(oPad.iLeftX))  << 48 | uint64_t(uint16_t(oPad.iLeftY)) << 32 |
+				uint64_t(uint16_t(oPad.iRightX)) << 16 | uint16_t(oPad.iRightY));
+		}
+
+		return iHash;
+	}
+
+}
@@ -0,0 +1,164 @@
+#include <rlInput/InputContext.hpp>
+
+// STL
+#include <cstdint>
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		constexpr uint8_t Target_Keyboard = 0x01;
+		constexpr uint8_t Target_Mouse    = 0x02;
+		constexpr uint8_t Target_All      = 0x04; // focus changes
+
+		/// <summary>
+		/// The devices that process a message, for all messages below <c>WM_USER</c> (no device
+		/// processes any other message).
+		/// </summary>
+		struct DispatchTable
+		{
+			uint8_t oTargets[WM_USER];
+		};
+
+		constexpr DispatchTable CreateDispatchTable() noexcept
+		{
+			DispatchTable o{};
+
+			for (UINT uMsg : Keyboard::Messages)
+			{
+				o.oTargets[uMsg] |= Target_Keyboard;
+			}
+			for (UINT uMsg : Mouse::Messages)
+			{
+				o.oTargets[uMsg] |= Target_Mouse;
+			}
+
+			// XInput and DirectInput only process focus changes
+			o.oTargets[WM_SETFOCUS]  = Target_All;
+			o.oTargets[WM_KILLFOCUS] = Target_All;
+
+			return o;
+		}
+
+		constexpr DispatchTable s_oDispatchTable = CreateDispatchTable();
+
+	}
+
+
+	InputContext &InputContext::Default() noexcept
+	{
+		static InputContext s_oDefault(Keyboard::Instance(), Mouse::Instance(), XInput::Instance(),
+			DirectInput::Instance());
+		return s_oDefault;
+	}
+
+	InputContext::InputContext(bool bDirectInput, std::pmr::memory_resource *pMemory) :
+		m_upDevices(std::pmr::polymorphic_allocator<>(pMemory).new_object<Devices>(pMemory),
+			ResourceDeleter{ pMemory }),
+		m_upDirectInput(bDirectInput ?
+			std::pmr::polymorphic_allocator<>(pMemory).new_object<DirectInput>(pMemory) : nullptr,
+			ResourceDeleter{ pMemory }),
+		m_pKeyboard(&m_upDevices->oKeyboard),
+		m_pMouse(&m_upDevices->oMouse),
+		m_pXInput(&m_upDevices->oXInput),
+		m_pDirectInput(bDirectInput ? m_upDirectInput.get() : &DirectInput::Instance()),
+		m_bUseDirectInput(bDirectInput),
+		m_oHistory(0, pMemory)
+	{}
+
+	InputContext::InputContext(Keyboard &oKeyboard, Mouse &oMouse, XInput &oXInput,
+		DirectInput &oDirectInput) noexcept :
+		m_pKeyboard(&oKeyboard),
+		m_pMouse(&oMouse),
+		m_pXInput(&oXInput),
+		m_pDirectInput(&oDirectInput),
+		m_bUseDirectInput(true)
+	{}
+
+	void InputContext::prepare() noexcept
+	{
+		m_pKeyboard->prepare();
+		m_pMouse->prepare();
+		m_pXInput->prepare();
+		if (m_bUseDirectInput)
+			m_pDirectInput->prepare();
+
+		const bool bRecord = m_bRecord || m_oHistory.capacity();
+		if (!bRecord && !m_pPublisher)
+			return;
+
+		const auto oSnapshot = InputSnapshot::Capture(m_pKeyboard, m_pMouse, m_pXInput);
+		if (bRecord)
+			m_oHistory.push(oSnapshot);
+		if (m_pPublisher)
+		{
+			SharedInputState oState{ .iMouseX = m_pMouse->x(), .iMouseY = m_pMouse->y(),
+				.oInput = oSnapshot };
+
+			if (m_bUseDirectInput)
+			{
+				for (const auto pGamepad : m_pDirectInput->gamepads())
+				{
+					if (oState.iDirectInputPads == SharedInputState::MaxDirectInputPads)
+						break;
+
+					auto &oPad = oState.oDirectInputPads[oState.iDirectInputPads++];
+					oPad.guidInstance = pGamepad->guidInstance();
+					oPad.bConnected   = pGamepad->connected();
+
+					const auto &oButtons = pGamepad->buttons();
+					for (size_t i = 0; i < oButtons.size(); ++i)
+					{
+						oPad.iButtons |= uint32_t(oButtons[i].bDown) << i;
+					}
+
+					const auto &oAxes = pGamepad->axes();
+					for (size_t i = 0; i < oAxes.size(); ++i)
+					{
+						oPad.oAxes[i] = int32_t(oAxes[i]);
+					}
+				}
+			}
+
+			m_pPublisher->publish(oState);
+		}
+	}
+
+	bool InputContext::update(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
+	{
+		const uint8_t iTargets = uMsg < WM_USER ? s_oDispatchTable.oTargets[uMsg] : 0;
+		if (!iTargets)
+			return false;
+
+		if (iTargets & Target_All)
+		{
+			// every device must see focus changes --> no short-circuiting
+			if (m_bUseDirectInput)
+				m_pDirectInput->update(hWnd, uMsg, wParam, lParam);
+
+			bool bHandled = m_pXInput->update(hWnd, uMsg, wParam, lParam);
+			bHandled |= m_pKeyboard->update(hWnd, uMsg, wParam, lParam);
+			bHandled |= m_pMouse->update(hWnd, uMsg, wParam, lParam);
+			return bHandled;
+		}
+
+		bool bHandled = false;
+		if (iTargets & Target_Keyboard)
+			bHandled |= m_pKeyboard->update(hWnd, uMsg, wParam, lParam);
+		if (iTargets & Target_Mouse)
+			bHandled |= m_pMouse->update(hWnd, uMsg, wParam, lParam);
+		return bHandled;
+	}
+
+	void InputContext::reset() noexcept
+	{
+		m_pKeyboard->reset();
+		m_pMouse->reset();
+		m_pXInput->reset();
+		if (m_bUseDirectInput)
+			m_pDirectInput->reset();
+	}
+
+}
@@ -0,0 +1,181 @@
+#include <rlInput/InputHistory.hpp>
+
+// STL
+#include <algorithm>
+
+namespace rlInput
+{
+
+	InputHistory::InputHistory(size_t iCapacity, std::pmr::memory_resource *pMemory) :
+		m_oFrames(iCapacity, pMemory)
+	{}
+
+	void InputHistory::setCapacity(size_t iCapacity)
+	{
+		std::pmr::vector<Frame> oFrames(iCapacity, m_oFrames.get_allocator());
+		m_oFrames.swap(oFrames);
+		clear(m_iNextFrame);
+	}
+
+	void InputHistory::clear(FrameIndex iNextFrame) noexcept
+	{
+		m_iNextFrame  = iNextFrame;
+		m_iFirstFrame = iNextFrame;
+		m_iCount      = 0;
+		m_oBase       = {};
+		++m_iGeneration; // --> the consumers restart at m_iFirstFrame
+	}
+
+	InputHistory::FrameIndex InputHistory::push(const InputSnapshot &oState) noexcept
+	{
+		const FrameIndex iFrame = m_iNextFrame++;
+		if (m_oFrames.empty())
+		{
+			m_oBase = oState;
+			return iFrame;
+		}
+
+		if (m_iCount == m_oFrames.size())
+			m_oBase = frame(iFrame - m_iCount).oState; // the oldest frame is overwritten
+		else
+			++m_iCount;
+
+		const InputSnapshot &oPrevious = m_iCount > 1 ? frame(iFrame - 1).oState : m_oBase;
+
+		auto &oFrame = frame(iFrame);
+		oFrame.iFrame = iFrame;
+		oFrame.oState = oState;
+		ComputeEdges(oFrame, oPrevious);
+
+		return iFrame;
+	}
+
+	InputHistory::Correction InputHistory::correct(FrameIndex iFrame,
+		const InputSnapshot &oState) noexcept
+	{
+		if (!contains(iFrame))
+			return Correction::OutOfRange;
+
+		auto &oFrame = frame(iFrame);
+		if (oFrame.oState == oState)
+			return Correction::Unchanged;
+
+		oFrame.oState = oState;
+		ComputeEdges(oFrame, iFrame == oldestFrame() ? m_oBase : frame(iFrame - 1).oState);
+
+		// only the edges of the next frame depend on this frame's state
+		if (iFrame != newestFrame())
+			ComputeEdges(frame(iFrame + 1), oState);
+
+		return Correction::Changed;
+	}
+
+	InputHistory::Consumer InputHistory::consumer() const noexcept
+	{
+		return { m_iNextFrame, empty() ? m_oBase : frame(newestFrame()).oState, m_iGeneration };
+	}
+
+	InputHistory::Frame InputHistory::read(Consumer &oConsumer) const noexcept
+	{
+		Frame o{};
+		o.iFrame = m_iNextFrame != m_iFirstFrame ? m_iNextFrame - 1 : NoFrame;
+
+		// cleared since the last read --> the consumer's position is meaningless
+		const bool bCleared = oConsumer.iGeneration != m_iGeneration;
+
+		FrameIndex iFirst = bCleared ? m_iFirstFrame : oConsumer.iNextFrame;
+		if (iFirst >= m_iNextFrame)
+		{
+			// nothing new
+			o.oState = oConsumer.oLastState;
+			o.oState.iMouseDeltaX = 0;
+			o.oState.iMouseDeltaY = 0;
+			o.oState.iWheel       = 0;
+			return o;
+		}
+
+		FrameIndex iFirstEdges = iFirst; // the first frame whose own edges are combined
+		if (bCleared || empty() || iFirst < oldestFrame())
+		{
+			// frames were dropped or forgotten before they were read
+			iFirst      = m_iNextFrame - m_iCount;
+			iFirstEdges = iFirst;
+
+			// the edges of the first frame after clear() are relative to nothing, not to the
+			// consumer's last state --> derive them from the states instead
+			const bool bNoBase = bCleared && !empty() && iFirst == m_iFirstFrame;
+			if (bNoBase)
+				++iFirstEdges;
+
+			Frame oGap{};
+			oGap.oState = bNoBase ? frame(iFirst).oState : m_oBase;
+			ComputeEdges(oGap, oConsumer.oLastState);
+			o.oEdges = oGap.oEdges;
+		}
+
+		int64_t iDeltaX = 0;
+		int64_t iDeltaY = 0;
+		int64_t iWheel  = 0;
+		for (FrameIndex iFrame = iFirst; iFrame < m_iNextFrame; ++iFrame)
+		{
+			const auto &oFrame = frame(iFrame);
+
+			iDeltaX += oFrame.oState.iMouseDeltaX;
+			iDeltaY += oFrame.oState.iMouseDeltaY;
+			iWheel  += oFrame.oState.iWheel;
+
+			if (iFrame < iFirstEdges)
+				continue;
+
+			for (size_t i = 0; i < 4; ++i)
+			{
+				o.oEdges.oKeysPressed[i]  |= oFrame.oEdges.oKeysPressed[i];
+				o.oEdges.oKeysReleased[i] |= oFrame.oEdges.oKeysReleased[i];
+				o.oEdges.oPadPressed[i]   |= oFrame.oEdges.oPadPressed[i];
+				o.oEdges.oPadReleased[i]  |= oFrame.oEdges.oPadReleased[i];
+			}
+			o.oEdges.iMousePressed  |= oFrame.oEdges.iMousePressed;
+			o.oEdges.iMouseReleased |= oFrame.oEdges.iMouseReleased;
+		}
+
+		o.oState = empty() ? m_oBase : frame(newestFrame()).oState;
+		if (!empty())
+		{
+			constexpr int64_t iMin = INT32_MIN;
+			constexpr int64_t iMax = INT32_MAX;
+			o.oState.iMouseDeltaX = int32_t(std::clamp(iDeltaX, iMin, iMax));
+			o.oState.iMouseDeltaY = int32_t(std::clamp(iDeltaY, iMin, iMax));
+			o.oState.iWheel       = int32_t(std::clamp(iWheel,  iMin, iMax));
+		}
+
+		oConsumer.iNextFrame  = m_iNextFrame;
+		oConsumer.oLastState  = o.oState;
+		oConsumer.iGeneration = m_iGeneration;
+		return o;
+	}
+
+	void InputHistory::ComputeEdges(Frame &oFrame, const InputSnapshot &oPrevious) noexcept
+	{
+		const auto &oNew = oFrame.oState;
+		auto &oEdges = oFrame.oEdges;
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			oEdges.oKeysPressed[i]  = oNew.oKeys[i] & ~oPrevious.oKeys[i];
+			oEdges.oKeysReleased[i] = ~oNew.oKeys[i] & oPrevious.oKeys[i];
+		}
+
+		oEdges.iMousePressed  = uint8_t(oNew.iMouseButtons & ~oPrevious.iMouseButtons);
+		oEdges.iMouseReleased = uint8_t(~oNew.iMouseButtons & oPrevious.iMouseButtons);
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			const uint16_t iNew = oNew.oPads[i].iButtons;
+			const uint16_t iOld = oPrevious.oPads[i].iButtons;
+
+			oEdges.oPadPressed[i]  = uint16_t(iNew & ~iOld);
+			oEdges.oPadReleased[i] = uint16_t(~iNew & iOld);
+		}
+	}
+
+}
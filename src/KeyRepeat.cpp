@@ -0,0 +1,70 @@
+#include <rlInput/KeyRepeat.hpp>
+
+// STL
+#include <chrono>
+
+namespace rlInput
+{
+
+	void KeyRepeat::press(unsigned iInput, Clock::time_point tpPressed) noexcept
+	{
+		release(iInput); // never track an input twice
+
+		if (m_iHeldCount == MaxHeld)
+			return;
+
+		m_oHeld[m_iHeldCount++] =
+		{
+			.iInput    = iInput,
+			.tpNext    = tpPressed + m_oSettings.tDelay,
+			.tInterval = m_oSettings.tInterval
+		};
+	}
+
+	void KeyRepeat::release(unsigned iInput) noexcept
+	{
+		for (size_t i = 0; i < m_iHeldCount; ++i)
+		{
+			if (m_oHeld[i].iInput != iInput)
+				continue;
+
+			m_oHeld[i] = m_oHeld[--m_iHeldCount];
+			return;
+		}
+	}
+
+	void KeyRepeat::advance(Clock::time_point tpNow, uint64_t *pRepeatedMask) noexcept
+	{
+		for (size_t i = 0; i < m_iHeldCount; ++i)
+		{
+			auto &o = m_oHeld[i];
+			if (o.tpNext > tpNow)
+				continue;
+
+			pRepeatedMask[o.iInput / 64] |= uint64_t(1) << (o.iInput % 64);
+
+			// catch up on all repeats that were due, so the timing doesn't depend on the frame rate
+			unsigned iSteps = 0;
+			do
+			{
+				o.tpNext += o.tInterval;
+
+				if (m_oSettings.fAcceleration != 1.0f)
+				{
+					o.tInterval = std::chrono::duration_cast<Clock::duration>(
+						o.tInterval * double(m_oSettings.fAcceleration));
+				}
+				if (o.tInterval < m_oSettings.tMinInterval)
+					o.tInterval = m_oSettings.tMinInterval;
+				if (o.tInterval <= Clock::duration::zero())
+					o.tInterval = Clock::duration(1);
+
+			} while (o.tpNext <= tpNow && ++iSteps < 64);
+
+			// after long stalls, skip the remaining repeats at the current interval
+			if (o.tpNext <= tpNow)
+				o.tpNext += ((tpNow - o.tpNext) / o.tInterval + 1) * o.tInterval;
+		}
+	}
+
+}
@@ -1,4 +1,8 @@
 #include <rlInput/Keyboard.hpp>
+#include <rlInput/Trace.hpp>
+
+// STL
+#include <bit>
 
 namespace rlInput
 {
@@ -12,28 +16,47 @@ namespace rlInput
 		oDest.clear();
 		for (unsigned i = 0; i < 256; ++i)
 		{
-			if (m_upStates[i].bPressed)
+			if (m_oStates[i].bPressed)
 				oDest.push_back(i);
 		}
 	}
 
+	size_t Keyboard::pressedKeys(unsigned char *pDest, size_t iDestSize) const noexcept
+	{
+		size_t iCount = 0;
+		for (unsigned i = 0; i < 256 && iCount < iDestSize; ++i)
+		{
+			if (m_oStates[i].bPressed)
+				pDest[iCount++] = (unsigned char)i;
+		}
+		return iCount;
+	}
+
 	Keyboard::ModKeys Keyboard::modifierKeys() const noexcept
 	{
 		return ModKeys(
-			(m_upStates[VK_MENU   ].bDown ? ModKey_Alt     : 0) |
-			(m_upStates[VK_CONTROL].bDown ? ModKey_Control : 0) |
-			(m_upStates[VK_SHIFT  ].bDown ? ModKey_Shift   : 0)
+			(m_oStates[VK_MENU   ].bDown ? ModKey_Alt     : 0) |
+			(m_oStates[VK_CONTROL].bDown ? ModKey_Control : 0) |
+			(m_oStates[VK_SHIFT  ].bDown ? ModKey_Shift   : 0)
 		);
 	}
 
-	Keyboard::Keyboard()
+	Keyboard::Keyboard(std::pmr::memory_resource *pMemory) : m_pMemory(pMemory)
 	{
-		memset(m_upStates.get(), 0, sizeof(Key) * 256);
+		setTextCapacity(1024);
 	}
 
 	void Keyboard::prepare() noexcept
 	{
-		Key        *pDest   = m_upStates.get();
+		RLINPUT_TRACE_SCOPE("Keyboard::prepare");
+		StatsRecorder::PrepareScope oStatsScope(m_oStats);
+		WakeQueue oWake;
+		m_tpPrepared = Clock::now();
+
+		uint64_t iPressedMask[4]{};
+		uint64_t iReleasedMask[4]{};
+
+		Key        *pDest   = m_oStates;
 		const bool *pRawOld = m_oRawStates_Old;
 		const bool *pRawNew = m_oRawStates_New;
 
@@ -42,6 +65,27 @@ namespace rlInput
 			pDest->bPressed  =  *pRawNew && !*pRawOld;
 			pDest->bDown     =  *pRawNew;
 			pDest->bReleased = !*pRawNew &&  *pRawOld;
+			pDest->bRepeated = false;
+
+			iPressedMask[i / 64]  |= uint64_t(pDest->bPressed)  << (i % 64);
+			iReleasedMask[i / 64] |= uint64_t(pDest->bReleased) << (i % 64);
+
+			if (pDest->bPressed)
+			{
+				m_oTimes.setPressTime(i, m_oRawTimes[i]);
+				m_oRepeat.press(i, m_oRawTimes[i]);
+				m_oStats.recordLatency(m_oRawTimes[i], m_tpPrepared);
+				RLINPUT_TRACE_EVENT("Key pressed", i);
+				oWake.wake(m_oPressedWaiters[i]);
+			}
+			else if (pDest->bReleased)
+			{
+				m_oTimes.setReleaseTime(i, m_oRawTimes[i]);
+				m_oRepeat.release(i);
+				m_oStats.recordLatency(m_oRawTimes[i], m_tpPrepared);
+				RLINPUT_TRACE_EVENT("Key released", i);
+				oWake.wake(m_oReleasedWaiters[i]);
+			}
 
 			++pDest;
 			++pRawOld;
@@ -52,22 +96,102 @@ namespace rlInput
 			m_oRawStates_Old, sizeof(m_oRawStates_Old),
 			m_oRawStates_New, sizeof(m_oRawStates_New)
 		);
+
+		uint64_t iRepeatedMask[4]{};
+		m_oRepeat.advance(m_tpPrepared, iRepeatedMask);
+		for (size_t iWord = 0; iWord < 4; ++iWord)
+		{
+			for (uint64_t iBits = iRepeatedMask[iWord]; iBits; iBits &= iBits - 1)
+			{
+				m_oStates[iWord * 64 + std::countr_zero(iBits)].bRepeated = true;
+			}
+		}
+
+		for (size_t iSeat = 0; iSeat < m_oSeatMap.size(); ++iSeat)
+		{
+			auto &o = m_oSeats[iSeat];
+
+			o.m_bConnected = o.m_bRawConnected;
+			for (size_t iWord = 0; iWord < 4; ++iWord)
+			{
+				o.m_oPressed[iWord]  =  o.m_oRawDown[iWord] & ~o.m_oDown[iWord];
+				o.m_oReleased[iWord] = ~o.m_oRawDown[iWord] &  o.m_oDown[iWord];
+				o.m_oDown[iWord]     =  o.m_oRawDown[iWord];
+			}
+		}
+
+		if (m_oTextUTF16.markFrame())
+			m_oStats.count(&DeviceStats::Counters::iOverflows);
+		if (m_oTextUTF8.markFrame())
+			m_oStats.count(&DeviceStats::Counters::iOverflows);
+
+		m_oPressedCallbacks.dispatchMask(iPressedMask);
+		m_oReleasedCallbacks.dispatchMask(iReleasedMask);
 	}
 
 	bool Keyboard::update(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
+	{
+		RLINPUT_TRACE_SCOPE_ARG("Keyboard::update", uMsg);
+		const bool bHandled = processMessage(hWnd, uMsg, wParam, lParam);
+		m_oStats.countMessage(bHandled);
+		return bHandled;
+	}
+
+	bool Keyboard::processMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
 	{
 		switch (uMsg)
 		{
 		case WM_KEYDOWN:
-			m_oRawStates_New[wParam] = true;
+			if (m_bIgnoreAutoRepeat && (lParam & (1 << 30)))
+				return true; // previous key state was "down" --> OS autorepeat
+
+			if (!m_oRawStates_New[wParam])
+			{
+				m_oRawStates_New[wParam] = true;
+				m_oRawTimes[wParam]      = Clock::now();
+			}
 			return true;
 
 		case WM_KEYUP:
-			m_oRawStates_New[wParam] = false;
+			if (m_oRawStates_New[wParam])
+			{
+				m_oRawStates_New[wParam] = false;
+				m_oRawTimes[wParam]      = Clock::now();
+			}
 			return true;
 
 
 
+		case WM_INPUT:
+			processRawInput(HRAWINPUT(lParam));
+			break; // DefWindowProc must still be called for WM_INPUT
+
+		case WM_INPUT_DEVICE_CHANGE:
+		{
+			const auto hDevice = HANDLE(lParam);
+			size_t iSeat = m_oSeatMap.find(hDevice);
+			if (iSeat == m_oSeatMap.NoIndex && wParam == GIDC_ARRIVAL)
+			{
+				// new keyboards get a seat right away, so they can be enumerated before any input
+				if (IsRawInputDeviceType(hDevice, RIM_TYPEKEYBOARD))
+				{
+					iSeat = m_oSeatMap.insert(hDevice);
+					if (iSeat != m_oSeatMap.NoIndex)
+						m_oSeats[iSeat].m_hDevice = hDevice;
+				}
+			}
+			if (iSeat == m_oSeatMap.NoIndex)
+				break;
+
+			auto &oSeat = m_oSeats[iSeat];
+			oSeat.m_bRawConnected = wParam == GIDC_ARRIVAL;
+			if (!oSeat.m_bRawConnected)
+				memset(oSeat.m_oRawDown, 0, sizeof(oSeat.m_oRawDown));
+			break;
+		}
+
+
+
 		case WM_IME_STARTCOMPOSITION:
 			return true; // call to DefWndProc will lead to "Default IME Window" popping up
 
@@ -87,14 +211,14 @@ namespace rlInput
 
 			if (!m_bRecordText)
 			{
-				if (!m_sRecordedText.empty() && IS_HIGH_SURROGATE(*m_sRecordedText.end()))
+				// recording was stopped --> only complete a pending surrogate pair
+				if (m_cHighSurrogate && IS_LOW_SURROGATE(wParam))
 				{
-					if (IS_LOW_SURROGATE(wParam))
-						m_sRecordedText += (wchar_t)wParam;
-					else
-						m_sRecordedText.pop_back();
+					recordCodePoint(0x10000 + ((char32_t(m_cHighSurrogate) - 0xD800) << 10) +
+						(char32_t(wParam) - 0xDC00));
 				}
 
+				m_cHighSurrogate    = 0;
 				m_bRecordingStopped = true;
 				break;
 			}
@@ -104,10 +228,10 @@ namespace rlInput
 				switch (wParam)
 				{
 				case VK_RETURN:
-					m_sRecordedText += '\n';
+					recordCodePoint(U'\n');
 					break;
 				case VK_TAB:
-					m_sRecordedText += '\t';
+					recordCodePoint(U'\t');
 					break;
 				}
 
@@ -117,9 +241,23 @@ namespace rlInput
 			if (m_oRawStates_New[VK_MENU] || m_oRawStates_New[VK_CONTROL])
 				break; // Control key/Alt/Ctrl keypresses are ignored
 
-			if (!IS_LOW_SURROGATE(wParam) ||
-				(m_sRecordedText.length() > 0 && IS_HIGH_SURROGATE(*m_sRecordedText.rbegin())))
-				m_sRecordedText += (wchar_t)wParam;
+			if (IS_HIGH_SURROGATE(wParam))
+				m_cHighSurrogate = (wchar_t)wParam;
+			else if (IS_LOW_SURROGATE(wParam))
+			{
+				// lone low surrogates are dropped
+				if (m_cHighSurrogate)
+				{
+					recordCodePoint(0x10000 + ((char32_t(m_cHighSurrogate) - 0xD800) << 10) +
+						(char32_t(wParam) - 0xDC00));
+				}
+				m_cHighSurrogate = 0;
+			}
+			else
+			{
+				m_cHighSurrogate = 0; // lone high surrogates are dropped
+				recordCodePoint(char32_t(wParam));
+			}
 
 			break;
 		}
@@ -133,6 +271,114 @@ namespace rlInput
 	{
 		memset(m_oRawStates_Old, 0, sizeof(m_oRawStates_Old));
 		memset(m_oRawStates_New, 0, sizeof(m_oRawStates_New));
+		m_oRepeat.reset();
+
+		for (auto &o : m_oSeats)
+		{
+			memset(o.m_oRawDown, 0, sizeof(o.m_oRawDown));
+			memset(o.m_oDown,    0, sizeof(o.m_oDown));
+		}
+	}
+
+	void Keyboard::setTextCapacity(size_t iUTF16Capacity, size_t iUTF8Capacity)
+	{
+		m_oTextUTF16.setCapacity(iUTF16Capacity);
+		m_oTextUTF8.setCapacity(iUTF8Capacity);
+	}
+
+	void Keyboard::recordCodePoint(char32_t cCodePoint) noexcept
+	{
+		m_oStats.count(&DeviceStats::Counters::iTextCharacters);
+
+		// UTF-16
+		if (cCodePoint < 0x10000)
+		{
+			const wchar_t c = wchar_t(cCodePoint);
+			m_oTextUTF16.append(&c, 1);
+		}
+		else
+		{
+			const wchar_t sz[] =
+			{
+				wchar_t(0xD800 + ((cCodePoint - 0x10000) >> 10)),
+				wchar_t(0xDC00 + ((cCodePoint - 0x10000) & 0x3FF))
+			};
+			m_oTextUTF16.append(sz, 2);
+		}
+
+		// UTF-8
+		if (m_oTextUTF8.capacity() == 0)
+			return;
+
+		char sz[4];
+		size_t iLen;
+		if (cCodePoint < 0x80)
+		{
+			sz[0] = char(cCodePoint);
+			iLen  = 1;
+		}
+		else if (cCodePoint < 0x800)
+		{
+			sz[0] = char(0xC0 | (cCodePoint >> 6));
+			sz[1] = char(0x80 | (cCodePoint & 0x3F));
+			iLen  = 2;
+		}
+		else if (cCodePoint < 0x10000)
+		{
+			sz[0] = char(0xE0 | (cCodePoint >> 12));
+			sz[1] = char(0x80 | ((cCodePoint >> 6) & 0x3F));
+			sz[2] = char(0x80 | (cCodePoint & 0x3F));
+			iLen  = 3;
+		}
+		else
+		{
+			sz[0] = char(0xF0 | (cCodePoint >> 18));
+			sz[1] = char(0x80 | ((cCodePoint >> 12) & 0x3F));
+			sz[2] = char(0x80 | ((cCodePoint >> 6) & 0x3F));
+			sz[3] = char(0x80 | (cCodePoint & 0x3F));
+			iLen  = 4;
+		}
+		m_oTextUTF8.append(sz, iLen);
+	}
+
+	bool Keyboard::enableRawInput(HWND hWnd, bool bBackground) noexcept
+	{
+		RAWINPUTDEVICE oDevice{};
+		oDevice.usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC
+		oDevice.usUsage     = 0x06; // HID_USAGE_GENERIC_KEYBOARD
+		oDevice.dwFlags     = RIDEV_DEVNOTIFY | (bBackground ? RIDEV_INPUTSINK : 0);
+		oDevice.hwndTarget  = hWnd;
+
+		return RegisterRawInputDevices(&oDevice, 1, sizeof(oDevice));
+	}
+
+	void Keyboard::processRawInput(HRAWINPUT hRawInput) noexcept
+	{
+		// keyboard data always fits into a RAWINPUT struct --> no allocation required
+		RAWINPUT oInput;
+		UINT iSize = sizeof(oInput);
+		if (GetRawInputData(hRawInput, RID_INPUT, &oInput, &iSize, sizeof(RAWINPUTHEADER)) ==
+			UINT(-1) || oInput.header.dwType != RIM_TYPEKEYBOARD)
+			return;
+
+		const auto &oKeyboard = oInput.data.keyboard;
+		if (oKeyboard.VKey == 0 || oKeyboard.VKey >= 0xFF)
+			return; // fake key (e.g. part of an escape sequence)
+
+		const size_t iSeat = m_oSeatMap.insert(oInput.header.hDevice);
+		if (iSeat == m_oSeatMap.NoIndex)
+			return; // too many keyboards
+
+		auto &oSeat = m_oSeats[iSeat];
+		oSeat.m_hDevice       = oInput.header.hDevice;
+		oSeat.m_bRawConnected = true;
+
+		const auto iWord = oKeyboard.VKey / 64;
+		const auto iBit  = uint64_t(1) << (oKeyboard.VKey % 64);
+		if (oKeyboard.Flags & RI_KEY_BREAK)
+			oSeat.m_oRawDown[iWord] &= ~iBit;
+		else
+			oSeat.m_oRawDown[iWord] |= iBit;
 	}
 
 }
@@ -1,4 +1,5 @@
 #include <rlInput/Mouse.hpp>
+#include <rlInput/Trace.hpp>
 
 // Win32
 #include <windowsx.h>
@@ -6,21 +7,21 @@
 namespace rlInput
 {
 
-	namespace
-	{
-		constexpr size_t iRL_MOUSE_L = 0;
-		constexpr size_t iRL_MOUSE_R = 1;
-		constexpr size_t iRL_MOUSE_M = 2;
-	}
-
-
-
 	Mouse Mouse::s_oInstance;
 
 
 
 	void Mouse::prepare() noexcept
 	{
+		RLINPUT_TRACE_SCOPE("Mouse::prepare");
+		StatsRecorder::PrepareScope oStatsScope(m_oStats);
+		WakeQueue oWake;
+		m_tpPrepared = Clock::now();
+
+		uint64_t iClickedMask       = 0;
+		uint64_t iDoubleClickedMask = 0;
+		uint64_t iReleasedMask      = 0;
+
 		Button *pDest     = m_oStates;
 		bool   *pRawOld   = m_oRawStates_Old;
 		bool   *pRawNew   = m_oRawStates_New;
@@ -33,34 +34,136 @@ namespace rlInput
 			pDest->bDown          =  *pRawNew;
 			pDest->bReleased      = !*pRawNew &&  *pRawOld;
 
+			iClickedMask       |= uint64_t(pDest->bClicked)       << i;
+			iDoubleClickedMask |= uint64_t(pDest->bDoubleClicked) << i;
+			iReleasedMask      |= uint64_t(pDest->bReleased)      << i;
+
+			if (pDest->bClicked)
+			{
+				m_oTimes.setPressTime(i, m_oRawTimes[i]);
+				m_oStats.recordLatency(m_oRawTimes[i], m_tpPrepared);
+				RLINPUT_TRACE_EVENT("Mouse button clicked", i);
+				oWake.wake(m_oPressedWaiters[i]);
+			}
+			else if (pDest->bReleased)
+			{
+				m_oTimes.setReleaseTime(i, m_oRawTimes[i]);
+				m_oStats.recordLatency(m_oRawTimes[i], m_tpPrepared);
+				RLINPUT_TRACE_EVENT("Mouse button released", i);
+				oWake.wake(m_oReleasedWaiters[i]);
+			}
+
 			++pDest;
 			++pRawOld;
 			++pRawNew;
 			++pDblClick;
 		}
 
+		if (m_tpPendingMotion != Clock::time_point{})
+		{
+			m_oStats.recordLatency(m_tpPendingMotion, m_tpPrepared);
+			m_tpPendingMotion = {};
+		}
+
 		m_iCachedClientX       = m_iClientX;
 		m_iCachedClientY       = m_iClientY;
 		m_bCachedOnClient      = m_bOnClient;
 		m_iCachedWheelRotation = m_iWheelRotation;
 
+		sampleFilters(m_tpPrepared, false);
+		m_fCachedFilteredX     = m_fFilteredX;
+		m_fCachedFilteredY     = m_fFilteredY;
+		m_oCachedPredictors[0] = m_oPredictors[0];
+		m_oCachedPredictors[1] = m_oPredictors[1];
+
+		// Windows doesn't report that the cursor stopped --> no motion for longer than the
+		// prediction horizon means it rests (only the copies; the predictors keep their history)
+		if (m_tpPrepared - m_tpPredicted > prediction().tMaxHorizon)
+		{
+			m_oCachedPredictors[0].reset();
+			m_oCachedPredictors[0].update(m_fFilteredX, m_tpPrepared);
+			m_oCachedPredictors[1].reset();
+			m_oCachedPredictors[1].update(m_fFilteredY, m_tpPrepared);
+		}
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			const auto &o = m_oStates[i];
+			m_oGestures[i].advance(o.bClicked, o.bDown, o.bReleased,
+				m_iCachedClientX, m_iCachedClientY, m_tpPrepared);
+		}
+
+		m_dCachedDeltaX = double(m_iRawDeltaX) * m_dRawScale + m_dAbsoluteDeltaX;
+		m_dCachedDeltaY = double(m_iRawDeltaY) * m_dRawScale + m_dAbsoluteDeltaY;
+		m_iRawDeltaX      = 0;
+		m_iRawDeltaY      = 0;
+		m_dAbsoluteDeltaX = 0.0;
+		m_dAbsoluteDeltaY = 0.0;
+
+		for (size_t iSeat = 0; iSeat < m_oSeatMap.size(); ++iSeat)
+		{
+			auto &o = m_oSeats[iSeat];
+
+			o.m_bConnected = o.m_bRawConnected;
+			o.m_iPressed   = uint8_t( o.m_iRawDown & ~o.m_iDown);
+			o.m_iReleased  = uint8_t(~o.m_iRawDown &  o.m_iDown);
+			o.m_iDown      = o.m_iRawDown;
+
+			o.m_dDeltaX        = double(o.m_iRawDeltaX) * m_dRawScale + o.m_dAbsoluteDeltaX;
+			o.m_dDeltaY        = double(o.m_iRawDeltaY) * m_dRawScale + o.m_dAbsoluteDeltaY;
+			o.m_iWheelRotation = o.m_iRawWheel;
+
+			o.m_iRawDeltaX      = 0;
+			o.m_iRawDeltaY      = 0;
+			o.m_dAbsoluteDeltaX = 0.0;
+			o.m_dAbsoluteDeltaY = 0.0;
+			o.m_iRawWheel       = 0;
+		}
+
+		m_oPath.swap(m_oCachedPath); // both keep their capacity
+		m_oPath.clear();
+
 		memcpy_s(
 			m_oRawStates_Old, sizeof(m_oRawStates_Old),
 			m_oRawStates_New, sizeof(m_oRawStates_New)
 		);
 		memset(m_oDoubleClicked, 0, sizeof(m_oDoubleClicked));
 		m_iWheelRotation = 0;
+
+		m_oClickedCallbacks.dispatchMask(&iClickedMask);
+		m_oDoubleClickedCallbacks.dispatchMask(&iDoubleClickedMask);
+		m_oReleasedCallbacks.dispatchMask(&iReleasedMask);
+		if (m_iCachedWheelRotation != 0)
+			m_oWheelCallbacks.dispatch(0);
 	}
 
 	bool Mouse::update(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
+	{
+		RLINPUT_TRACE_SCOPE_ARG("Mouse::update", uMsg);
+		const bool bHandled = processMessage(hWnd, uMsg, wParam, lParam);
+		m_oStats.countMessage(bHandled);
+		return bHandled;
+	}
+
+	bool Mouse::processMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) noexcept
 	{
 		switch (uMsg)
 		{
 		case WM_MOUSEMOVE:
+			if constexpr (StatsRecorder::Enabled)
+			{
+				if (m_tpPendingMotion == Clock::time_point{})
+					m_tpPendingMotion = Clock::now();
+			}
 			m_bOnClient = true;
 			m_iClientX  = GET_X_LPARAM(lParam);
 			m_iClientY  = GET_Y_LPARAM(lParam);
 
+			if (m_iPathCapacity > 0)
+				addPathPoint(m_iClientX, m_iClientY);
+			if (m_bFilterEnabled || m_oPredictors[0].settings().eMode != PredictionMode::None)
+				sampleFilters(Clock::now(), true);
+
 			if (!m_bTracking) // enable mouse tracking
 			{
 				TRACKMOUSEEVENT tme{};
@@ -86,56 +189,100 @@ namespace rlInput
 
 			// left
 		case WM_LBUTTONDOWN:
-			m_oRawStates_New[iRL_MOUSE_L] = true;
+			m_oRawStates_New[MOUSE_BUTTON_LEFT] = true;
+			m_oRawTimes[MOUSE_BUTTON_LEFT]      = Clock::now();
 			beginCapture(hWnd);
 			return true;
 		case WM_LBUTTONUP:
-			m_oRawStates_New[iRL_MOUSE_L] = false;
+			m_oRawStates_New[MOUSE_BUTTON_LEFT] = false;
+			m_oRawTimes[MOUSE_BUTTON_LEFT]      = Clock::now();
 			endCapture();
 			return true;
 		case WM_LBUTTONDBLCLK:
-			m_oDoubleClicked[iRL_MOUSE_L] = true;
+			m_oDoubleClicked[MOUSE_BUTTON_LEFT] = true;
 			return true;
 
 
 
 			// right
 		case WM_RBUTTONDOWN:
-			m_oRawStates_New[iRL_MOUSE_R] = true;
+			m_oRawStates_New[MOUSE_BUTTON_RIGHT] = true;
+			m_oRawTimes[MOUSE_BUTTON_RIGHT]      = Clock::now();
 			beginCapture(hWnd);
 			return true;
 		case WM_RBUTTONUP:
-			m_oRawStates_New[iRL_MOUSE_R] = false;
+			m_oRawStates_New[MOUSE_BUTTON_RIGHT] = false;
+			m_oRawTimes[MOUSE_BUTTON_RIGHT]      = Clock::now();
 			endCapture();
 			return true;
 		case WM_RBUTTONDBLCLK:
-			m_oDoubleClicked[iRL_MOUSE_R] = true;
+			m_oDoubleClicked[MOUSE_BUTTON_RIGHT] = true;
 			return true;
 
 
 
 			// middle
 		case WM_MBUTTONDOWN:
-			m_oRawStates_New[iRL_MOUSE_M] = true;
+			m_oRawStates_New[MOUSE_BUTTON_MIDDLE] = true;
+			m_oRawTimes[MOUSE_BUTTON_MIDDLE]      = Clock::now();
 			beginCapture(hWnd);
 			return true;
 		case WM_MBUTTONUP:
-			m_oRawStates_New[iRL_MOUSE_M] = false;
+			m_oRawStates_New[MOUSE_BUTTON_MIDDLE] = false;
+			m_oRawTimes[MOUSE_BUTTON_MIDDLE]      = Clock::now();
 			endCapture();
 			return true;
 		case WM_MBUTTONDBLCLK:
-			m_oDoubleClicked[iRL_MOUSE_M] = true;
+			m_oDoubleClicked[MOUSE_BUTTON_MIDDLE] = true;
 			return true;
 
 
 
 			// wheel
 		case WM_MOUSEWHEEL:
+			if constexpr (StatsRecorder::Enabled)
+			{
+				if (m_tpPendingMotion == Clock::time_point{})
+					m_tpPendingMotion = Clock::now();
+			}
 			m_iWheelRotation += GET_WHEEL_DELTA_WPARAM(wParam);
 			return true;
 
 
 
+		case WM_INPUT:
+			processRawInput(HRAWINPUT(lParam));
+			break; // DefWindowProc must still be called for WM_INPUT
+
+
+
+		case WM_INPUT_DEVICE_CHANGE:
+		{
+			const auto hDevice = HANDLE(lParam);
+			size_t iSeat = m_oSeatMap.find(hDevice);
+			if (iSeat == m_oSeatMap.NoIndex && wParam == GIDC_ARRIVAL &&
+				IsRawInputDeviceType(hDevice, RIM_TYPEMOUSE))
+			{
+				// new mice get a seat right away, so they can be enumerated before any input
+				iSeat = m_oSeatMap.insert(hDevice);
+				if (iSeat != m_oSeatMap.NoIndex)
+					m_oSeats[iSeat].m_hDevice = hDevice;
+			}
+			if (iSeat == m_oSeatMap.NoIndex)
+				break;
+
+			auto &oSeat = m_oSeats[iSeat];
+			oSeat.m_bRawConnected = wParam == GIDC_ARRIVAL;
+			if (!oSeat.m_bRawConnected)
+			{
+				oSeat.m_iRawDown     = 0;
+				oSeat.m_bHasAbsolute = false;
+			}
+			break;
+		}
+
+
+
 		case WM_KILLFOCUS:
 			reset();
 			break;
@@ -150,6 +297,227 @@ namespace rlInput
 	{
 		memset(m_oRawStates_Old, 0, sizeof(m_oRawStates_Old));
 		memset(m_oRawStates_New, 0, sizeof(m_oRawStates_New));
+
+		m_iRawDeltaX      = 0;
+		m_iRawDeltaY      = 0;
+		m_dAbsoluteDeltaX = 0.0;
+		m_dAbsoluteDeltaY = 0.0;
+		m_bHasAbsolute    = false;
+		m_tpPendingMotion = {};
+
+		for (auto &o : m_oSeats)
+		{
+			o.m_iRawDown        = 0;
+			o.m_iDown           = 0;
+			o.m_iRawDeltaX      = 0;
+			o.m_iRawDeltaY      = 0;
+			o.m_dAbsoluteDeltaX = 0.0;
+			o.m_dAbsoluteDeltaY = 0.0;
+			o.m_bHasAbsolute    = false;
+			o.m_iRawWheel       = 0;
+		}
+
+		for (auto &o : m_oGestures)
+		{
+			o.reset();
+		}
+		for (auto &o : m_oFilters)
+		{
+			o.reset();
+		}
+		for (auto &o : m_oPredictors)
+		{
+			o.reset();
+		}
+	}
+
+	void Mouse::setGestureSettings(const GestureSettings &oSettings) noexcept
+	{
+		for (auto &o : m_oGestures)
+		{
+			o.setSettings(oSettings);
+		}
+	}
+
+	void Mouse::setPositionFilter(bool bEnabled, const OneEuroFilter::Settings &oSettings) noexcept
+	{
+		m_bFilterEnabled = bEnabled;
+
+		for (auto &o : m_oFilters)
+		{
+			o.setSettings(oSettings);
+			o.reset();
+		}
+	}
+
+	void Mouse::setPrediction(const MotionPredictor::Settings &oSettings) noexcept
+	{
+		for (auto &o : m_oPredictors)
+		{
+			o.setSettings(oSettings);
+		}
+	}
+
+	void Mouse::sampleFilters(Clock::time_point tpTime, bool bMotion) noexcept
+	{
+		const float fDeltaTime = std::chrono::duration<float>(tpTime - m_tpFiltered).count();
+		m_tpFiltered = tpTime;
+
+		if (m_bFilterEnabled)
+		{
+			m_fFilteredX = m_oFilters[0].filter(float(m_iClientX), fDeltaTime);
+			m_fFilteredY = m_oFilters[1].filter(float(m_iClientY), fDeltaTime);
+		}
+		else
+		{
+			m_fFilteredX = float(m_iClientX);
+			m_fFilteredY = float(m_iClientY);
+		}
+
+		if (!bMotion)
+			return;
+
+		m_tpPredicted = tpTime;
+		m_oPredictors[0].update(m_fFilteredX, tpTime);
+		m_oPredictors[1].update(m_fFilteredY, tpTime);
+	}
+
+	void Mouse::setPathHistory(size_t iCapacity, PathDecimation eDecimation)
+	{
+		if (iCapacity == 1)
+			iCapacity = 2; // halving requires at least two points
+
+		m_oPath.clear();
+		m_oCachedPath.clear();
+		m_oPath.shrink_to_fit();
+		m_oCachedPath.shrink_to_fit();
+
+		m_oPath.reserve(iCapacity);
+		m_oCachedPath.reserve(iCapacity);
+
+		m_iPathCapacity   = iCapacity;
+		m_ePathDecimation = eDecimation;
+	}
+
+	bool Mouse::enableRawInput(HWND hWnd, bool bBackground) noexcept
+	{
+		RAWINPUTDEVICE oDevice{};
+		oDevice.usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC
+		oDevice.usUsage     = 0x02; // HID_USAGE_GENERIC_MOUSE
+		oDevice.dwFlags     = RIDEV_DEVNOTIFY | (bBackground ? RIDEV_INPUTSINK : 0);
+		oDevice.hwndTarget  = hWnd;
+
+		return RegisterRawInputDevices(&oDevice, 1, sizeof(oDevice));
+	}
+
+	void Mouse::addPathPoint(int iX, int iY) noexcept
+	{
+		const PathPoint oPoint = { iX, iY, Clock::now() };
+
+		if (m_oPath.size() < m_iPathCapacity)
+		{
+			m_oPath.push_back(oPoint); // capacity was reserved --> never allocates
+			return;
+		}
+
+		m_oStats.count(&DeviceStats::Counters::iOverflows);
+
+		switch (m_ePathDecimation)
+		{
+		case PathDecimation::Halve:
+		{
+			// keep every second point, starting with the first one, then add the new one
+			const size_t iCount = m_oPath.size();
+			size_t iDest = 0;
+			for (size_t iSrc = 0; iSrc < iCount; iSrc += 2)
+			{
+				m_oPath[iDest++] = m_oPath[iSrc];
+			}
+			m_oPath.resize(iDest);
+			m_oPath.push_back(oPoint);
+			break;
+		}
+
+		case PathDecimation::ReplaceLast:
+			m_oPath.back() = oPoint;
+			break;
+		}
+	}
+
+	void Mouse::processRawInput(HRAWINPUT hRawInput) noexcept
+	{
+		// mouse data always fits into a RAWINPUT struct --> no allocation required
+		RAWINPUT oInput;
+		UINT iSize = sizeof(oInput);
+		if (GetRawInputData(hRawInput, RID_INPUT, &oInput, &iSize, sizeof(RAWINPUTHEADER)) ==
+			UINT(-1) || oInput.header.dwType != RIM_TYPEMOUSE)
+			return;
+
+		const auto &oMouse = oInput.data.mouse;
+
+		Seat *pSeat = nullptr;
+		const size_t iSeat = m_oSeatMap.insert(oInput.header.hDevice);
+		if (iSeat != m_oSeatMap.NoIndex) // otherwise: too many mice --> only the merged state
+		{
+			pSeat = m_oSeats + iSeat;
+			pSeat->m_hDevice       = oInput.header.hDevice;
+			pSeat->m_bRawConnected = true;
+
+			// RI_MOUSE_BUTTON_1_DOWN = 0x01, RI_MOUSE_BUTTON_1_UP = 0x02, ..._2_DOWN = 0x04, ...
+			for (unsigned i = 0; i < 5; ++i)
+			{
+				if (oMouse.usButtonFlags & (1 << (2 * i)))
+					pSeat->m_iRawDown |= uint8_t(1 << i);
+				else if (oMouse.usButtonFlags & (1 << (2 * i + 1)))
+					pSeat->m_iRawDown &= uint8_t(~(1 << i));
+			}
+
+			if (oMouse.usButtonFlags & RI_MOUSE_WHEEL)
+				pSeat->m_iRawWheel += SHORT(oMouse.usButtonData);
+		}
+
+		if ((oMouse.usFlags & MOUSE_MOVE_ABSOLUTE) == 0)
+		{
+			m_iRawDeltaX += oMouse.lLastX;
+			m_iRawDeltaY += oMouse.lLastY;
+			if (pSeat)
+			{
+				pSeat->m_iRawDeltaX += oMouse.lLastX;
+				pSeat->m_iRawDeltaY += oMouse.lLastY;
+			}
+			return;
+		}
+
+		// absolute coordinates are normalized to [0, 65535]
+		const bool bVirtualDesktop = oMouse.usFlags & MOUSE_VIRTUAL_DESKTOP;
+		const double dWidth  =
+			GetSystemMetrics(bVirtualDesktop ? SM_CXVIRTUALSCREEN : SM_CXSCREEN);
+		const double dHeight =
+			GetSystemMetrics(bVirtualDesktop ? SM_CYVIRTUALSCREEN : SM_CYSCREEN);
+
+		const double dX = oMouse.lLastX / 65535.0 * dWidth;
+		const double dY = oMouse.lLastY / 65535.0 * dHeight;
+
+		if (m_bHasAbsolute)
+		{
+			m_dAbsoluteDeltaX += dX - m_dLastAbsoluteX;
+			m_dAbsoluteDeltaY += dY - m_dLastAbsoluteY;
+		}
+		m_dLastAbsoluteX = dX;
+		m_dLastAbsoluteY = dY;
+		m_bHasAbsolute   = true;
+
+		if (!pSeat)
+			return;
+
+		if (pSeat->m_bHasAbsolute)
+		{
+			pSeat->m_dAbsoluteDeltaX += dX - pSeat->m_dLastAbsoluteX;
+			pSeat->m_dAbsoluteDeltaY += dY - pSeat->m_dLastAbsoluteY;
+		}
+		pSeat->m_dLastAbsoluteX = dX;
+		pSeat->m_dLastAbsoluteY = dY;
+		pSeat->m_bHasAbsolute   = true;
 	}
 
 	void Mouse::beginCapture(HWND hWnd)
@@ -0,0 +1,152 @@
+#include <rlInput/SharedInput.hpp>
+
+// STL
+#include <atomic>
+#include <cstring>
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		constexpr uint32_t Magic     = 0x49536C72; // "rlSI"
+		constexpr size_t   WordCount = (sizeof(SharedInputState) + 7) / 8;
+
+		// Magic in the lower half, the size of the state in the upper half
+		constexpr uint64_t BlockID = uint64_t(sizeof(SharedInputState)) << 32 | Magic;
+
+		using AtomicWord = std::atomic_ref<uint64_t>;
+
+	}
+
+	/// <summary>
+	/// The contents of the shared memory segment.<para/>
+	/// Freshly created segments are zeroed by the OS. All fields are accessed via
+	/// <c>std::atomic_ref</c>, as other processes access them concurrently.
+	/// </summary>
+	struct SharedInputBlock
+	{
+		uint64_t iMagic;            // BlockID
+		uint64_t iSequence;         // odd while the publisher is writing
+		uint64_t oWords[WordCount]; // the SharedInputState
+	};
+
+
+
+
+
+	InputPublisher::InputPublisher(const wchar_t *szName)
+	{
+		m_hMapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+			DWORD(sizeof(SharedInputBlock)), szName);
+		if (!m_hMapping)
+			throw std::exception("InputPublisher: Call to CreateFileMapping failed");
+
+		m_pBlock = static_cast<SharedInputBlock *>(
+			MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedInputBlock)));
+		if (!m_pBlock)
+		{
+			CloseHandle(m_hMapping);
+			throw std::exception("InputPublisher: Call to MapViewOfFile failed");
+		}
+
+		// a segment kept alive by readers may be reused by a new publisher
+		AtomicWord aSequence(m_pBlock->iSequence);
+		const uint64_t iSequence = aSequence.load(std::memory_order_relaxed);
+		if (iSequence & 1)
+			aSequence.store(iSequence + 1, std::memory_order_relaxed); // previous publisher died
+		m_iFrame = (iSequence + 1) / 2;
+
+		AtomicWord(m_pBlock->iMagic).store(BlockID, std::memory_order_release);
+	}
+
+	InputPublisher::~InputPublisher()
+	{
+		UnmapViewOfFile(m_pBlock);
+		CloseHandle(m_hMapping);
+	}
+
+	void InputPublisher::publish(const SharedInputState &oState) noexcept
+	{
+		SharedInputState oCopy = oState;
+		oCopy.iFrame      = ++m_iFrame;
+		oCopy.tpPublished = Clock::now();
+
+		uint64_t oWords[WordCount]{};
+		memcpy(oWords, &oCopy, sizeof(oCopy));
+
+		AtomicWord aSequence(m_pBlock->iSequence);
+		const uint64_t iSequence = aSequence.load(std::memory_order_relaxed);
+		aSequence.store(iSequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release); // odd before the data
+
+		for (size_t i = 0; i < WordCount; ++i)
+		{
+			AtomicWord(m_pBlock->oWords[i]).store(oWords[i], std::memory_order_relaxed);
+		}
+
+		aSequence.store(iSequence + 2, std::memory_order_release);
+	}
+
+
+
+	InputReader::InputReader(const wchar_t *szName)
+	{
+		m_hMapping = OpenFileMappingW(FILE_MAP_READ, FALSE, szName);
+		if (!m_hMapping)
+			throw std::exception("InputReader: No InputPublisher with this name");
+
+		m_pBlock = static_cast<SharedInputBlock *>(
+			MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, sizeof(SharedInputBlock)));
+		if (!m_pBlock)
+		{
+			CloseHandle(m_hMapping);
+			throw std::exception("InputReader: Call to MapViewOfFile failed");
+		}
+	}
+
+	InputReader::~InputReader()
+	{
+		UnmapViewOfFile(m_pBlock);
+		CloseHandle(m_hMapping);
+	}
+
+	bool InputReader::read(SharedInputState &oDest, unsigned iMaxAttempts) const noexcept
+	{
+		// not initialized yet, or a publisher built with another version of the library
+		if (AtomicWord(m_pBlock->iMagic).load(std::memory_order_acquire) != BlockID)
+			return false;
+
+		AtomicWord aSequence(m_pBlock->iSequence);
+		for (unsigned iAttempt = 0; iAttempt < iMaxAttempts; ++iAttempt)
+		{
+			const uint64_t iBefore = aSequence.load(std::memory_order_acquire);
+			if (iBefore == 0)
+				return false; // nothing published yet
+			if (iBefore & 1)
+				continue; // being written
+
+			uint64_t oWords[WordCount];
+			for (size_t i = 0; i < WordCount; ++i)
+			{
+				oWords[i] = AtomicWord(m_pBlock->oWords[i]).load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire); // the data before the check
+			if (aSequence.load(std::memory_order_relaxed) != iBefore)
+				continue; // written meanwhile
+
+			memcpy(&oDest, oWords, sizeof(oDest));
+			return true;
+		}
+
+		return false;
+	}
+
+	uint64_t InputReader::frame() const noexcept
+	{
+		return AtomicWord(m_pBlock->iSequence).load(std::memory_order_relaxed) / 2;
+	}
+
+}
@@ -0,0 +1,319 @@
+#include <rlInput/Trace.hpp>
+
+// STL
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Win32
+#define WIN32_MEAN_AND_LEAN
+#define NOMINMAX
+#include <Windows.h>
+#undef WIN32_MEAN_AND_LEAN
+#undef NOMINMAX
+
+namespace rlInput
+{
+
+	namespace
+	{
+
+		struct TraceEvent
+		{
+			const char *szName;
+			uint64_t iBegin;    // nanoseconds
+			uint64_t iDuration; // nanoseconds
+			uint64_t iArg;
+			char cPhase;        // 'X' = span, 'i' = instant
+		};
+
+		/// <summary>
+		/// Single producer (the owning thread), single consumer (the flush thread) ring.
+		/// </summary>
+		class ThreadRing final
+		{
+		public: // static variables
+
+			static constexpr size_t Capacity = 4096;
+
+
+		public: // methods
+
+			explicit ThreadRing(DWORD dwThreadID) noexcept : m_dwThreadID(dwThreadID) {}
+
+			DWORD threadID() const noexcept { return m_dwThreadID; }
+
+			void push(const TraceEvent &oEvent) noexcept
+			{
+				const size_t iHead = m_iHead.load(std::memory_order_relaxed);
+				if (iHead - m_iTail.load(std::memory_order_acquire) == Capacity)
+				{
+					m_iDropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+
+				m_oEvents[iHead % Capacity] = oEvent;
+				m_iHead.store(iHead + 1, std::memory_order_release);
+			}
+
+			template <typename TFn>
+			void drain(TFn &&fn)
+			{
+				const size_t iHead = m_iHead.load(std::memory_order_acquire);
+				size_t iTail = m_iTail.load(std::memory_order_relaxed);
+				for (; iTail != iHead; ++iTail)
+				{
+					fn(m_oEvents[iTail % Capacity]);
+				}
+				m_iTail.store(iTail, std::memory_order_release);
+			}
+
+			uint64_t takeDropped() noexcept
+			{
+				return m_iDropped.exchange(0, std::memory_order_relaxed);
+			}
+
+			bool empty() const noexcept
+			{
+				return m_iHead.load(std::memory_order_acquire) ==
+					m_iTail.load(std::memory_order_relaxed);
+			}
+
+
+		public: // variables
+
+			std::atomic<bool> bThreadExited = false;
+
+
+		private: // variables
+
+			const DWORD m_dwThreadID;
+			std::atomic<size_t> m_iHead = 0;
+			std::atomic<size_t> m_iTail = 0;
+			std::atomic<uint64_t> m_iDropped = 0;
+			TraceEvent m_oEvents[Capacity];
+
+		};
+
+
+
+		// the ring of the current thread; marks it as orphaned when the thread exits
+		struct ThreadSlot
+		{
+			std::shared_ptr<ThreadRing> spRing;
+
+			~ThreadSlot()
+			{
+				if (spRing)
+					spRing->bThreadExited = true;
+			}
+		};
+
+		thread_local ThreadSlot s_oThreadSlot;
+
+
+
+		std::mutex s_oControlMutex; // Start() and Stop()
+		std::mutex s_oRingsMutex;
+		std::vector<std::shared_ptr<ThreadRing>> s_oRings;
+
+		std::mutex s_oFlushMutex;
+		std::condition_variable s_oFlushCondition;
+		bool s_bStopFlushing = false;
+		std::thread s_oFlushThread;
+
+		FILE *s_pFile       = nullptr;
+		bool  s_bFirstEvent = true;
+		DWORD s_dwProcessID = 0;
+
+
+
+		constexpr auto FlushInterval = std::chrono::milliseconds(10);
+
+		uint64_t Nanoseconds(Clock::time_point tp) noexcept
+		{
+			using std::chrono::nanoseconds;
+			return uint64_t(std::chrono::duration_cast<nanoseconds>(tp.time_since_epoch()).count());
+		}
+
+		ThreadRing *CurrentRing() noexcept
+		{
+			if (!s_oThreadSlot.spRing)
+			{
+				// first event of this thread --> the only allocation
+				try
+				{
+					auto spRing = std::make_shared<ThreadRing>(GetCurrentThreadId());
+
+					std::lock_guard oLock(s_oRingsMutex);
+					s_oRings.push_back(spRing);
+					s_oThreadSlot.spRing = std::move(spRing);
+				}
+				catch (...)
+				{
+					return nullptr;
+				}
+			}
+
+			return s_oThreadSlot.spRing.get();
+		}
+
+		void WriteEvent(DWORD dwThreadID, const TraceEvent &oEvent)
+		{
+			fprintf(s_pFile,
+				"%s\n{\"name\":\"%s\",\"cat\":\"rlInput\",\"ph\":\"%c\",\"ts\":%llu.%03u,"
+				"\"pid\":%lu,\"tid\":%lu",
+				s_bFirstEvent ? "" : ",", oEvent.szName, oEvent.cPhase,
+				(unsigned long long)(oEvent.iBegin / 1000), unsigned(oEvent.iBegin % 1000),
+				(unsigned long)s_dwProcessID, (unsigned long)dwThreadID);
+			s_bFirstEvent = false;
+
+			if (oEvent.cPhase == 'X')
+			{
+				const uint64_t iDuration = oEvent.iDuration;
+				fprintf(s_pFile, ",\"dur\":%llu.%03u", (unsigned long long)(iDuration / 1000),
+					unsigned(iDuration % 1000));
+			}
+			else
+				fputs(",\"s\":\"t\"", s_pFile);
+
+			if (oEvent.iArg != Tracer::NoArg)
+				fprintf(s_pFile, ",\"args\":{\"value\":%llu}", (unsigned long long)oEvent.iArg);
+
+			fputc('}', s_pFile);
+		}
+
+		/// <summary>
+		/// Write the contents of all rings to the file and forget the rings of exited threads.
+		/// </summary>
+		void Flush(bool bWrite)
+		{
+			std::lock_guard oLock(s_oRingsMutex);
+
+			for (auto &sp : s_oRings)
+			{
+				const DWORD dwThreadID = sp->threadID();
+				sp->drain([&](const TraceEvent &oEvent)
+					{
+						if (bWrite)
+							WriteEvent(dwThreadID, oEvent);
+					});
+
+				const uint64_t iDropped = sp->takeDropped();
+				if (bWrite && iDropped)
+				{
+					WriteEvent(dwThreadID,
+						{ "rlInput: dropped events", Nanoseconds(Clock::now()), 0, iDropped, 'i' });
+				}
+			}
+
+			std::erase_if(s_oRings, [](const std::shared_ptr<ThreadRing> &sp)
+				{
+					return sp->bThreadExited && sp->empty();
+				});
+
+			if (bWrite)
+				fflush(s_pFile);
+		}
+
+		void FlushThreadProc()
+		{
+			std::unique_lock oLock(s_oFlushMutex);
+			while (!s_bStopFlushing)
+			{
+				s_oFlushCondition.wait_for(oLock, FlushInterval);
+
+				oLock.unlock();
+				Flush(true);
+				oLock.lock();
+			}
+		}
+
+	}
+
+
+
+
+
+	std::atomic<bool> Tracer::s_bActive = false;
+
+	bool Tracer::Start(const wchar_t *szPath) noexcept
+	{
+		std::lock_guard oLock(s_oControlMutex);
+		if (s_pFile)
+			return false;
+
+		if (_wfopen_s(&s_pFile, szPath, L"wb") != 0 || !s_pFile)
+		{
+			s_pFile = nullptr;
+			return false;
+		}
+
+		Flush(false); // discard events left over from a previous session
+		fputs("{\"traceEvents\":[", s_pFile);
+		s_bFirstEvent = true;
+		s_dwProcessID = GetCurrentProcessId();
+
+		s_bStopFlushing = false;
+		try
+		{
+			s_oFlushThread = std::thread(FlushThreadProc);
+		}
+		catch (...)
+		{
+			fclose(s_pFile);
+			s_pFile = nullptr;
+			return false;
+		}
+
+		s_bActive = true;
+		return true;
+	}
+
+	void Tracer::Stop() noexcept
+	{
+		std::lock_guard oLock(s_oControlMutex);
+		if (!s_pFile)
+			return;
+
+		s_bActive = false;
+
+		{
+			std::lock_guard oFlushLock(s_oFlushMutex);
+			s_bStopFlushing = true;
+		}
+		s_oFlushCondition.notify_one();
+		s_oFlushThread.join();
+
+		Flush(true);
+		fputs("\n]}\n", s_pFile);
+		fclose(s_pFile);
+		s_pFile = nullptr;
+	}
+
+	void Tracer::Span(const char *szName, Clock::time_point tpBegin, Clock::time_point tpEnd,
+		uint64_t iArg) noexcept
+	{
+		if (!Active())
+			return;
+
+		if (auto pRing = CurrentRing())
+		{
+			const uint64_t iBegin = Nanoseconds(tpBegin);
+			pRing->push({ szName, iBegin, Nanoseconds(tpEnd) - iBegin, iArg, 'X' });
+		}
+	}
+
+	void Tracer::Instant(const char *szName, uint64_t iArg) noexcept
+	{
+		if (!Active())
+			return;
+
+		if (auto pRing = CurrentRing())
+			pRing->push({ szName, Nanoseconds(Clock::now()), 0, iArg, 'i' });
+	}
+
+}
@@ -0,0 +1,148 @@
+#include <rlInput/WaitList.hpp>
+
+namespace rlInput
+{
+
+	namespace
+	{
+		// Sorted by deadline, ascending.
+		thread_local WaitList s_oTimers;
+	}
+
+
+
+	void WaitGroup::suspend(const Condition *pConditions) noexcept
+	{
+		iFired = 0;
+
+		for (size_t i = 0; i < iWaiterCount; ++i)
+		{
+			pWaiters[i].m_pGroup = this;
+
+			if (pConditions[i].pList)
+				pConditions[i].pList->push(pWaiters[i]);
+			else
+				WaitList::AddTimer(pWaiters[i], pConditions[i].tpDeadline);
+		}
+	}
+
+
+
+
+
+	void Waiter::unlink() noexcept
+	{
+		if (!m_pList)
+			return;
+
+		if (m_pPrev)
+			m_pPrev->m_pNext = m_pNext;
+		else
+			m_pList->m_pFirst = m_pNext;
+
+		if (m_pNext)
+			m_pNext->m_pPrev = m_pPrev;
+		else
+			m_pList->m_pLast = m_pPrev;
+
+		m_pPrev = nullptr;
+		m_pNext = nullptr;
+		m_pList = nullptr;
+	}
+
+
+
+
+
+	void WaitList::AddTimer(Waiter &oWaiter, Clock::time_point tpDeadline) noexcept
+	{
+		oWaiter.unlink();
+		oWaiter.m_tpDeadline = tpDeadline;
+
+		// search from the back, as new timers usually expire late
+		Waiter *pPrev = s_oTimers.m_pLast;
+		while (pPrev && pPrev->m_tpDeadline > tpDeadline)
+			pPrev = pPrev->m_pPrev;
+
+		Waiter *pNext = pPrev ? pPrev->m_pNext : s_oTimers.m_pFirst;
+
+		oWaiter.m_pPrev = pPrev;
+		oWaiter.m_pNext = pNext;
+		oWaiter.m_pList = &s_oTimers;
+
+		if (pPrev)
+			pPrev->m_pNext = &oWaiter;
+		else
+			s_oTimers.m_pFirst = &oWaiter;
+
+		if (pNext)
+			pNext->m_pPrev = &oWaiter;
+		else
+			s_oTimers.m_pLast = &oWaiter;
+	}
+
+	void WaitList::ExpireTimers(WaitList &oDest, Clock::time_point tpNow) noexcept
+	{
+		while (s_oTimers.m_pFirst && s_oTimers.m_pFirst->m_tpDeadline <= tpNow)
+		{
+			s_oTimers.wake(*s_oTimers.m_pFirst, oDest);
+		}
+	}
+
+	WaitList::~WaitList()
+	{
+		while (m_pFirst)
+			m_pFirst->unlink();
+	}
+
+	void WaitList::push(Waiter &oWaiter) noexcept
+	{
+		oWaiter.unlink();
+
+		oWaiter.m_pPrev = m_pLast;
+		oWaiter.m_pNext = nullptr;
+		oWaiter.m_pList = this;
+
+		if (m_pLast)
+			m_pLast->m_pNext = &oWaiter;
+		else
+			m_pFirst = &oWaiter;
+
+		m_pLast = &oWaiter;
+	}
+
+	void WaitList::notify(WaitList &oDest) noexcept
+	{
+		// wake() also unlinks the other waiters of the group, which might be part of this list
+		// --> always restart at the front.
+		while (m_pFirst)
+			wake(*m_pFirst, oDest);
+	}
+
+	void WaitList::resumeAll() noexcept
+	{
+		while (m_pFirst)
+		{
+			Waiter &oWaiter = *m_pFirst;
+			oWaiter.unlink();
+
+			// The waiter is part of the coroutine frame and can be destroyed by resume().
+			oWaiter.m_pGroup->hCoroutine.resume();
+		}
+	}
+
+	void WaitList::wake(Waiter &oWaiter, WaitList &oDest) noexcept
+	{
+		WaitGroup &oGroup = *oWaiter.m_pGroup;
+		oGroup.iFired = size_t(&oWaiter - oGroup.pWaiters);
+
+		for (size_t i = 0; i < oGroup.iWaiterCount; ++i)
+		{
+			if (&oGroup.pWaiters[i] != &oWaiter)
+				oGroup.pWaiters[i].unlink();
+		}
+
+		oDest.push(oWaiter);
+	}
+
+}
@@ -66,6 +66,7 @@ lbEnd:
 
 
 std::unique_ptr<rlInput::DirectInput::Gamepad> upGamepad = nullptr;
+rlInput::Keyboard::TextCursor iTextCursor = 0;
 
 void testInputs(HWND hWnd)
 {
@@ -143,13 +144,15 @@ void testInputs(HWND hWnd)
 			if (iModKeys & Keyboard::ModKey_Control)
 				sPressedKeys.insert(0, L"Control + ");
 
-			if (!keyboard.recordedText().empty())
+			wchar_t szText[256];
+			const size_t iTextLen = keyboard.readText(iTextCursor, szText, std::size(szText));
+			if (iTextLen > 0)
 			{
 				sPressedKeys += L"\nInput text: \"";
-				sPressedKeys += keyboard.recordedText();
+				sPressedKeys.append(szText, iTextLen);
 				sPressedKeys += L"\"";
 
-				keyboard.clearRecordedText();
+				iTextCursor = keyboard.textEnd(); // skip the rest of a very long text
 			}
 
 			MessageBoxW(NULL, sPressedKeys.c_str(), L"Key combination pressed",